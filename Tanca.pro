@@ -83,7 +83,28 @@ SOURCES += main.cpp MainWindow.cpp \
     SelectionWindow.cpp \
     ScoreWindow.cpp \
     Tournament.cpp \
-    Server.cpp
+    Server.cpp \
+    SearchIndex.cpp \
+    Exporter.cpp \
+    ChangeBus.cpp \
+    AsyncLog.cpp \
+    Profiler.cpp \
+    BatchRunner.cpp \
+    EventSnapshot.cpp \
+    RoundRobin.cpp \
+    EventWorkspace.cpp \
+    CourtAllocator.cpp \
+    DocumentField.cpp \
+    Brackets.cpp \
+    Ratings.cpp \
+    SeasonArchive.cpp \
+    BackupService.cpp \
+    ScoreLog.cpp \
+    PlayerStats.cpp \
+    CityDirectory.cpp \
+    DuplicateDetector.cpp \
+    LabelCache.cpp \
+    PlayerStore.cpp \
     tests/test_tournament.cpp
 
 HEADERS  += MainWindow.h \
@@ -99,7 +120,28 @@ HEADERS  += MainWindow.h \
     ScoreWindow.h \
     Tournament.h \
     Server.h \
-    IDataBase.h
+    IDataBase.h \
+    SearchIndex.h \
+    Exporter.h \
+    ChangeBus.h \
+    AsyncLog.h \
+    Profiler.h \
+    BatchRunner.h \
+    EventSnapshot.h \
+    RoundRobin.h \
+    EventWorkspace.h \
+    CourtAllocator.h \
+    DocumentField.h \
+    Brackets.h \
+    Ratings.h \
+    SeasonArchive.h \
+    BackupService.h \
+    ScoreLog.h \
+    PlayerStats.h \
+    CityDirectory.h \
+    DuplicateDetector.h \
+    LabelCache.h \
+    PlayerStore.h
 
 FORMS    += MainWindow.ui \
     PlayerWindow.ui \
@@ -113,4 +155,18 @@ OTHER_FILES += README.md LICENSE
 
 RESOURCES += assets/tanca.qrc
 
+# Postal codes compiled in the executable (see scripts/make_cities.py); built from
+# the La Poste file when it is placed in assets/
+exists($$BASE_DIR/assets/laposte_hexasmal.csv):!exists($$BASE_DIR/assets/cities.bin) {
+    system(python3 $$BASE_DIR/scripts/make_cities.py $$BASE_DIR/assets/laposte_hexasmal.csv $$BASE_DIR/assets/cities.bin)
+}
+
+exists($$BASE_DIR/assets/cities.bin) {
+    RESOURCES += assets/cities.qrc
+    # Stored as is, so that it is read in place
+    QMAKE_RESOURCE_FLAGS += --no-compress
+} else {
+    warning("assets/cities.bin not found: the cities will not be completed")
+}
+
 # End of project file
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+#
+# Tanca - build the postal code directory (cities.bin) read by CityDirectory
+#
+# Input: the postal code file of La Poste ("Base officielle des codes
+# postaux", CSV separated by semicolons, with a header line).
+#
+# Usage: python3 make_cities.py laposte_hexasmal.csv cities.bin
+#
+# qmake runs it when assets/laposte_hexasmal.csv exists, and compiles
+# assets/cities.bin in the executable. A cities.bin copied next to the
+# database (~/.tanca) or next to the executable replaces the compiled one.
+
+import struct
+import sys
+
+MAGIC = b'TCTY'
+FORMAT_VERSION = 1
+BYTE_ORDER = 0x01020304
+
+
+def read_rows(file_name):
+    with open(file_name, 'rb') as f:
+        data = f.read()
+    try:
+        text = data.decode('utf-8-sig')
+    except UnicodeDecodeError:
+        text = data.decode('latin-1')
+
+    lines = text.splitlines()
+    header = [h.strip().lstrip('#').lower() for h in lines[0].split(';')]
+    code_col = next(i for i, h in enumerate(header) if 'code_postal' in h)
+    name_col = next(i for i, h in enumerate(header) if h.startswith('nom'))
+
+    rows = set()
+    for line in lines[1:]:
+        fields = line.split(';')
+        if len(fields) <= max(code_col, name_col):
+            continue
+        code = fields[code_col].strip()
+        name = fields[name_col].strip()
+        if code.isdigit() and name:
+            rows.add((int(code), name))
+    return sorted(rows)
+
+
+def write_directory(file_name, rows):
+    pool = bytearray()
+    offsets = {}
+    names = []
+    for _, name in rows:
+        # Names shared by several codes are stored once
+        if name not in offsets:
+            offsets[name] = len(pool)
+            pool += name.encode('utf-8') + b'\0'
+        names.append(offsets[name])
+
+    with open(file_name, 'wb') as f:
+        f.write(MAGIC)
+        f.write(struct.pack('<5I', FORMAT_VERSION, BYTE_ORDER, len(rows), len(pool), 0))
+        f.write(struct.pack('<%di' % len(rows), *[code for code, _ in rows]))
+        f.write(struct.pack('<%dI' % len(rows), *names))
+        f.write(pool)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('Usage: make_cities.py <laposte.csv> <cities.bin>')
+    rows = read_rows(sys.argv[1])
+    write_directory(sys.argv[2], rows)
+    print('%d cities written to %s' % (len(rows), sys.argv[2]))
+
+
+if __name__ == '__main__':
+    main()
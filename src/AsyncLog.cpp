@@ -0,0 +1,215 @@
+/*=============================================================================
+ * Tanca - AsyncLog.cpp
+ *=============================================================================
+ * Non blocking log backend: lock-free ring buffer and background writer
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "AsyncLog.h"
+
+namespace
+{
+
+// Bounded queue with a sequence number per slot (D. Vyukov's design):
+// a slot is writable when its sequence equals the enqueue position,
+// readable when it equals the position + 1.
+// The sequence is stored relative to the slot index so that the zero
+// initialized array is ready to use, even before Start().
+struct Slot
+{
+    std::atomic<std::uint32_t> sequence; // relative to the slot index
+    int level;
+    std::uint32_t size;
+    char message[AsyncLog::cMessageSize];
+};
+
+Slot gSlots[AsyncLog::cCapacity];
+std::atomic<std::uint32_t> gEnqueuePos(0U);
+std::uint32_t gDequeuePos = 0U; // protected by gWriterMutex
+std::atomic<std::uint32_t> gDropped(0U);
+
+std::mutex gWriterMutex;
+std::mutex gWakeMutex;
+std::condition_variable gWake;
+std::thread gThread;
+bool gRunning = false;
+std::FILE *gOutput = stdout;
+
+const char *gLevelNames[] = { "[DEBUG] ", "[INFO] ", "[WARNING] ", "[ERROR] " };
+
+// Write all the pending messages, returns the number of lines written
+std::uint32_t Drain()
+{
+    std::lock_guard<std::mutex> lock(gWriterMutex);
+    std::uint32_t count = 0U;
+
+    for (;;)
+    {
+        std::uint32_t index = gDequeuePos & (AsyncLog::cCapacity - 1U);
+        Slot &slot = gSlots[index];
+        std::uint32_t seq = slot.sequence.load(std::memory_order_acquire) + index;
+
+        if (seq != (gDequeuePos + 1U))
+        {
+            break; // empty, or the producer has not finished its copy yet
+        }
+
+        int level = ((slot.level >= ALOG_LEVEL_DEBUG) && (slot.level <= ALOG_LEVEL_ERROR)) ? slot.level : ALOG_LEVEL_INFO;
+        std::fputs(gLevelNames[level], gOutput);
+        std::fwrite(slot.message, 1U, slot.size, gOutput);
+        std::fputc('\n', gOutput);
+
+        // Give the slot back to the producers, one lap later
+        slot.sequence.store(gDequeuePos + AsyncLog::cCapacity - index, std::memory_order_release);
+        gDequeuePos++;
+        count++;
+    }
+
+    if (count > 0U)
+    {
+        std::fflush(gOutput);
+    }
+    return count;
+}
+
+void Run()
+{
+    std::unique_lock<std::mutex> lock(gWakeMutex);
+
+    while (gRunning)
+    {
+        gWake.wait_for(lock, std::chrono::milliseconds(AsyncLog::cFlushPeriod));
+        lock.unlock();
+        (void) Drain();
+        lock.lock();
+    }
+}
+
+} // namespace
+
+const std::uint32_t AsyncLog::cCapacity;
+const std::uint32_t AsyncLog::cMessageSize;
+const int AsyncLog::cFlushPeriod;
+
+/*****************************************************************************/
+void AsyncLog::Start(std::FILE *output)
+{
+    std::lock_guard<std::mutex> lock(gWakeMutex);
+    if (!gRunning)
+    {
+        gOutput = output;
+        gRunning = true;
+        gThread = std::thread(Run);
+    }
+}
+
+void AsyncLog::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(gWakeMutex);
+        gRunning = false;
+    }
+    gWake.notify_one();
+
+    if (gThread.joinable())
+    {
+        gThread.join();
+    }
+
+    // Last messages
+    (void) Drain();
+}
+
+bool AsyncLog::Push(int level, const std::string &message)
+{
+    std::uint32_t pos = gEnqueuePos.load(std::memory_order_relaxed);
+    std::uint32_t index = 0U;
+    Slot *slot = nullptr;
+
+    for (;;)
+    {
+        index = pos & (cCapacity - 1U);
+        slot = &gSlots[index];
+        std::uint32_t seq = slot->sequence.load(std::memory_order_acquire) + index;
+        std::int32_t diff = static_cast<std::int32_t>(seq - pos);
+
+        if (diff == 0)
+        {
+            // Slot is free, try to reserve it
+            if (gEnqueuePos.compare_exchange_weak(pos, pos + 1U, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // Full: the writer is late, never wait for it
+            gDropped.fetch_add(1U, std::memory_order_relaxed);
+            return false;
+        }
+        else
+        {
+            pos = gEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    std::uint32_t size = static_cast<std::uint32_t>(message.size());
+    if (size > cMessageSize)
+    {
+        size = cMessageSize;
+    }
+    std::memcpy(slot->message, message.data(), size);
+    slot->size = size;
+    slot->level = level;
+    slot->sequence.store(pos + 1U - index, std::memory_order_release);
+
+    if (level >= ALOG_LEVEL_ERROR)
+    {
+        // Errors are worth an immediate write
+        gWake.notify_one();
+    }
+    return true;
+}
+
+/**
+ * @brief Write the pending messages from the calling thread
+ */
+void AsyncLog::Flush()
+{
+    (void) Drain();
+}
+
+std::uint32_t AsyncLog::GetDropped()
+{
+    return gDropped.load(std::memory_order_relaxed);
+}
+
+//=============================================================================
+// End of file AsyncLog.cpp
+//=============================================================================
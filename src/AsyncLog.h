@@ -0,0 +1,93 @@
+/*=============================================================================
+ * Tanca - AsyncLog.h
+ *=============================================================================
+ * Non blocking log backend: lock-free ring buffer and background writer
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef ASYNC_LOG_H
+#define ASYNC_LOG_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <sstream>
+
+// Log levels, also usable in preprocessor tests
+#define ALOG_LEVEL_DEBUG    0
+#define ALOG_LEVEL_INFO     1
+#define ALOG_LEVEL_WARNING  2
+#define ALOG_LEVEL_ERROR    3
+#define ALOG_LEVEL_NONE     4
+
+// Lowest level compiled in; debug traces are removed from release builds
+#ifndef ALOG_LEVEL
+#ifdef NDEBUG
+#define ALOG_LEVEL ALOG_LEVEL_INFO
+#else
+#define ALOG_LEVEL ALOG_LEVEL_DEBUG
+#endif
+#endif
+
+/**
+ * @brief Log messages without blocking the caller on terminal or file I/O
+ *
+ * Producers format the message and copy it into a bounded ring buffer
+ * (lock-free, multiple producers). A background thread empties the buffer
+ * and writes the lines to the output (stdout by default). When the buffer is full the
+ * message is dropped and counted instead of waiting.
+ */
+class AsyncLog
+{
+public:
+    static const std::uint32_t cCapacity = 1024U;      // Number of slots, power of two
+    static const std::uint32_t cMessageSize = 240U;    // Longer messages are truncated
+    static const int cFlushPeriod = 50;                // in milliseconds
+
+    static void Start(std::FILE *output = stdout);
+    static void Stop();
+    static bool Push(int level, const std::string &message);
+    static void Flush();
+    static std::uint32_t GetDropped();
+};
+
+// Stream syntax: ALogDebug("Found " << n << " solutions");
+// Messages below ALOG_LEVEL are never formatted and are removed by the compiler.
+#define ALOG_WRITE(level, expr) \
+    do { \
+        if ((level) >= ALOG_LEVEL) \
+        { \
+            std::ostringstream alog_stream; \
+            alog_stream << expr; \
+            AsyncLog::Push((level), alog_stream.str()); \
+        } \
+    } while (0)
+
+#define ALogDebug(expr)     ALOG_WRITE(ALOG_LEVEL_DEBUG, expr)
+#define ALogInfo(expr)      ALOG_WRITE(ALOG_LEVEL_INFO, expr)
+#define ALogWarning(expr)   ALOG_WRITE(ALOG_LEVEL_WARNING, expr)
+#define ALogError(expr)     ALOG_WRITE(ALOG_LEVEL_ERROR, expr)
+
+#endif // ASYNC_LOG_H
+
+//=============================================================================
+// End of file AsyncLog.h
+//=============================================================================
@@ -0,0 +1,242 @@
+/*=============================================================================
+ * Tanca - BackupService.cpp
+ *=============================================================================
+ * Online backup of the live database, in the background
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <sqlite3.h>
+
+#include "BackupService.h"
+#include "AsyncLog.h"
+#include "Profiler.h"
+
+const int BackupService::cPagesPerStep;
+const int BackupService::cStepPause;
+const std::uint32_t BackupService::cDefaultKeep;
+
+BackupService::BackupService()
+    : mKeep(cDefaultKeep)
+    , mPending(false)
+    , mBusy(false)
+    , mStop(false)
+    , mLastSuccess(true)
+    , mCompleted(0U)
+{
+
+}
+
+BackupService::~BackupService()
+{
+    Stop();
+}
+
+void BackupService::Start(const std::string &dbPath, const std::string &backupDir, std::uint32_t keep)
+{
+    Stop();
+
+    // Backup name: the database file name without its extension
+    std::string fileName = dbPath.substr(dbPath.find_last_of("/\\") + 1U);
+    std::size_t dot = fileName.find_last_of('.');
+    if ((dot != std::string::npos) && (dot > 0U))
+    {
+        fileName.resize(dot);
+    }
+
+    mDbPath = dbPath;
+    mBaseName = backupDir + "/" + fileName;
+    mKeep = (keep > 0U) ? keep : 1U;
+    mStop = false;
+    mThread = std::thread(&BackupService::Run, this);
+}
+
+void BackupService::Stop()
+{
+    if (mThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStop = true;
+        }
+        mWakeUp.notify_one();
+        mThread.join();
+    }
+}
+
+/**
+ * @brief Ask for a backup, never waits
+ */
+void BackupService::Request()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending = true;
+    }
+    mWakeUp.notify_one();
+}
+
+bool BackupService::Wait()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+    mIdle.wait(lock, [this]() { return (!mPending && !mBusy) || !mThread.joinable(); });
+    return mLastSuccess;
+}
+
+std::uint32_t BackupService::GetCompleted() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mCompleted;
+}
+
+std::string BackupService::GetBackupPath(std::uint32_t index) const
+{
+    return mBaseName + "." + ((index == 0U) ? std::string("tmp") : std::to_string(index)) + ".db";
+}
+
+void BackupService::Run()
+{
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    while (true)
+    {
+        mWakeUp.wait(lock, [this]() { return mPending || mStop; });
+        if (!mPending)
+        {
+            break; // Stopped, nothing left to do
+        }
+
+        mPending = false;
+        mBusy = true;
+        lock.unlock();
+
+        bool success = Backup();
+
+        lock.lock();
+        mBusy = false;
+        mLastSuccess = success;
+        if (success)
+        {
+            mCompleted++;
+        }
+        mIdle.notify_all();
+    }
+}
+
+/**
+ * @brief Copy to the temporary file, then rotate the backups
+ */
+bool BackupService::Backup()
+{
+    TRACE_SCOPE("backup.Backup");
+    std::string temporary = GetBackupPath(0U);
+
+    if (!Copy(mDbPath, temporary))
+    {
+        (void) std::remove(temporary.c_str());
+        return false;
+    }
+
+    (void) std::remove(GetBackupPath(mKeep).c_str());
+    for (std::uint32_t i = mKeep - 1U; i >= 1U; i--)
+    {
+        // Missing files are expected until the rotation is full
+        (void) std::rename(GetBackupPath(i).c_str(), GetBackupPath(i + 1U).c_str());
+    }
+
+    if (std::rename(temporary.c_str(), GetBackupPath(1U).c_str()) != 0)
+    {
+        ALogError("Cannot rename backup " << temporary);
+        return false;
+    }
+
+    ALogInfo("Database backup done: " << GetBackupPath(1U));
+    return true;
+}
+
+/**
+ * @brief Page by page copy of a database in use
+ *
+ * If the source is written between two steps, SQLite restarts the copy by
+ * itself, so the result is always a consistent state of the database.
+ */
+bool BackupService::Copy(const std::string &source, const std::string &destination, int pagesPerStep, int pause)
+{
+    sqlite3 *src = nullptr;
+    sqlite3 *dst = nullptr;
+    bool success = false;
+
+    (void) std::remove(destination.c_str());
+
+    // No SQLITE_OPEN_CREATE: never create an empty source by mistake
+    if ((sqlite3_open_v2(source.c_str(), &src, SQLITE_OPEN_READWRITE, nullptr) == SQLITE_OK) &&
+        (sqlite3_open_v2(destination.c_str(), &dst, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, nullptr) == SQLITE_OK))
+    {
+        sqlite3_backup *backup = sqlite3_backup_init(dst, "main", src, "main");
+        if (backup != nullptr)
+        {
+            int rc = SQLITE_OK;
+            do
+            {
+                rc = sqlite3_backup_step(backup, pagesPerStep);
+                if ((rc == SQLITE_OK) || (rc == SQLITE_BUSY) || (rc == SQLITE_LOCKED))
+                {
+                    // Let the application connection work between the steps
+                    std::this_thread::sleep_for(std::chrono::milliseconds(pause));
+                }
+            }
+            while ((rc == SQLITE_OK) || (rc == SQLITE_BUSY) || (rc == SQLITE_LOCKED));
+
+            success = (rc == SQLITE_DONE);
+            (void) sqlite3_backup_finish(backup);
+
+            // The copy is a single file, without the write-ahead log of the source
+            success = success && (sqlite3_exec(dst, "PRAGMA journal_mode=DELETE", nullptr, nullptr, nullptr) == SQLITE_OK);
+
+            // Also write the log back into the source file, as far as the readers allow. Passive:
+            // never takes the writer lock, a score entered meanwhile does not wait. The log is
+            // truncated when the database is closed.
+            if (success && (sqlite3_wal_checkpoint_v2(src, nullptr, SQLITE_CHECKPOINT_PASSIVE, nullptr, nullptr) != SQLITE_OK))
+            {
+                ALogDebug("Database checkpoint postponed: " << sqlite3_errmsg(src));
+            }
+        }
+
+        if (!success)
+        {
+            ALogError("Database backup failed: " << sqlite3_errmsg(dst));
+        }
+    }
+    else
+    {
+        ALogError("Database backup cannot open " << ((dst == nullptr) ? source : destination));
+    }
+
+    // sqlite3_close() accepts a null pointer
+    (void) sqlite3_close(src);
+    (void) sqlite3_close(dst);
+    return success;
+}
+
+//=============================================================================
+// End of file BackupService.cpp
+//=============================================================================
@@ -0,0 +1,95 @@
+/*=============================================================================
+ * Tanca - BackupService.h
+ *=============================================================================
+ * Online backup of the live database, in the background
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef BACKUP_SERVICE_H
+#define BACKUP_SERVICE_H
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+/**
+ * @brief Consistent copies of the database file, taken while it is in use
+ *
+ * The copy uses the SQLite online backup API on its own connection, a few
+ * pages at a time with a short pause between the steps, so the application
+ * connection only waits for one step at most (never, in WAL mode). A backup
+ * is requested without waiting; requests made during a backup are merged
+ * into the next one.
+ *
+ * The copies are rotated: <name>.1.db is the most recent, <name>.N.db the
+ * oldest one kept. The copy is first written to <name>.tmp.db, so a backup
+ * file is always complete.
+ */
+class BackupService
+{
+public:
+    static const int cPagesPerStep = 64;
+    static const int cStepPause = 5;            // in milliseconds
+    static const std::uint32_t cDefaultKeep = 5U;
+
+    BackupService();
+    ~BackupService();
+
+    void Start(const std::string &dbPath, const std::string &backupDir, std::uint32_t keep = cDefaultKeep);
+    // Finish the pending backup, then stop the thread
+    void Stop();
+
+    void Request();
+    // Block until no backup is pending, returns false if the last one failed
+    bool Wait();
+
+    std::uint32_t GetCompleted() const;
+    std::string GetBackupPath(std::uint32_t index) const;
+
+    // Synchronous copy, used by the thread
+    static bool Copy(const std::string &source, const std::string &destination, int pagesPerStep = cPagesPerStep, int pause = cStepPause);
+
+private:
+    std::string mDbPath;
+    std::string mBaseName;  // backup directory and database name, without extension
+    std::uint32_t mKeep;
+
+    std::thread mThread;
+    mutable std::mutex mMutex;
+    std::condition_variable mWakeUp;
+    std::condition_variable mIdle;
+    bool mPending;
+    bool mBusy;
+    bool mStop;
+    bool mLastSuccess;
+    std::uint32_t mCompleted;
+
+    void Run();
+    bool Backup();
+};
+
+#endif // BACKUP_SERVICE_H
+
+//=============================================================================
+// End of file BackupService.h
+//=============================================================================
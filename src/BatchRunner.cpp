@@ -0,0 +1,475 @@
+/*=============================================================================
+ * Tanca - BatchRunner.cpp
+ *=============================================================================
+ * Headless command line mode: pairing, ranking and export on a database file
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <set>
+
+#include "BatchRunner.h"
+#include "Exporter.h"
+#include "RoundRobin.h"
+#include "EventWorkspace.h"
+#include "CourtAllocator.h"
+#include "Util.h"
+
+static const char *gUsage =
+        "Usage: tanca --batch <database> <command> [arguments] [-o <file>]\n"
+        "\n"
+        "Commands:\n"
+        "  events [year]                 list the events (all years by default)\n"
+        "  next-round <events> [rounds]  generate and store the next round(s) of events\n"
+        "                                (ids separated by commas, paired concurrently)\n"
+        "  ranking <event> [round]       ranking of an event, up to a round (all by default)\n"
+        "  season-ranking <year>         players ranking of a season\n"
+        "  export-games <event>          games of an event\n"
+        "  export-season <year>          games of all the events of a season\n"
+        "  ratings [recompute]           Elo ratings of the players, optionally\n"
+        "                                replayed from the whole history first\n"
+        "  rewards <event> [amounts]     rewards of an event per team, optionally paid out\n"
+        "                                first from the final ranking (amounts per place,\n"
+        "                                separated by commas)\n"
+        "  season-rewards <year>         rewards paid out by each event of a season\n"
+        "  close-season <year>           move a season to a read-only archive file\n"
+        "  backup                        copy the database to the backups directory\n"
+        "\n"
+        "Results are written as CSV to the standard output, or to the file given\n"
+        "with -o (JSON if the file name ends with .json).\n";
+
+BatchRunner::BatchRunner(const QString &dbPath)
+    : mPath(dbPath)
+    , mDatabase(dbPath)
+{
+
+}
+
+bool BatchRunner::IsBatch(int argc, char *argv[])
+{
+    return (argc > 1) && (std::strcmp(argv[1], "--batch") == 0);
+}
+
+void BatchRunner::Usage()
+{
+    std::fputs(gUsage, stderr);
+}
+
+/**
+ * @brief Run a command
+ * @param args: the command and its arguments, after the database path
+ * @return the process exit code
+ */
+int BatchRunner::Run(const QStringList &args)
+{
+    QStringList params = args;
+    std::string output = "-";
+
+    int option = params.indexOf("-o");
+    if (option >= 0)
+    {
+        if ((option + 1) >= params.size())
+        {
+            Usage();
+            return cErrorUsage;
+        }
+        output = params.at(option + 1).toStdString();
+        params.removeAt(option + 1);
+        params.removeAt(option);
+    }
+
+    if (params.size() == 0)
+    {
+        Usage();
+        return cErrorUsage;
+    }
+
+    // Never create an empty database by mistake
+    if (!QFileInfo(mPath).isFile())
+    {
+        std::fprintf(stderr, "Database not found: %s\n", mPath.toLocal8Bit().constData());
+        return cErrorDatabase;
+    }
+
+    mDatabase.Initialize();
+    if (!mDatabase.IsOpen())
+    {
+        std::fprintf(stderr, "Cannot open database: %s\n", mPath.toLocal8Bit().constData());
+        return cErrorDatabase;
+    }
+
+    QString command = params.takeFirst();
+    int ret = cErrorUsage;
+    Event event;
+
+    if (command == "events")
+    {
+        ret = ListEvents((params.size() > 0) ? params.at(0).toInt() : -1, output);
+    }
+    else if ((command == "next-round") && (params.size() >= 1))
+    {
+        int rounds = (params.size() >= 2) ? params.at(1).toInt() : 1;
+        ret = NextRound(params.at(0).split(','), rounds, output);
+    }
+    else if ((command == "ranking") && (params.size() >= 1))
+    {
+        int round = (params.size() >= 2) ? params.at(1).toInt() : -1;
+        ret = GetEvent(params.at(0), event) ? Ranking(event, round, output) : cErrorCommand;
+    }
+    else if ((command == "season-ranking") && (params.size() >= 1))
+    {
+        ret = SeasonRanking(params.at(0).toInt(), output);
+    }
+    else if ((command == "export-games") && (params.size() >= 1))
+    {
+        ret = GetEvent(params.at(0), event) ? ExportGames(event, output) : cErrorCommand;
+    }
+    else if ((command == "export-season") && (params.size() >= 1))
+    {
+        ret = Exporter::ExportSeason(output, mDatabase, params.at(0).toInt()) ? cSuccess : cErrorCommand;
+    }
+    else if ((command == "rewards") && (params.size() >= 1))
+    {
+        ret = GetEvent(params.at(0), event) ? Rewards(event, (params.size() >= 2) ? params.at(1) : QString(), output) : cErrorCommand;
+    }
+    else if ((command == "season-rewards") && (params.size() >= 1))
+    {
+        std::deque<Event> events = mDatabase.GetEvents(params.at(0).toInt());
+        ret = Exporter::ExportRewardTotals(output, mDatabase.GetRewardTotals(events), events) ? cSuccess : cErrorCommand;
+    }
+    else if ((command == "close-season") && (params.size() >= 1))
+    {
+        ret = mDatabase.CloseSeason(params.at(0).toInt()) ? cSuccess : cErrorCommand;
+    }
+    else if (command == "backup")
+    {
+        mDatabase.RequestBackup();
+        ret = mDatabase.WaitBackup() ? cSuccess : cErrorCommand;
+    }
+    else if (command == "ratings")
+    {
+        ret = Ratings((params.size() >= 1) && (params.at(0) == "recompute"), output);
+    }
+    else
+    {
+        Usage();
+    }
+
+    return ret;
+}
+
+bool BatchRunner::GetEvent(const QString &arg, Event &event)
+{
+    bool ok = false;
+    int id = arg.toInt(&ok);
+
+    if (ok)
+    {
+        event = mDatabase.GetEvent(id);
+        ok = event.IsValid();
+    }
+
+    if (!ok)
+    {
+        std::fprintf(stderr, "Unknown event: %s\n", arg.toLocal8Bit().constData());
+    }
+    return ok;
+}
+
+int BatchRunner::ListEvents(int year, const std::string &output)
+{
+    std::deque<Event> events;
+
+    if (year < 0)
+    {
+        for (auto const &season : mDatabase.GetSeasons())
+        {
+            std::deque<Event> e = mDatabase.GetEvents(season.toInt());
+            events.insert(events.end(), e.begin(), e.end());
+        }
+    }
+    else
+    {
+        events = mDatabase.GetEvents(year);
+    }
+
+    Exporter exporter;
+    if (!exporter.Open(output, "events"))
+    {
+        return cErrorCommand;
+    }
+
+    exporter.SetHeader({"Id", "Date", "Type", "Titre", "État"});
+    for (auto const &e : events)
+    {
+        exporter.AddRow({e.id, Util::ToISODateTime(e.date), e.type, e.title, e.state});
+    }
+    return exporter.Close() ? cSuccess : cErrorCommand;
+}
+
+/**
+ * @brief Same rules as the "generate" button of the games tab
+ *
+ * The Swiss rounds of all the events are computed at the same time. All the
+ * events are checked and their rounds built before anything is stored: nothing
+ * is stored if one of them cannot be generated (a database error while
+ * storing may still leave the previous events stored). An event given twice
+ * is only generated once.
+ */
+int BatchRunner::NextRound(const QStringList &eventIds, int rounds, const std::string &output)
+{
+    EventWorkspace workspace(mDatabase, static_cast<std::uint32_t>(eventIds.size()));
+    std::vector<EventSession *> roundRobin;
+    std::vector<EventSession *> swiss;
+    std::set<int> seen;
+
+    for (auto const &arg : eventIds)
+    {
+        Event event;
+        if (!GetEvent(arg, event))
+        {
+            return cErrorCommand;
+        }
+
+        if (!seen.insert(event.id).second)
+        {
+            continue;
+        }
+
+        if (event.IsKnockout())
+        {
+            std::fprintf(stderr, "Event %d is a knockout bracket, its games follow the scores\n", event.id);
+            return cErrorCommand;
+        }
+
+        EventSession *session = workspace.Open(event.id);
+        if (session == nullptr)
+        {
+            std::fprintf(stderr, "Cannot open event %d\n", event.id);
+            return cErrorCommand;
+        }
+
+        if (session->teams.size() % 2)
+        {
+            std::fprintf(stderr, "Odd number of teams in event %d, add a dummy team\n", event.id);
+            return cErrorCommand;
+        }
+
+        if (event.type == Event::cRoundRobin)
+        {
+            RoundRobinStream check(session->teams, Tournament::CountRounds(session->games), static_cast<std::uint32_t>(std::max(rounds, 1)));
+            if (check.GetTotal() == 0U)
+            {
+                std::fprintf(stderr, "Cannot build rounds of event %d: not enough teams\n", event.id);
+                return cErrorCommand;
+            }
+            roundRobin.push_back(session);
+        }
+        else
+        {
+            swiss.push_back(session);
+        }
+    }
+
+    std::vector<Pairing> pairings = workspace.Pair(swiss);
+    for (auto const &p : pairings)
+    {
+        if (p.games.size() == 0)
+        {
+            std::fprintf(stderr, "Cannot build rounds of event %d: %s\n", p.session->event.id, p.error.c_str());
+            return cErrorCommand;
+        }
+    }
+
+    std::deque<Team> teams;
+    std::deque<Game> games;
+
+    for (auto session : roundRobin)
+    {
+        // Streamed straight to the database, then listed from it
+        std::uint32_t firstRound = Tournament::CountRounds(session->games);
+        RoundRobinStream stream(session->teams, firstRound, static_cast<std::uint32_t>(std::max(rounds, 1)));
+        CourtAllocator allocator(CourtAllocator::GetCourts(session->event));
+        allocator.AddHistory(session->games);
+        CourtStream courts(allocator, [&stream]() { return stream.Next(); });
+
+        if (!StartEvent(*session) || !mDatabase.AddGames([&courts]() { return courts.Next(); }))
+        {
+            std::fputs("Cannot store rounds\n", stderr);
+            return cErrorCommand;
+        }
+
+        for (auto const &g : mDatabase.GetGamesByEventId(session->event.id))
+        {
+            if (g.turn >= static_cast<int>(firstRound))
+            {
+                games.push_back(g);
+            }
+        }
+        teams.insert(teams.end(), session->teams.begin(), session->teams.end());
+    }
+
+    for (auto &p : pairings)
+    {
+        CourtAllocator allocator(CourtAllocator::GetCourts(p.session->event));
+        allocator.AddHistory(p.session->games);
+        allocator.Assign(p.games);
+
+        if (!StartEvent(*p.session) || !mDatabase.AddGames(p.games))
+        {
+            std::fputs("Cannot store rounds\n", stderr);
+            return cErrorCommand;
+        }
+        games.insert(games.end(), p.games.begin(), p.games.end());
+        teams.insert(teams.end(), p.session->teams.begin(), p.session->teams.end());
+    }
+
+    // Print the new games, with their database ids
+    return Exporter::ExportGames(output, games, teams) ? cSuccess : cErrorCommand;
+}
+
+bool BatchRunner::StartEvent(EventSession &session)
+{
+    session.event.state = Event::cStarted;
+    return mDatabase.UpdateEventState(session.event);
+}
+
+int BatchRunner::Ranking(const Event &event, int round, const std::string &output)
+{
+    std::deque<Team> teams = mDatabase.GetTeams(event.id);
+    std::deque<Game> games = mDatabase.GetGamesByEventId(event.id);
+
+    if (round < 1)
+    {
+        // All the rounds
+        for (auto const &g : games)
+        {
+            round = std::max(round, g.turn + 1);
+        }
+    }
+
+    mTournament.GenerateTeamRanking(games, teams, round);
+    return Exporter::ExportRanking(output, mTournament.GetRanking(), teams, mDatabase.GetPlayers(), false) ? cSuccess : cErrorCommand;
+}
+
+int BatchRunner::Rewards(const Event &event, const QString &amounts, const std::string &output)
+{
+    std::deque<Team> teams = mDatabase.GetTeams(event.id);
+
+    if (!amounts.isEmpty())
+    {
+        std::vector<int> values;
+        for (auto const &field : amounts.split(',', QString::SkipEmptyParts))
+        {
+            bool ok = false;
+            int amount = field.trimmed().toInt(&ok);
+            if (!ok || (amount < 0))
+            {
+                std::fprintf(stderr, "Invalid amount: %s\n", field.toStdString().c_str());
+                return cErrorCommand;
+            }
+            values.push_back(amount);
+        }
+
+        std::deque<Game> games = mDatabase.GetGamesByEventId(event.id);
+        int rounds = 0;
+        for (auto const &g : games)
+        {
+            rounds = std::max(rounds, g.turn + 1);
+        }
+
+        mTournament.GenerateTeamRanking(games, teams, rounds);
+        if (!mDatabase.AssignRankingRewards(event.id, mTournament.GetRanking(), values))
+        {
+            return cErrorCommand;
+        }
+    }
+
+    return Exporter::ExportRewardTotals(output, mDatabase.GetRewardTotals(event.id), teams) ? cSuccess : cErrorCommand;
+}
+
+int BatchRunner::SeasonRanking(int year, const std::string &output)
+{
+    std::deque<Event> events = mDatabase.GetEvents(year);
+    const SeasonArchive *archive = mDatabase.GetArchive(year);
+
+    if (archive != nullptr)
+    {
+        // Closed season: ranked on the columns of the archive
+        EventSnapshot snapshot;
+        archive->GetSnapshot(snapshot);
+        mTournament.GeneratePlayerRanking(snapshot, events);
+        return Exporter::ExportRanking(output, mTournament.GetRanking(), std::deque<Team>(), mDatabase.GetPlayers(), true) ? cSuccess : cErrorCommand;
+    }
+
+    std::deque<Game> games;
+    std::deque<Team> teams;
+
+    for (auto const &e : events)
+    {
+        std::deque<Game> g = mDatabase.GetGamesByEventId(e.id);
+        games.insert(games.end(), g.begin(), g.end());
+
+        std::deque<Team> t = mDatabase.GetTeams(e.id);
+        teams.insert(teams.end(), t.begin(), t.end());
+    }
+
+    mTournament.GeneratePlayerRanking(games, teams, events);
+    return Exporter::ExportRanking(output, mTournament.GetRanking(), teams, mDatabase.GetPlayers(), true) ? cSuccess : cErrorCommand;
+}
+
+int BatchRunner::ExportGames(const Event &event, const std::string &output)
+{
+    std::deque<Team> teams = mDatabase.GetTeams(event.id);
+    std::deque<Game> games = mDatabase.GetGamesByEventId(event.id);
+
+    return Exporter::ExportGames(output, games, teams) ? cSuccess : cErrorCommand;
+}
+
+int BatchRunner::Ratings(bool recompute, const std::string &output)
+{
+    RatingEngine engine;
+
+    if (recompute)
+    {
+        std::vector<RatedEvent> history = mDatabase.GetRatingHistory();
+        std::deque<RatingDelta> deltas;
+
+        engine.Recompute(history, deltas);
+        if (!mDatabase.StoreRatings(engine.GetRatings(), deltas, true))
+        {
+            std::fputs("Cannot store the ratings\n", stderr);
+            return cErrorCommand;
+        }
+    }
+    else
+    {
+        engine.SetRatings(mDatabase.GetRatings());
+    }
+
+    return Exporter::ExportRatings(output, engine.GetRatings(), mDatabase.GetPlayers()) ? cSuccess : cErrorCommand;
+}
+
+//=============================================================================
+// End of file BatchRunner.cpp
+//=============================================================================
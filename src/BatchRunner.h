@@ -0,0 +1,79 @@
+/*=============================================================================
+ * Tanca - BatchRunner.h
+ *=============================================================================
+ * Headless command line mode: pairing, ranking and export on a database file
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <string>
+#include <QStringList>
+
+#include "DbManager.h"
+#include "Tournament.h"
+
+class EventSession;
+
+/**
+ * @brief Runs one command on a database, without any widget
+ *
+ * Usage: tanca --batch <database> <command> [arguments]
+ * Results are written to the standard output (or to a file with -o),
+ * messages go to the standard error. The exit code is zero on success.
+ */
+class BatchRunner
+{
+public:
+    static const int cSuccess = 0;
+    static const int cErrorUsage = 1;
+    static const int cErrorDatabase = 2;
+    static const int cErrorCommand = 3;
+
+    BatchRunner(const QString &dbPath);
+
+    int Run(const QStringList &args);
+
+    static bool IsBatch(int argc, char *argv[]);
+    static void Usage();
+
+private:
+    QString mPath;
+    DbManager mDatabase;
+    Tournament mTournament;
+
+    bool GetEvent(const QString &arg, Event &event);
+    int ListEvents(int year, const std::string &output);
+    int NextRound(const QStringList &eventIds, int rounds, const std::string &output);
+    bool StartEvent(EventSession &session);
+    int Ranking(const Event &event, int round, const std::string &output);
+    int SeasonRanking(int year, const std::string &output);
+    int Rewards(const Event &event, const QString &amounts, const std::string &output);
+    int ExportGames(const Event &event, const std::string &output);
+    int Ratings(bool recompute, const std::string &output);
+};
+
+#endif // BATCH_RUNNER_H
+
+//=============================================================================
+// End of file BatchRunner.h
+//=============================================================================
@@ -0,0 +1,478 @@
+/*=============================================================================
+ * Tanca - Brackets.cpp
+ *=============================================================================
+ * Single and double elimination brackets
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "Brackets.h"
+#include "DocumentField.h"
+
+static const char *cMatchKey = "match";
+static const char *cSeedKey = "seed";
+
+// Depth of a node of the implicit tree, the root is at depth 0
+static std::uint32_t Depth(std::uint32_t node)
+{
+    std::uint32_t depth = 0U;
+    while (node > 1U)
+    {
+        node >>= 1U;
+        depth++;
+    }
+    return depth;
+}
+
+Bracket::Bracket()
+    : mSize(0U)
+    , mLevels(0U)
+    , mDouble(false)
+{
+
+}
+
+/**
+ * @brief Create the matches and place the seeds
+ *
+ * Seed s meets seed N+1-s in the first round, so that the two best seeds can
+ * only meet in the final. Byes are resolved at once.
+ */
+void Bracket::Build(const std::vector<int> &seeds, bool doubleElimination, int firstTurn)
+{
+    std::uint32_t nbTeams = static_cast<std::uint32_t>(seeds.size());
+
+    mMatches.clear();
+    mLosersOffset.clear();
+    mSize = 0U;
+    mLevels = 0U;
+    mDouble = doubleElimination;
+
+    if (nbTeams < 2U)
+    {
+        return;
+    }
+
+    mSize = 2U;
+    mLevels = 1U;
+    while (mSize < nbTeams)
+    {
+        mSize *= 2U;
+        mLevels++;
+    }
+
+    // Losers bracket: two rounds per level but the first one
+    std::uint32_t losersRounds = mDouble ? (2U * (mLevels - 1U)) : 0U;
+    mLosersOffset.resize(losersRounds + 2U);
+    mLosersOffset[1] = mSize;
+    for (std::uint32_t r = 1U; r <= losersRounds; r++)
+    {
+        mLosersOffset[r + 1U] = mLosersOffset[r] + (mSize >> ((r + 1U) / 2U + 1U));
+    }
+
+    Match empty;
+    empty.team1 = cNone;
+    empty.team2 = cNone;
+    empty.winner = cNone;
+    empty.gameId = -1;
+    empty.turn = 0U;
+    mMatches.assign(mDouble ? (GrandFinal() + 1U) : mSize, empty);
+
+    for (std::uint32_t i = 1U; i < mSize; i++)
+    {
+        mMatches[i].turn = static_cast<std::uint16_t>(firstTurn + mLevels - Depth(i) - 1U);
+    }
+    for (std::uint32_t r = 1U; r <= losersRounds; r++)
+    {
+        for (std::uint32_t m = mLosersOffset[r]; m < mLosersOffset[r + 1U]; m++)
+        {
+            mMatches[m].turn = static_cast<std::uint16_t>(firstTurn + r);
+        }
+    }
+    if (mDouble)
+    {
+        mMatches[GrandFinal()].turn = static_cast<std::uint16_t>(firstTurn + losersRounds + 1U);
+    }
+
+    // Seed positions, built by doubling: [1, 2] -> [1, 4, 2, 3] -> ...
+    std::vector<std::uint32_t> order(1U, 1U);
+    while (order.size() < mSize)
+    {
+        std::vector<std::uint32_t> next;
+        std::uint32_t sum = static_cast<std::uint32_t>(order.size()) * 2U + 1U;
+        for (auto s : order)
+        {
+            next.push_back(s);
+            next.push_back(sum - s);
+        }
+        order.swap(next);
+    }
+
+    std::vector<std::uint32_t> changed;
+    for (std::uint32_t p = 0U; p < mSize; p++)
+    {
+        int team = (order[p] <= nbTeams) ? seeds[order[p] - 1U] : cBye;
+        Place((mSize + p) / 2U, static_cast<int>(p % 2U), team, changed);
+    }
+}
+
+std::uint32_t Bracket::LosersMatch(std::uint32_t round, std::uint32_t index) const
+{
+    return mLosersOffset[round] + index;
+}
+
+std::uint32_t Bracket::GrandFinal() const
+{
+    return mLosersOffset.back();
+}
+
+bool Bracket::IsReady(std::uint32_t match) const
+{
+    const Match &m = mMatches[match];
+    return (m.winner == cNone) &&
+           (m.team1 != cNone) && (m.team1 != cBye) &&
+           (m.team2 != cNone) && (m.team2 != cBye);
+}
+
+int Bracket::GetChampion() const
+{
+    int champion = cNone;
+    if (mMatches.size() > 1U)
+    {
+        champion = mDouble ? mMatches[GrandFinal()].winner : mMatches[1].winner;
+    }
+    return champion;
+}
+
+// Match decided without playing
+bool Bracket::IsAutomatic(std::uint32_t match) const
+{
+    return (mMatches[match].team1 == cBye) || (mMatches[match].team2 == cBye);
+}
+
+/**
+ * @brief Match where the winner goes, 0 for the last match
+ */
+std::uint32_t Bracket::WinnerPlace(std::uint32_t match, int &slot) const
+{
+    std::uint32_t next = 0U;
+    std::uint32_t losersRounds = static_cast<std::uint32_t>(mLosersOffset.size()) - 2U;
+
+    if (match < mSize)
+    {
+        if (match > 1U)
+        {
+            slot = static_cast<int>(match % 2U);
+            next = match / 2U;
+        }
+        else if (mDouble)
+        {
+            slot = 0;
+            next = GrandFinal();
+        }
+    }
+    else if (mDouble && (match < GrandFinal()))
+    {
+        std::uint32_t r = 1U;
+        while (match >= mLosersOffset[r + 1U])
+        {
+            r++;
+        }
+        std::uint32_t k = match - mLosersOffset[r];
+
+        if (r == losersRounds)
+        {
+            slot = 1;
+            next = GrandFinal();
+        }
+        else if (r % 2U)
+        {
+            // Next round: against a team coming from the winners bracket
+            slot = 0;
+            next = LosersMatch(r + 1U, k);
+        }
+        else
+        {
+            slot = static_cast<int>(k % 2U);
+            next = LosersMatch(r + 1U, k / 2U);
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief Match where the loser goes (double elimination only), 0 if eliminated
+ */
+std::uint32_t Bracket::LoserPlace(std::uint32_t match, int &slot) const
+{
+    std::uint32_t next = 0U;
+
+    if (mDouble && (match < mSize))
+    {
+        std::uint32_t depth = Depth(match);
+        std::uint32_t round = mLevels - depth; // 1 is the first round
+        std::uint32_t index = match - (1U << depth);
+
+        if (mLevels == 1U)
+        {
+            // Two teams: no losers bracket
+            slot = 1;
+            next = GrandFinal();
+        }
+        else if (round == 1U)
+        {
+            slot = static_cast<int>(index % 2U);
+            next = LosersMatch(1U, index / 2U);
+        }
+        else
+        {
+            // Every other round is reversed, to avoid early rematches
+            std::uint32_t count = mSize >> round;
+            slot = 1;
+            next = LosersMatch(2U * (round - 1U), (round % 2U) ? index : (count - 1U - index));
+        }
+    }
+    return next;
+}
+
+/**
+ * @brief True if the teams sent further by this match can still be replaced
+ */
+bool Bracket::CanChange(std::uint32_t match) const
+{
+    bool ok = true;
+    int slot;
+
+    for (auto next : { WinnerPlace(match, slot), LoserPlace(match, slot) })
+    {
+        if ((next != 0U) && (mMatches[next].winner != cNone))
+        {
+            ok = ok && IsAutomatic(next) && CanChange(next);
+        }
+    }
+    return ok;
+}
+
+bool Bracket::CanSetResult(std::uint32_t match, int winner) const
+{
+    bool ok = false;
+
+    if (IsValid(match))
+    {
+        const Match &m = mMatches[match];
+        bool teams = (m.team1 != cNone) && (m.team1 != cBye) && (m.team2 != cNone) && (m.team2 != cBye);
+
+        if (teams && ((winner == m.team1) || (winner == m.team2)))
+        {
+            // A new winner changes the next matches, they must not be played yet
+            ok = (m.winner == cNone) || (m.winner == winner) || CanChange(match);
+        }
+    }
+    return ok;
+}
+
+bool Bracket::SetResult(std::uint32_t match, int winner, std::vector<std::uint32_t> &changed)
+{
+    bool ok = CanSetResult(match, winner);
+
+    if (ok && (mMatches[match].winner != winner))
+    {
+        Decide(match, winner, changed);
+    }
+    return ok;
+}
+
+void Bracket::Decide(std::uint32_t match, int winner, std::vector<std::uint32_t> &changed)
+{
+    Match &m = mMatches[match];
+    int loser = (winner == m.team1) ? m.team2 : m.team1;
+    int slot;
+
+    m.winner = winner;
+
+    std::uint32_t next = WinnerPlace(match, slot);
+    if (next != 0U)
+    {
+        Place(next, slot, winner, changed);
+    }
+
+    next = LoserPlace(match, slot);
+    if (next != 0U)
+    {
+        Place(next, slot, loser, changed);
+    }
+}
+
+/**
+ * @brief Put a team in a match; a previous result of this match is cancelled
+ */
+void Bracket::Place(std::uint32_t match, int slot, int team, std::vector<std::uint32_t> &changed)
+{
+    Match &m = mMatches[match];
+    int &current = (slot == 0) ? m.team1 : m.team2;
+
+    if (current != team)
+    {
+        current = team;
+        changed.push_back(match);
+
+        if (m.winner != cNone)
+        {
+            // The teams sent further by the old result are not known anymore
+            m.winner = cNone;
+
+            int s;
+            std::uint32_t next = WinnerPlace(match, s);
+            if (next != 0U)
+            {
+                Place(next, s, cNone, changed);
+            }
+            next = LoserPlace(match, s);
+            if (next != 0U)
+            {
+                Place(next, s, cNone, changed);
+            }
+        }
+
+        Resolve(match, changed);
+    }
+}
+
+// A team against a bye goes through (a bye against a bye gives a bye)
+void Bracket::Resolve(std::uint32_t match, std::vector<std::uint32_t> &changed)
+{
+    const Match &m = mMatches[match];
+
+    if ((m.winner == cNone) && (m.team1 != cNone) && (m.team2 != cNone) && IsAutomatic(match))
+    {
+        Decide(match, (m.team1 == cBye) ? m.team2 : m.team1, changed);
+    }
+}
+
+void Bracket::SetGameId(std::uint32_t match, int gameId)
+{
+    if (IsValid(match))
+    {
+        mMatches[match].gameId = gameId;
+    }
+}
+
+std::vector<std::uint32_t> Bracket::GetMatchesToPlay() const
+{
+    std::vector<std::uint32_t> matches;
+    for (std::uint32_t i = 1U; i < mMatches.size(); i++)
+    {
+        if (IsReady(i) && (mMatches[i].gameId < 0))
+        {
+            matches.push_back(i);
+        }
+    }
+    return matches;
+}
+
+void Bracket::MakeGame(std::uint32_t match, int eventId, Game &game) const
+{
+    const Match &m = mMatches[match];
+
+    game = Game();
+    game.eventId = eventId;
+    game.turn = m.turn;
+    game.team1Id = m.team1;
+    game.team2Id = m.team2;
+    SetMatchId(game, static_cast<int>(match));
+}
+
+int Bracket::GetWinner(const Game &game)
+{
+    int winner = cNone;
+    if ((game.team1Score >= 0) && (game.team2Score >= 0))
+    {
+        if (game.team1Score > game.team2Score)
+        {
+            winner = game.team1Id;
+        }
+        else if (game.team2Score > game.team1Score)
+        {
+            winner = game.team2Id;
+        }
+    }
+    return winner;
+}
+
+std::vector<int> Bracket::Seeds(const std::deque<Rank> &ranking, const std::deque<Team> &teams)
+{
+    std::vector<int> seeds;
+    std::unordered_set<int> placed;
+    IdIndex<Team> teamIds;
+    teamIds.Build(teams);
+
+    for (auto const &rank : ranking)
+    {
+        if ((teamIds.Find(rank.id) != nullptr) && placed.insert(rank.id).second)
+        {
+            seeds.push_back(rank.id);
+        }
+    }
+
+    // Teams without any game yet
+    std::vector<const Team *> others;
+    for (auto const &team : teams)
+    {
+        if (placed.count(team.id) == 0U)
+        {
+            others.push_back(&team);
+        }
+    }
+    std::stable_sort(others.begin(), others.end(), [](const Team *a, const Team *b) {
+        return a->number < b->number;
+    });
+    for (auto team : others)
+    {
+        seeds.push_back(team->id);
+    }
+    return seeds;
+}
+
+int Bracket::GetMatchId(const Game &game)
+{
+    return DocumentField::GetInteger(game.document, cMatchKey, 0);
+}
+
+void Bracket::SetMatchId(Game &game, int match)
+{
+    DocumentField::SetInteger(game.document, cMatchKey, match);
+}
+
+int Bracket::GetSeed(const Team &team)
+{
+    return DocumentField::GetInteger(team.document, cSeedKey, 0);
+}
+
+void Bracket::SetSeed(Team &team, int seed)
+{
+    DocumentField::SetInteger(team.document, cSeedKey, seed);
+}
+
+//=============================================================================
+// End of file Brackets.cpp
+//=============================================================================
@@ -0,0 +1,119 @@
+/*=============================================================================
+ * Tanca - Brackets.h
+ *=============================================================================
+ * Single and double elimination brackets
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef BRACKETS_H
+#define BRACKETS_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "IDataBase.h"
+#include "Tournament.h"
+
+/**
+ * @brief Knockout bracket, the matches are stored in flat arrays
+ *
+ * The draw has N places (power of two), the missing teams are byes given to
+ * the best seeds. Matches are identified by their index:
+ *   - 1 to N-1: winners bracket as an implicit binary tree, match 1 is the
+ *     final and the winner of match i plays in match i/2;
+ *   - N to N+L-1: losers bracket (double elimination), round after round;
+ *   - N+L: grand final (double elimination).
+ * A result only updates the matches on the way of the two teams, so entering
+ * a score is O(log N).
+ */
+class Bracket
+{
+public:
+    static const int cNone = -1;                // team not known yet
+    static const int cBye = Team::cDummyTeam;   // no opponent, the other team goes through
+
+    struct Match
+    {
+        int team1;
+        int team2;
+        int winner;
+        int gameId;         // game of the database, -1 if not created
+        std::uint16_t turn; // round of the bracket, from 0
+    };
+
+    Bracket();
+
+    // Seeds are team ids, the best first
+    void Build(const std::vector<int> &seeds, bool doubleElimination, int firstTurn);
+
+    std::uint32_t GetSize() const { return mSize; }
+    std::uint32_t GetMatchCount() const { return static_cast<std::uint32_t>(mMatches.size()); }
+    bool IsValid(std::uint32_t match) const { return (match >= 1U) && (match < mMatches.size()); }
+    const Match &GetMatch(std::uint32_t match) const { return mMatches[match]; }
+    bool IsReady(std::uint32_t match) const;
+    int GetChampion() const;
+
+    // False if a match already played depends on the previous result
+    bool CanSetResult(std::uint32_t match, int winner) const;
+    // Matches whose teams have changed are added to the list
+    bool SetResult(std::uint32_t match, int winner, std::vector<std::uint32_t> &changed);
+
+    void SetGameId(std::uint32_t match, int gameId);
+    // Ready matches that have no game yet
+    std::vector<std::uint32_t> GetMatchesToPlay() const;
+    void MakeGame(std::uint32_t match, int eventId, Game &game) const;
+
+    // Winner of a game with its scores, cNone if not played or a tie
+    static int GetWinner(const Game &game);
+
+    // Ranked teams first, then the others by team number
+    static std::vector<int> Seeds(const std::deque<Rank> &ranking, const std::deque<Team> &teams);
+
+    // Bracket data stored in the JSON documents
+    static int GetMatchId(const Game &game);
+    static void SetMatchId(Game &game, int match);
+    static int GetSeed(const Team &team);
+    static void SetSeed(Team &team, int seed);
+
+private:
+    std::uint32_t mSize;    // N, number of places
+    std::uint32_t mLevels;  // log2(N), rounds of the winners bracket
+    bool mDouble;
+    std::vector<Match> mMatches;
+    std::vector<std::uint32_t> mLosersOffset; // first match of each round of the losers bracket
+
+    std::uint32_t LosersMatch(std::uint32_t round, std::uint32_t index) const;
+    std::uint32_t GrandFinal() const;
+    bool IsAutomatic(std::uint32_t match) const;
+    std::uint32_t WinnerPlace(std::uint32_t match, int &slot) const;
+    std::uint32_t LoserPlace(std::uint32_t match, int &slot) const;
+    bool CanChange(std::uint32_t match) const;
+    void Place(std::uint32_t match, int slot, int team, std::vector<std::uint32_t> &changed);
+    void Decide(std::uint32_t match, int winner, std::vector<std::uint32_t> &changed);
+    void Resolve(std::uint32_t match, std::vector<std::uint32_t> &changed);
+};
+
+#endif // BRACKETS_H
+
+//=============================================================================
+// End of file Brackets.h
+//=============================================================================
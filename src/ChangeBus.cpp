@@ -0,0 +1,61 @@
+/*=============================================================================
+ * Tanca - ChangeBus.cpp
+ *=============================================================================
+ * Coalescing notification of data changes to the views
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include "ChangeBus.h"
+
+ChangeBus::ChangeBus()
+{
+    mTimer.setSingleShot(true);
+    mTimer.setInterval(cFramePeriod);
+    QObject::connect(&mTimer, &QTimer::timeout, [this]() { Flush(); });
+}
+
+void ChangeBus::Post(std::uint8_t entities)
+{
+    mPending.flags |= entities;
+
+    // First change of the frame: schedule the notification
+    if (!mTimer.isActive())
+    {
+        mTimer.start();
+    }
+}
+
+void ChangeBus::Flush()
+{
+    mTimer.stop();
+
+    if (mPending.flags != 0U)
+    {
+        // Changes posted by the observers themselves go to the next frame
+        Change change = mPending;
+        mPending.flags = 0U;
+        Notify(change, change.flags);
+    }
+}
+
+//=============================================================================
+// End of file ChangeBus.cpp
+//=============================================================================
@@ -0,0 +1,110 @@
+/*=============================================================================
+ * Tanca - ChangeBus.h
+ *=============================================================================
+ * Coalescing notification of data changes to the views
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef CHANGE_BUS_H
+#define CHANGE_BUS_H
+
+#include <cstdint>
+#include <functional>
+#include <QTimer>
+
+#include "Observer.h"
+
+/**
+ * @brief Set of entities modified since the last notification
+ *
+ * The flags are also used as the observer mask: an observer is notified
+ * only if one of the entities it renders has changed.
+ */
+struct Change
+{
+    static const std::uint8_t cPlayers  = 0x01U;
+    static const std::uint8_t cTeams    = 0x02U;
+    static const std::uint8_t cGames    = 0x04U;
+    static const std::uint8_t cEvents   = 0x08U;
+    static const std::uint8_t cRewards  = 0x10U;
+
+    std::uint8_t flags;
+
+    Change()
+        : flags(0U)
+    {
+
+    }
+
+    bool Has(std::uint8_t entities) const
+    {
+        return (flags & entities) != 0U;
+    }
+};
+
+/**
+ * @brief Observer calling a function, used to subscribe views without inheritance
+ */
+class ChangeListener : public Observer<Change>
+{
+public:
+    ChangeListener(std::uint8_t mask, std::function<void (const Change &)> callback)
+        : Observer<Change>(mask)
+        , mCallback(callback)
+    {
+
+    }
+
+    void Update(const Change &info)
+    {
+        mCallback(info);
+    }
+
+private:
+    std::function<void (const Change &)> mCallback;
+};
+
+/**
+ * @brief Collects the changes posted during a frame and notifies the observers once
+ *
+ * Several Post() calls in a row (scoring many games, cascading updates...)
+ * result in a single notification with all the flags merged.
+ */
+class ChangeBus : public Subject<Change>
+{
+public:
+    static const int cFramePeriod = 16; // in milliseconds
+
+    ChangeBus();
+
+    void Post(std::uint8_t entities);
+    void Flush();
+
+private:
+    QTimer mTimer;
+    Change mPending;
+};
+
+#endif // CHANGE_BUS_H
+
+//=============================================================================
+// End of file ChangeBus.h
+//=============================================================================
@@ -0,0 +1,175 @@
+/*=============================================================================
+ * Tanca - CityDirectory.cpp
+ *=============================================================================
+ * Postal code to city lookup, memory mapped
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "CityDirectory.h"
+#include "AsyncLog.h"
+#include "Profiler.h"
+
+static const char cMagic[4] = { 'T', 'C', 'T', 'Y' };
+static const std::uint32_t cFormatVersion = 1U;
+static const std::uint32_t cByteOrder = 0x01020304U;
+
+const int CityDirectory::cCodeLength;
+
+struct CityDirectory::Header
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::uint32_t count;     // rows
+    std::uint32_t poolSize;  // bytes of names
+    std::uint32_t reserved;
+};
+
+CityDirectory::CityDirectory()
+    : mCount(0U)
+    , mCodes(nullptr)
+    , mNames(nullptr)
+    , mPool(nullptr)
+{
+
+}
+
+CityDirectory::~CityDirectory()
+{
+    Close();
+}
+
+bool CityDirectory::Open(const QString &fileName)
+{
+    TRACE_SCOPE("cities.Open");
+    Close();
+
+    mFile.setFileName(fileName);
+    if (!mFile.open(QIODevice::ReadOnly) || (mFile.size() < static_cast<qint64>(sizeof(Header))))
+    {
+        Close();
+        return false;
+    }
+
+    std::uint64_t fileSize = static_cast<std::uint64_t>(mFile.size());
+    const std::uint8_t *base = mFile.map(0, mFile.size());
+    if (base == nullptr)
+    {
+        // Compressed resource: no file to map
+        mData = mFile.readAll();
+        fileSize = static_cast<std::uint64_t>(mData.size());
+        base = (fileSize >= sizeof(Header)) ? reinterpret_cast<const std::uint8_t *>(mData.constData()) : nullptr;
+    }
+    const Header *header = reinterpret_cast<const Header *>(base);
+    bool valid = (base != nullptr) &&
+                 (std::memcmp(header->magic, cMagic, sizeof(cMagic)) == 0) &&
+                 (header->version == cFormatVersion) &&
+                 (header->byteOrder == cByteOrder) &&
+                 (fileSize == (sizeof(Header) + (8U * static_cast<std::uint64_t>(header->count)) + header->poolSize));
+
+    const std::int32_t *codes = nullptr;
+    const std::uint32_t *names = nullptr;
+    const char *pool = nullptr;
+
+    if (valid)
+    {
+        codes = reinterpret_cast<const std::int32_t *>(base + sizeof(Header));
+        names = reinterpret_cast<const std::uint32_t *>(codes + header->count);
+        pool = reinterpret_cast<const char *>(names + header->count);
+
+        // Once when opened: the lookups rely on the order and on the terminated names
+        valid = (header->poolSize > 0U) && (pool[header->poolSize - 1U] == '\0');
+        for (std::uint32_t i = 0U; valid && (i < header->count); i++)
+        {
+            valid = (names[i] < header->poolSize) && ((i == 0U) || (codes[i - 1U] <= codes[i]));
+        }
+    }
+
+    if (!valid)
+    {
+        ALogError("Invalid city directory " << fileName.toStdString());
+        Close();
+        return false;
+    }
+
+    mCount = header->count;
+    mCodes = codes;
+    mNames = names;
+    mPool = pool;
+    ALogInfo("City directory: " << mCount << " cities");
+    return true;
+}
+
+void CityDirectory::Close()
+{
+    if (mFile.isOpen())
+    {
+        mFile.close(); // also unmaps
+    }
+    mData.clear();
+    mCount = 0U;
+    mCodes = nullptr;
+    mNames = nullptr;
+    mPool = nullptr;
+}
+
+bool CityDirectory::Find(int postCode, std::uint32_t &first, std::uint32_t &last) const
+{
+    return FindRange(postCode, postCode + 1, first, last);
+}
+
+bool CityDirectory::FindPrefix(int digits, int length, std::uint32_t &first, std::uint32_t &last) const
+{
+    if ((length <= 0) || (length > cCodeLength) || (digits < 0))
+    {
+        return false;
+    }
+
+    int scale = 1;
+    for (int i = length; i < cCodeLength; i++)
+    {
+        scale *= 10;
+    }
+    return FindRange(digits * scale, (digits + 1) * scale, first, last);
+}
+
+// Rows with a code in [low, high)
+bool CityDirectory::FindRange(int low, int high, std::uint32_t &first, std::uint32_t &last) const
+{
+    if (!IsOpen())
+    {
+        return false;
+    }
+
+    const std::int32_t *begin = std::lower_bound(mCodes, mCodes + mCount, low);
+    const std::int32_t *end = std::lower_bound(begin, mCodes + mCount, high);
+
+    first = static_cast<std::uint32_t>(begin - mCodes);
+    last = static_cast<std::uint32_t>(end - mCodes);
+    return first < last;
+}
+
+//=============================================================================
+// End of file CityDirectory.cpp
+//=============================================================================
@@ -0,0 +1,84 @@
+/*=============================================================================
+ * Tanca - CityDirectory.h
+ *=============================================================================
+ * Postal code to city lookup, memory mapped
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef CITY_DIRECTORY_H
+#define CITY_DIRECTORY_H
+
+#include <cstdint>
+#include <QFile>
+#include <QByteArray>
+
+/**
+ * @brief Cities of the postal codes, read in place from a compact file
+ *
+ * The file (made by scripts/make_cities.py) is a header, the postal codes
+ * sorted in ascending order, the offset of the name of each row, then the
+ * names (UTF-8, zero terminated). Several rows share a code when it serves
+ * several cities.
+ *
+ * A lookup is a binary search over the codes: no allocation, and the names
+ * point into the mapped file. The file compiled in the resources is used in
+ * place too, or read once in memory if it was compressed.
+ */
+class CityDirectory
+{
+public:
+    static const int cCodeLength = 5; // digits of a postal code
+
+    CityDirectory();
+    ~CityDirectory();
+
+    bool Open(const QString &fileName);
+    void Close();
+    bool IsOpen() const { return mCodes != nullptr; }
+
+    std::uint32_t Count() const { return mCount; }
+
+    // Rows [first, last) of a postal code, false if none
+    bool Find(int postCode, std::uint32_t &first, std::uint32_t &last) const;
+    // Rows of all the codes starting with the digits typed so far ("75" is 75000 to 75999)
+    bool FindPrefix(int digits, int length, std::uint32_t &first, std::uint32_t &last) const;
+
+    int GetPostCode(std::uint32_t row) const { return mCodes[row]; }
+    const char *GetCity(std::uint32_t row) const { return mPool + mNames[row]; }
+
+private:
+    struct Header;
+
+    QFile mFile;
+    QByteArray mData; // content of the file when it cannot be mapped
+    std::uint32_t mCount;
+    const std::int32_t *mCodes;
+    const std::uint32_t *mNames;
+    const char *mPool;
+
+    bool FindRange(int low, int high, std::uint32_t &first, std::uint32_t &last) const;
+};
+
+#endif // CITY_DIRECTORY_H
+
+//=============================================================================
+// End of file CityDirectory.h
+//=============================================================================
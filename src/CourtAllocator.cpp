@@ -0,0 +1,274 @@
+/*=============================================================================
+ * Tanca - CourtAllocator.cpp
+ *=============================================================================
+ * Assignment of the games of a round to the courts (terrains)
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+#include "CourtAllocator.h"
+#include "DocumentField.h"
+#include "Profiler.h"
+
+static const char *cCourtKey = "court";
+static const char *cCourtsKey = "courts";
+
+/*****************************************************************************/
+CourtAllocator::CourtAllocator(std::uint32_t nbCourts)
+    : mCourts(nbCourts)
+{
+
+}
+
+int CourtAllocator::GetCourt(const Game &game)
+{
+    return DocumentField::GetInteger(game.document, cCourtKey, 0);
+}
+
+void CourtAllocator::SetCourt(Game &game, int court)
+{
+    DocumentField::SetInteger(game.document, cCourtKey, court);
+}
+
+std::uint32_t CourtAllocator::GetCourts(const Event &event)
+{
+    int courts = DocumentField::GetInteger(event.document, cCourtsKey, 0);
+    return (courts > 0) ? static_cast<std::uint32_t>(courts) : 0U;
+}
+
+void CourtAllocator::SetCourts(Event &event, std::uint32_t courts)
+{
+    DocumentField::SetInteger(event.document, cCourtsKey, static_cast<int>(courts));
+}
+
+void CourtAllocator::AddGame(int teamId, int court)
+{
+    if ((teamId != Team::cDummyTeam) && (court >= 1) && (court <= static_cast<int>(mCourts)))
+    {
+        std::vector<std::uint16_t> &counts = mHistory[teamId];
+        counts.resize(mCourts, 0U);
+        counts[court - 1]++;
+    }
+}
+
+std::uint32_t CourtAllocator::CountGames(int teamId, std::uint32_t court) const
+{
+    auto it = mHistory.find(teamId);
+    return (it == mHistory.end()) ? 0U : it->second[court];
+}
+
+void CourtAllocator::AddHistory(const std::deque<Game> &games)
+{
+    for (auto const &game : games)
+    {
+        int court = GetCourt(game);
+        AddGame(game.team1Id, court);
+        AddGame(game.team2Id, court);
+    }
+}
+
+void CourtAllocator::Assign(std::deque<Game> &games)
+{
+    std::map<int, std::vector<Game *>> rounds; // ordered by turn
+
+    for (auto &game : games)
+    {
+        rounds[game.turn].push_back(&game);
+    }
+
+    for (auto &r : rounds)
+    {
+        AssignRound(r.second);
+    }
+}
+
+/**
+ * @brief Hungarian algorithm (shortest augmenting paths with potentials)
+ *
+ * Rows are the games, columns are the places: court c for the wave w is the
+ * column w * courts + c. Complexity O(games² x places), a few milliseconds for
+ * 200 games.
+ */
+void CourtAllocator::AssignRound(const std::vector<Game *> &round)
+{
+    std::vector<Game *> games;
+
+    for (auto game : round)
+    {
+        if (!game->HasBye())
+        {
+            games.push_back(game);
+        }
+    }
+
+    if ((games.size() == 0U) || (mCourts == 0U))
+    {
+        return;
+    }
+
+    TRACE_SCOPE("courts.AssignRound");
+    const std::uint32_t n = static_cast<std::uint32_t>(games.size());
+    const std::uint32_t waves = (n + mCourts - 1U) / mCourts;
+    const std::uint32_t m = waves * mCourts;
+    const std::int64_t cInfinite = std::numeric_limits<std::int64_t>::max() / 2;
+
+    // Cost of a game on a court: games already played there by its teams
+    std::vector<std::int64_t> cost(n * mCourts);
+    for (std::uint32_t i = 0; i < n; i++)
+    {
+        for (std::uint32_t c = 0; c < mCourts; c++)
+        {
+            cost[i * mCourts + c] = CountGames(games[i]->team1Id, c) + CountGames(games[i]->team2Id, c);
+        }
+    }
+
+    // 1-based arrays, index 0 is the virtual start of the augmenting path
+    std::vector<std::int64_t> u(n + 1U, 0);
+    std::vector<std::int64_t> v(m + 1U, 0);
+    std::vector<std::uint32_t> place(m + 1U, 0U); // place -> game
+    std::vector<std::uint32_t> way(m + 1U, 0U);
+    std::vector<std::int64_t> minv(m + 1U);
+    std::vector<bool> used(m + 1U);
+
+    for (std::uint32_t i = 1; i <= n; i++)
+    {
+        place[0] = i;
+        std::uint32_t j0 = 0;
+        std::fill(minv.begin(), minv.end(), cInfinite);
+        std::fill(used.begin(), used.end(), false);
+
+        do
+        {
+            used[j0] = true;
+            std::uint32_t i0 = place[j0];
+            std::int64_t delta = cInfinite;
+            std::uint32_t j1 = 0;
+
+            for (std::uint32_t j = 1; j <= m; j++)
+            {
+                if (!used[j])
+                {
+                    std::int64_t cur = cost[(i0 - 1U) * mCourts + ((j - 1U) % mCourts)] - u[i0] - v[j];
+                    if (cur < minv[j])
+                    {
+                        minv[j] = cur;
+                        way[j] = j0;
+                    }
+                    if (minv[j] < delta)
+                    {
+                        delta = minv[j];
+                        j1 = j;
+                    }
+                }
+            }
+
+            for (std::uint32_t j = 0; j <= m; j++)
+            {
+                if (used[j])
+                {
+                    u[place[j]] += delta;
+                    v[j] -= delta;
+                }
+                else
+                {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        }
+        while (place[j0] != 0U);
+
+        // Follow the augmenting path back
+        do
+        {
+            std::uint32_t j1 = way[j0];
+            place[j0] = place[j1];
+            j0 = j1;
+        }
+        while (j0 != 0U);
+    }
+
+    for (std::uint32_t j = 1; j <= m; j++)
+    {
+        if (place[j] != 0U)
+        {
+            Game *game = games[place[j] - 1U];
+            int court = static_cast<int>((j - 1U) % mCourts) + 1;
+
+            SetCourt(*game, court);
+            AddGame(game->team1Id, court);
+            AddGame(game->team2Id, court);
+        }
+    }
+}
+
+/*****************************************************************************/
+CourtStream::CourtStream(CourtAllocator &allocator, std::function<Game *()> source)
+    : mAllocator(allocator)
+    , mSource(source)
+    , mNext(0U)
+    , mHasPending(false)
+{
+
+}
+
+Game *CourtStream::Next()
+{
+    if (mNext == mRound.size())
+    {
+        // Read the whole next round
+        mRound.clear();
+        mNext = 0U;
+
+        if (mHasPending)
+        {
+            mRound.push_back(mPending);
+            mHasPending = false;
+        }
+
+        for (Game *game = mSource(); game != nullptr; game = mSource())
+        {
+            if ((mRound.size() > 0U) && (game->turn != mRound.front().turn))
+            {
+                mPending = *game;
+                mHasPending = true;
+                break;
+            }
+            mRound.push_back(*game);
+        }
+
+        std::vector<Game *> round;
+        for (auto &game : mRound)
+        {
+            round.push_back(&game);
+        }
+        mAllocator.AssignRound(round);
+    }
+
+    return (mNext < mRound.size()) ? &mRound[mNext++] : nullptr;
+}
+
+//=============================================================================
+// End of file CourtAllocator.cpp
+//=============================================================================
@@ -0,0 +1,102 @@
+/*=============================================================================
+ * Tanca - CourtAllocator.h
+ *=============================================================================
+ * Assignment of the games of a round to the courts (terrains)
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef COURT_ALLOCATOR_H
+#define COURT_ALLOCATOR_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "IDataBase.h"
+
+/**
+ * @brief Gives a court to each game so that the teams change courts as much as possible
+ *
+ * The courts are numbered from 1 to the number of courts of the event; the
+ * court of a game is stored in its JSON document, 0 means no court. A round
+ * is an assignment problem: each game costs the number of times its teams
+ * have already played on a court, solved exactly with the Hungarian
+ * algorithm. With more games than courts, the games wait for a free court:
+ * each court then receives several games of the same round.
+ */
+class CourtAllocator
+{
+public:
+    explicit CourtAllocator(std::uint32_t nbCourts);
+
+    std::uint32_t GetCourts() const { return mCourts; }
+
+    // Courts already used by the teams, in the previous rounds
+    void AddHistory(const std::deque<Game> &games);
+
+    // Give a court to the games, round after round. Byes get no court.
+    void Assign(std::deque<Game> &games);
+    void AssignRound(const std::vector<Game *> &round);
+
+    static int GetCourt(const Game &game);
+    static void SetCourt(Game &game, int court);
+
+    // Number of courts of an event, 0 to disable the allocation
+    static std::uint32_t GetCourts(const Event &event);
+    static void SetCourts(Event &event, std::uint32_t courts);
+
+private:
+    std::uint32_t mCourts;
+    std::unordered_map<int, std::vector<std::uint16_t>> mHistory; // team id -> games played on each court
+
+    void AddGame(int teamId, int court);
+    std::uint32_t CountGames(int teamId, std::uint32_t court) const;
+};
+
+/**
+ * @brief Adds the courts to a stream of games, one round at a time
+ *
+ * The games of a round must follow each other, as produced by RoundRobinStream.
+ */
+class CourtStream
+{
+public:
+    CourtStream(CourtAllocator &allocator, std::function<Game *()> source);
+
+    // Next game with its court, or nullptr at the end of the source
+    Game *Next();
+
+private:
+    CourtAllocator &mAllocator;
+    std::function<Game *()> mSource;
+    std::deque<Game> mRound;
+    std::uint32_t mNext;
+    Game mPending; // first game of the next round
+    bool mHasPending;
+};
+
+#endif // COURT_ALLOCATOR_H
+
+//=============================================================================
+// End of file CourtAllocator.h
+//=============================================================================
@@ -1,15 +1,26 @@
+#include <set>
+
 #include "DbManager.h"
 #include "Log.h"
 #include <QSqlError>
 #include <QSqlRecord>
-#include <QDebug>
 #include <QUuid>
-#include <iostream>
 #include "Util.h"
+#include "AsyncLog.h"
+#include "Profiler.h"
 
 /**
  * History of changes
  *
+ * 1.5
+ *      - Added an index on the 'rewards' table (totals per event)
+ *
+ * 1.4
+ *      - Added 'score_log' table (every change of a game)
+ *
+ * 1.3
+ *      - Added 'ratings' and 'rating_deltas' tables (Elo rating of the players)
+ *
  * 1.2
  *      - Converted type "Club championship" into Round Robin
  *      - Added "Season Ranking" option in Event
@@ -25,6 +36,10 @@ static const QString gBaseVersion = "0.0";
 static const QString gVersion1_0 = "1.0";
 static const QString gVersion1_1 = "1.1";
 static const QString gVersion1_2 = "1.2";
+static const QString gVersion1_3 = "1.3";
+static const QString gVersion1_4 = "1.4";
+static const QString gVersion1_5 = "1.5";
+static const QString gCurrentVersion = gVersion1_5; // last step of Upgrade()
 
 
 static QString PlayersTable() {
@@ -52,6 +67,19 @@ static QString GamesTable() {
             "team2_id INTEGER, team1_score INTEGER, team2_score INTEGER, state INTEGER, document TEXT);";
 }
 
+static QString RatingsTable() {
+    return "CREATE TABLE IF NOT EXISTS ratings (player_id INTEGER PRIMARY KEY, rating REAL, games INTEGER, document TEXT);";
+}
+
+static QString RatingDeltasTable() {
+    return "CREATE TABLE IF NOT EXISTS rating_deltas (game_id INTEGER PRIMARY KEY, delta REAL);";
+}
+
+static QString ScoreLogTable() {
+    return "CREATE TABLE IF NOT EXISTS score_log (seq INTEGER PRIMARY KEY AUTOINCREMENT, event_id INTEGER, game_id INTEGER, kind INTEGER, "
+           "turn INTEGER, team1_id INTEGER, team2_id INTEGER, old_score1 INTEGER, old_score2 INTEGER, "
+           "new_score1 INTEGER, new_score2 INTEGER, undo_of INTEGER, date TEXT);";
+}
 
 static QStringList MakeTables()
 {
@@ -63,6 +91,9 @@ static QStringList MakeTables()
     tables << GamesTable();
     tables << Infos::Table();
     tables << RewardsTable();
+    tables << RatingsTable();
+    tables << RatingDeltasTable();
+    tables << ScoreLogTable();
 
     return tables;
 }
@@ -79,8 +110,19 @@ DbManager::DbManager(const QString &path)
 
 DbManager::~DbManager()
 {
+    // The last requested backup is finished before the connection is closed
+    mBackup.Stop();
+
     if (mDb.isOpen())
     {
+        // Leave a single up to date file: the write-ahead log goes back into the database
+        {
+            QSqlQuery checkpoint("PRAGMA wal_checkpoint(TRUNCATE)", mDb);
+            if (!checkpoint.isActive())
+            {
+                ALogWarning("Database: final checkpoint failed");
+            }
+        }
         mDb.close();
     }
 }
@@ -95,7 +137,7 @@ bool DbManager::EditInfos()
 
     if(query.exec())
     {
-        qDebug() << "Updgraded DB version to " << mInfos.version;
+        ALogInfo("Updgraded DB version to " << mInfos.version.toStdString());
         success = true;
     }
     else
@@ -129,7 +171,7 @@ void DbManager::Upgrade()
 
                 if(query.exec())
                 {
-                    qDebug() << "Add some info field success";
+                    ALogInfo("Add some info field success");
                 }
                 else
                 {
@@ -146,7 +188,7 @@ void DbManager::Upgrade()
         query.prepare("ALTER TABLE teams ADD COLUMN number INTEGER DEFAULT 0");
         if(query.exec())
         {
-            qDebug() << "Upgrade table 'teams' to 1.0 success";
+            ALogInfo("Upgrade table 'teams' to 1.0 success");
         }
         mInfos.version = gVersion1_0;
         EditInfos();
@@ -162,7 +204,7 @@ void DbManager::Upgrade()
 
         if(AddPlayer(p, Player::cDummyPlayer))
         {
-            qDebug() << "Upgrade table 'teams' to 1.1 success";
+            ALogInfo("Upgrade table 'teams' to 1.1 success");
         }
         mInfos.version = gVersion1_1;
         EditInfos();
@@ -174,98 +216,205 @@ void DbManager::Upgrade()
         query.prepare("ALTER TABLE events ADD COLUMN option INTEGER DEFAULT 0");
         if(query.exec())
         {
-            qDebug() << "Upgrade table 'events' to 1.2 success";
+            ALogInfo("Upgrade table 'events' to 1.2 success");
             // Then update the type (RoundRobin = 1 is now 0)
             query.prepare("UPDATE TABLE events SET type = 0 WHERE type = 1");
             if(query.exec())
             {
-                qDebug() << "Upgrade table 'events' to 1.2 success";
+                ALogInfo("Upgrade table 'events' to 1.2 success");
             }
         }
 
         mInfos.version = gVersion1_2;
         EditInfos();
     }
+
+    if (mInfos.version == gVersion1_2)
+    {
+        // Upgrade to the 1.3: the rating tables are created empty, the
+        // ratings are computed from the history when first needed
+        ALogInfo("Upgrade to 1.3: rating tables added");
+        mInfos.version = gVersion1_3;
+        EditInfos();
+    }
+
+    if (mInfos.version == gVersion1_3)
+    {
+        // Upgrade to the 1.4: the score log starts with the games already stored
+        query.prepare("CREATE INDEX IF NOT EXISTS score_log_event ON score_log (event_id, seq)");
+        if (!query.exec())
+        {
+            ALogError("Create score log index failed: " << query.lastError().text().toStdString());
+        }
+
+        query.prepare("INSERT INTO score_log (event_id, game_id, kind, turn, team1_id, team2_id, old_score1, old_score2, new_score1, new_score2, undo_of, date) "
+                      "SELECT event_id, id, 0, turn, team1_id, team2_id, -1, -1, team1_score, team2_score, 0, datetime('now') FROM games ORDER BY id");
+        if (query.exec())
+        {
+            ALogInfo("Upgrade to 1.4: score log added");
+        }
+        mInfos.version = gVersion1_4;
+        EditInfos();
+    }
+
+    if (mInfos.version == gVersion1_4)
+    {
+        // Upgrade to the 1.5: the reward totals are grouped per event
+        query.prepare("CREATE INDEX IF NOT EXISTS rewards_event ON rewards (event_id, team_id)");
+        if (query.exec())
+        {
+            ALogInfo("Upgrade to 1.5: rewards index added");
+        }
+        else
+        {
+            ALogError("Create rewards index failed: " << query.lastError().text().toStdString());
+        }
+        mInfos.version = gVersion1_5;
+        EditInfos();
+    }
 }
 
-void DbManager::Initialize()
+/**
+ * @brief Read the version of the schema, empty for a new file
+ */
+QString DbManager::ReadVersion()
 {
-    if (mDb.open())
+    // Fails on a new file, the infos table does not exist yet
+    QSqlQuery query("SELECT version FROM infos", mDb);
+    if (query.next())
     {
-        qDebug() << "Database: connection ok";
+        mInfos.version = query.value(0).toString();
+    }
+    return mInfos.version;
+}
 
-        // Create tables if it is a new file
-        QStringList gTables = MakeTables();
-        for (int i = 0; i < gTables.size(); i++)
+/**
+ * @brief Create the missing tables (new file or new version)
+ */
+void DbManager::CreateTables()
+{
+    QStringList gTables = MakeTables();
+    for (int i = 0; i < gTables.size(); i++)
+    {
+        // retrieve the table name
+        QRegularExpression re("EXISTS (\\w+) \\(");
+        QRegularExpressionMatch match = re.match(gTables[i]);
+        if (match.hasMatch())
         {
-            // retrieve the table name
-            QRegularExpression re("EXISTS (\\w+) \\(");
-            QRegularExpressionMatch match = re.match(gTables[i]);
-            if (match.hasMatch())
-            {
-                QString tableName = match.captured(1);
-                // Test if table exists
-                QString testTable = "SELECT name FROM sqlite_master WHERE type='table' AND name='" + tableName + "'";
+            QString tableName = match.captured(1);
+            // Test if table exists
+            QString testTable = "SELECT name FROM sqlite_master WHERE type='table' AND name='" + tableName + "'";
 
-                QSqlQuery testQuery(testTable, mDb);
-                if (testQuery.exec())
+            QSqlQuery testQuery(testTable, mDb);
+            if (testQuery.exec())
+            {
+                if (testQuery.next())
                 {
-                    if (testQuery.next())
+                    ALogDebug("Found table: " << tableName.toStdString());
+                }
+                else
+                {
+                    QSqlQuery query(gTables[i], mDb);
+                    if(!query.exec())
                     {
-                        qDebug() << "Found table: " << tableName;
+                        ALogError("Create table failed: " << query.lastError().text().toStdString());
                     }
                     else
                     {
-                        QSqlQuery query(gTables[i], mDb);
-                        if(!query.exec())
-                        {
-                            qDebug() << "Create table failed: " << query.lastError();
-                        }
-                        else
-                        {
-                            qDebug() << "Created table: " << tableName;
-                        }
+                        ALogInfo("Created table: " << tableName.toStdString());
                     }
                 }
-                else
-                {
-                    qDebug() << "Cannot search for table: " << tableName;
-                }
             }
+            else
+            {
+                ALogError("Cannot search for table: " << tableName.toStdString());
+            }
+        }
+    }
+}
+
+void DbManager::Initialize()
+{
+    TRACE_SCOPE("db.Initialize");
+    if (mDb.open())
+    {
+        ALogInfo("Database: connection ok");
+
+        // Write-ahead log: the backup connection reads while the scores are written
+        QSqlQuery wal("PRAGMA journal_mode=WAL", mDb);
+        if (!wal.next() || (wal.value(0).toString() != "wal"))
+        {
+            ALogWarning("Database: WAL journal mode not available");
         }
 
-        Upgrade();
+        // Schema already up to date: no table check nor upgrade at each launch
+        if (ReadVersion() != gCurrentVersion)
+        {
+            CreateTables();
+            Upgrade();
+        }
         UpdatePlayerList();
+        OpenArchives();
+
+        QString backupDir = QFileInfo(mDb.databaseName()).absolutePath() + "/backups";
+        QDir().mkpath(backupDir);
+        mBackup.Start(mDb.databaseName().toStdString(), backupDir.toStdString());
     }
     else
     {
-       qDebug() << "Error: connection with database fail";
+       ALogError("Connection with database fail");
     }
 
-    // Initialize the Cities DB
-    mCities = QSqlDatabase::addDatabase("QSQLITE", "cities");
-    mCities.setDatabaseName("~/Tanca/villes.db"); // FIXME: use the executable path
-}
-
-std::deque<Player> &DbManager::GetPlayerList()
-{
-    return mPlayers;
+    // Postal codes: a newer file next to the database or the executable, else the one compiled in
+    if (!mCityDirectory.Open(QFileInfo(mDb.databaseName()).absolutePath() + "/cities.bin") &&
+        !mCityDirectory.Open(QCoreApplication::applicationDirPath() + "/cities.bin") &&
+        !mCityDirectory.Open(":/data/cities.bin"))
+    {
+        ALogWarning("No city directory, the cities are not completed (built without assets/cities.bin)");
+    }
 }
 
-bool DbManager::PlayerExists(const Player &player) const
+/**
+ * @brief Give all the fields of each player to the visitor, one row at a time
+ *
+ * Only the names are kept in memory (see GetPlayers()), the full list of a
+ * large base is never copied.
+ */
+void DbManager::VisitPlayers(const std::function<void (const Player &)> &visit) const
 {
-    bool found = false;
+    TRACE_SCOPE("db.VisitPlayers");
+    QSqlQuery query(mDb);
+    query.setForwardOnly(true); // the rows already read are not kept
+    query.exec("SELECT * FROM players ORDER BY id");
 
-    foreach (Player p, mPlayers)
+    Player player;
+    while (query.next())
     {
-        if ((Util::ToLower(p.lastName) == Util::ToLower(player.lastName) &&
-            (Util::ToLower(p.name) == Util::ToLower(player.name))))
+        FillFrom(query, player);
+        if (player.id != Player::cDummyPlayer)
         {
-            found = true;
-            break;
+            visit(player);
         }
     }
-    return found;
+}
+
+SearchIndex &DbManager::GetPlayerIndex()
+{
+    return mPlayerIndex;
+}
+
+/**
+ * @brief Same first and last names (case and accents ignored), no allocation
+ */
+bool DbManager::PlayerExists(const Player &player) const
+{
+    return mDuplicates.HasName(player);
+}
+
+std::vector<DuplicateMatch> DbManager::FindDuplicates(const Player &player) const
+{
+    TRACE_SCOPE("db.FindDuplicates");
+    return mDuplicates.Find(player);
 }
 
 bool DbManager::DeletePlayer(int id)
@@ -278,7 +427,7 @@ bool DbManager::DeletePlayer(int id)
 
     if(query.exec())
     {
-        qDebug() << "Delete player success";
+        ALogDebug("Delete player success");
         success = true;
         UpdatePlayerList();
     }
@@ -290,42 +439,84 @@ bool DbManager::DeletePlayer(int id)
     return success;
 }
 
+/**
+ * @brief Reload the names kept in memory and the indexes, row after row
+ *
+ * The other fields are read again from the base when needed.
+ */
 void DbManager::UpdatePlayerList()
 {
-    QSqlQuery query("SELECT * FROM players", mDb);
-    mPlayers.clear();
+    TRACE_SCOPE("db.UpdatePlayerList");
+    QSqlQuery query(mDb);
+    query.setForwardOnly(true);
+    query.exec("SELECT * FROM players ORDER BY id");
+    mPlayers.Clear();
+    mPlayerIndex.Clear();
+    mDuplicates.Clear();
 
+    Player player;
     while (query.next())
     {
-        Player player;
-
-        player.id = query.value("id").toInt();
-        player.uuid = query.value("uuid").toString().toStdString();
-        player.name = query.value("name").toString().toStdString();
-        player.lastName = query.value("last_name").toString().toStdString();
-        player.nickName = query.value("nick_name").toString().toStdString();
-        player.email = query.value("email").toString().toStdString();
-        player.mobilePhone = query.value("mobile_phone").toString().toStdString();
-        player.homePhone = query.value("home_phone").toString().toStdString();
-        player.birthDate = Util::FromISODate(query.value("birth_date").toString().toStdString());
-        player.road = query.value("road").toString().toStdString();
-        player.postCode = query.value("post_code").toInt();
-        player.city = query.value("city").toString().toStdString();
-        player.membership = query.value("membership").toString().toStdString();
-        player.comments = query.value("comments").toString().toStdString();
-        player.state = query.value("state").toInt();
-        player.document = query.value("document").toString().toStdString();
+        FillFrom(query, player);
 
         if (player.id != Player::cDummyPlayer)
         {
-            mPlayers.push_back(player);
+            mPlayers.Add(player);
+            mPlayerIndex.Add(player);
+            mDuplicates.Add(player);
         }
     }
+
+    mPlayers.Finish();
+    mPlayerIndex.Finish();
+    mDuplicates.Finish();
+    mLabels.InvalidatePlayers();
+    ALogDebug("Player list: " << mPlayers.Size() << " players, " << mPlayers.MemoryUsage() << " bytes, index "
+              << mPlayerIndex.MemoryUsage() << " bytes, duplicates " << mDuplicates.MemoryUsage() << " bytes");
 }
 
 bool DbManager::FindPlayer(int id, Player &player) const
 {
-    return Player::Find(mPlayers, id, player);
+    if (id == Player::cDummyPlayer)
+    {
+        player = Player::Dummy();
+        return true;
+    }
+
+    if (!mPlayers.Contains(id))
+    {
+        return false;
+    }
+
+    QSqlQuery query(mDb);
+    query.prepare("SELECT * FROM players WHERE id = :id");
+    query.bindValue(":id", id);
+
+    bool found = query.exec() && query.next();
+    if (found)
+    {
+        FillFrom(query, player);
+    }
+    return found;
+}
+
+static void BindNewPlayer(QSqlQuery &query, const Player &player)
+{
+    query.bindValue(":uuid", QUuid::createUuid().toString());
+    query.bindValue(":name", player.name.c_str());
+    query.bindValue(":last_name", player.lastName.c_str());
+    query.bindValue(":nick_name", player.nickName.c_str());
+    query.bindValue(":email", player.email.c_str());
+    query.bindValue(":mobile_phone", player.mobilePhone.c_str());
+    query.bindValue(":home_phone", player.homePhone.c_str());
+    query.bindValue(":birth_date", Util::ToISODateTime(player.birthDate).c_str());
+    query.bindValue(":road", player.road.c_str());
+    query.bindValue(":post_code", player.postCode);
+    query.bindValue(":city", player.city.c_str());
+    query.bindValue(":membership", player.membership.c_str());
+    query.bindValue(":comments", player.comments.c_str());
+    query.bindValue(":state", player.state);
+    query.bindValue(":document", player.document.c_str());
 }
 
 bool DbManager::AddPlayer(const Player& player, int id)
@@ -353,32 +544,16 @@ bool DbManager::AddPlayer(const Player& player, int id)
         cmd += ", :document)";
 
         queryAdd.prepare(cmd);
-
-        queryAdd.bindValue(":uuid", QUuid::createUuid().toString());
-        queryAdd.bindValue(":name", player.name.c_str());
-        queryAdd.bindValue(":last_name", player.lastName.c_str());
-        queryAdd.bindValue(":nick_name", player.nickName.c_str());
-        queryAdd.bindValue(":email", player.email.c_str());
-        queryAdd.bindValue(":mobile_phone", player.mobilePhone.c_str());
-        queryAdd.bindValue(":home_phone", player.homePhone.c_str());
-        queryAdd.bindValue(":birth_date", Util::ToISODateTime(player.birthDate).c_str());
-        queryAdd.bindValue(":road", player.road.c_str());
-        queryAdd.bindValue(":post_code", player.postCode);
-        queryAdd.bindValue(":city", player.city.c_str());
-        queryAdd.bindValue(":membership", player.membership.c_str());
-        queryAdd.bindValue(":comments", player.comments.c_str());
-        queryAdd.bindValue(":state", player.state);
+        BindNewPlayer(queryAdd, player);
 
         if (id >= 0)
         {
             queryAdd.bindValue(":id", id);
         }
 
-        queryAdd.bindValue(":document", player.document.c_str());
-
         if(queryAdd.exec())
         {
-            qDebug() << "Add player success with id: " << id;
+            ALogDebug("Add player success with id: " << id);
             success = true;
             UpdatePlayerList();
         }
@@ -395,6 +570,44 @@ bool DbManager::AddPlayer(const Player& player, int id)
     return success;
 }
 
+/**
+ * @brief Import: all the players in one transaction, the cached list is reloaded once
+ */
+bool DbManager::AddPlayers(const std::deque<Player> &players)
+{
+    TRACE_SCOPE("db.AddPlayers");
+    bool success = true;
+
+    mDb.transaction();
+    QSqlQuery queryAdd(mDb);
+    queryAdd.prepare("INSERT INTO players (uuid, name, last_name, nick_name, email, mobile_phone, home_phone, birth_date, road, post_code, city, membership, comments, state, document) "
+                     "VALUES (:uuid, :name, :last_name, :nick_name, :email, :mobile_phone, :home_phone, :birth_date, :road, :post_code, :city, :membership, :comments, :state, :document)");
+
+    for (auto const &player : players)
+    {
+        BindNewPlayer(queryAdd, player);
+        if (!IsValid(player) || !queryAdd.exec())
+        {
+            TLogError("Add players failed for " + player.FullName() + ": " + queryAdd.lastError().text().toStdString());
+            success = false;
+            break;
+        }
+    }
+
+    if (success)
+    {
+        success = mDb.commit();
+        ALogDebug("Add players success: " << players.size());
+    }
+    else
+    {
+        mDb.rollback();
+    }
+
+    UpdatePlayerList();
+    return success;
+}
+
 bool DbManager::EditPlayer(const Player& player)
 {
     bool success = false;
@@ -425,7 +638,7 @@ bool DbManager::EditPlayer(const Player& player)
 
         if(queryEdit.exec())
         {
-            qDebug() << "Edit player success";
+            ALogDebug("Edit player success");
             success = true;
             UpdatePlayerList();
         }
@@ -448,12 +661,14 @@ QStringList DbManager::GetSeasons()
     QSqlQuery query(mDb);
     QStringList result;
 
+    std::set<int> years;
+
     query.prepare("SELECT DISTINCT year FROM events");
     if(query.exec())
     {
         while (query.next())
         {
-            result.append(query.value(0).toString());
+            years.insert(query.value(0).toInt());
         }
     }
     else
@@ -461,6 +676,16 @@ QStringList DbManager::GetSeasons()
         TLogError("Get seasons failed: " + query.lastError().text().toStdString());
     }
 
+    for (auto const &a : mArchives)
+    {
+        years.insert(a.first);
+    }
+
+    // Oldest first, the current season is the last one
+    for (auto year : years)
+    {
+        result.append(QString::number(year));
+    }
     return result;
 }
 
@@ -468,6 +693,12 @@ bool DbManager::UpdateEventState(const Event &event)
 {
     bool success = false;
 
+    if (IsArchived(event.id))
+    {
+        TLogError("Edit event state failed: the season is closed");
+        return false;
+    }
+
     QSqlQuery queryEdit(mDb);
     queryEdit.prepare("UPDATE events SET state = :state WHERE id = :id");
     queryEdit.bindValue(":id", event.id);
@@ -475,7 +706,7 @@ bool DbManager::UpdateEventState(const Event &event)
 
     if(queryEdit.exec())
     {
-        qDebug() << "Edit event state success";
+        ALogDebug("Edit event state success");
         success = true;
     }
     else
@@ -488,8 +719,18 @@ bool DbManager::UpdateEventState(const Event &event)
 
 QStringList DbManager::GetCities(int postCode)
 {
-    (void) postCode; // FIXME
-    return QStringList();
+    QStringList cities;
+    std::uint32_t first;
+    std::uint32_t last;
+
+    if (mCityDirectory.Find(postCode, first, last))
+    {
+        for (std::uint32_t i = first; i < last; i++)
+        {
+            cities << QString::fromUtf8(mCityDirectory.GetCity(i));
+        }
+    }
+    return cities;
 }
 
 bool DbManager::IsValid(const Player& player)
@@ -508,6 +749,12 @@ bool DbManager::AddEvent(const Event& event)
 {
     bool success = false;
 
+    if (GetArchive(event.year) != nullptr)
+    {
+        TLogError("Add event failed: the season is closed");
+        return false;
+    }
+
     QSqlQuery queryAdd(mDb);
     queryAdd.prepare("INSERT INTO events (year, date, title, state, type, option, document) VALUES (:year, :date, :title, :state, :type, :option, :document)");
 
@@ -521,7 +768,7 @@ bool DbManager::AddEvent(const Event& event)
 
     if(queryAdd.exec())
     {
-        qDebug() << "Add event success";
+        ALogDebug("Add event success");
         success = true;
     }
     else
@@ -536,6 +783,12 @@ bool DbManager::EditEvent(const Event& event)
 {
     bool success = false;
 
+    if (IsArchived(event.id))
+    {
+        TLogError("Edit event failed: the season is closed");
+        return false;
+    }
+
     QSqlQuery queryEdit(mDb);
 
     queryEdit.prepare("UPDATE events SET year = :year, date = :date, title = :title, state = :state, type = :type, option = :option, document = :document WHERE id = :id");
@@ -551,7 +804,7 @@ bool DbManager::EditEvent(const Event& event)
 
     if(queryEdit.exec())
     {
-        qDebug() << "Edit event success";
+        ALogDebug("Edit event success");
         success = true;
     }
     else
@@ -563,6 +816,12 @@ bool DbManager::EditEvent(const Event& event)
 
 Event DbManager::GetEvent(int id)
 {
+    const SeasonArchive *archive = FindArchive(id);
+    if (archive != nullptr)
+    {
+        return archive->GetEvent(id);
+    }
+
     Event event;
 
     QSqlQuery query(mDb);
@@ -593,6 +852,13 @@ Event DbManager::GetEvent(int id)
 
 std::deque<Event> DbManager::GetEvents(int year)
 {
+    TRACE_SCOPE("db.GetEvents");
+    const SeasonArchive *archive = GetArchive(year);
+    if (archive != nullptr)
+    {
+        return archive->GetEvents();
+    }
+
     QSqlQuery query(mDb);
     query.prepare("SELECT * FROM events WHERE year = :year");
     query.bindValue(":year", year);
@@ -622,13 +888,19 @@ bool DbManager::DeleteEvent(int id)
 {
     bool success = false;
 
+    if (IsArchived(id))
+    {
+        TLogError("Delete event failed: the season is closed");
+        return false;
+    }
+
     QSqlQuery query(mDb);
     query.prepare("DELETE FROM events WHERE id= :id");
     query.bindValue(":id", id);
 
     if(query.exec())
     {
-        qDebug() << "Delete event success";
+        ALogDebug("Delete event success");
         success = true;
     }
     else
@@ -640,42 +912,98 @@ bool DbManager::DeleteEvent(int id)
 }
 
 
-bool DbManager::AddGames(const std::deque<Game>& games)
+/**
+ * @brief Store a list of games in one transaction
+ *
+ * On success, the id of each game is updated with the one given by the database.
+ */
+bool DbManager::AddGames(std::deque<Game>& games)
+{
+    std::size_t i = 0U;
+    return AddGames([&games, &i]() -> Game * {
+        return (i < games.size()) ? &games[i++] : nullptr;
+    });
+}
+
+/**
+ * @brief Insert the games given by a producer, in one transaction
+ *
+ * The producer returns the next game to insert (its id is set once stored),
+ * nullptr when finished, so the games never need to be all in memory.
+ */
+bool DbManager::AddGames(const std::function<Game *()> &next)
 {
+    TRACE_SCOPE("db.AddGames");
     bool success = false;
 
-    for (auto const &game : games)
+    mDb.transaction();
+    QSqlQuery queryAdd(mDb);
+    queryAdd.prepare("INSERT INTO games (event_id, turn, team1_id, team2_id, team1_score, team2_score, state, document) "
+                     "VALUES (:event_id, :turn, :team1_id, :team2_id, :team1_score, :team2_score, :state, :document)");
+
+    for (Game *game = next(); game != nullptr; game = next())
     {
-        QSqlQuery queryAdd(mDb);
-        queryAdd.prepare("INSERT INTO games (event_id, turn, team1_id, team2_id, team1_score, team2_score, state, document) "
-                         "VALUES (:event_id, :turn, :team1_id, :team2_id, :team1_score, :team2_score, :state, :document)");
-        queryAdd.bindValue(":event_id", game.eventId);
-        queryAdd.bindValue(":turn", game.turn);
-        queryAdd.bindValue(":team1_id", game.team1Id);
-        queryAdd.bindValue(":team2_id", game.team2Id);
-        queryAdd.bindValue(":team1_score", game.team1Score);
-        queryAdd.bindValue(":team2_score", game.team2Score);
-        queryAdd.bindValue(":state", game.state);
-        queryAdd.bindValue(":document", game.document.c_str());
+        if (IsArchived(game->eventId))
+        {
+            TLogError("Add games failed: the season is closed");
+            success = false;
+            break;
+        }
+
+        queryAdd.bindValue(":event_id", game->eventId);
+        queryAdd.bindValue(":turn", game->turn);
+        queryAdd.bindValue(":team1_id", game->team1Id);
+        queryAdd.bindValue(":team2_id", game->team2Id);
+        queryAdd.bindValue(":team1_score", game->team1Score);
+        queryAdd.bindValue(":team2_score", game->team2Score);
+        queryAdd.bindValue(":state", game->state);
+        queryAdd.bindValue(":document", game->document.c_str());
 
         if(queryAdd.exec())
         {
-            qDebug() << "Add games success";
-            success = true;
+            game->id = queryAdd.lastInsertId().toInt();
+            success = LogScore(ScoreEntry::cAdded, Game(), *game);
         }
         else
         {
             TLogError("Add games failed: " + queryAdd.lastError().text().toStdString());
             success = false;
+        }
+
+        if (!success)
+        {
             break;
         }
     }
 
+    if (success)
+    {
+        success = mDb.commit();
+        ALogDebug("Add games success");
+        if (success)
+        {
+            // A new round is stored: copy the database before it is played
+            mBackup.Request();
+            mStats.clear();
+        }
+    }
+    else
+    {
+        mDb.rollback();
+    }
+
     return success;
 }
 
 std::deque<Game> DbManager::GetGamesByEventId(int event_id) const
 {
+    TRACE_SCOPE("db.GetGamesByEventId");
+    const SeasonArchive *archive = FindArchive(event_id);
+    if (archive != nullptr)
+    {
+        return archive->GetGames(event_id);
+    }
+
     QSqlQuery query(mDb);
     query.prepare("SELECT * FROM games WHERE event_id = :event_id");
     query.bindValue(":event_id", event_id);
@@ -708,6 +1036,16 @@ Game DbManager::GetGameById(int game_id) const
         {
             FillFrom(query, result);
         }
+        else
+        {
+            for (auto const &a : mArchives)
+            {
+                if (a.second->GetGame(game_id, result))
+                {
+                    break;
+                }
+            }
+        }
     }
     return result;
 }
@@ -729,13 +1067,35 @@ std::deque<Game> DbManager::GetGamesByTeamId(int teamId)
             result.push_back(game);
         }
     }
+
+    for (auto const &a : mArchives)
+    {
+        if (result.size() > 0U)
+        {
+            break; // team ids are unique, the team is in one place only
+        }
+        result = a.second->GetGamesByTeamId(teamId);
+    }
     return result;
 }
 
-bool DbManager::EditGame(const Game& game)
+/**
+ * @brief Store the game and its score log entry, in one transaction
+ * @param undoOf: score log entry taken back by this change, 0 if none
+ */
+bool DbManager::EditGame(const Game& game, std::int64_t undoOf)
 {
+    TRACE_SCOPE("db.EditGame");
     bool success = false;
 
+    if (IsArchived(game.eventId))
+    {
+        TLogError("Edit game failed: the season is closed");
+        return false;
+    }
+
+    Game before = GetGameById(game.id);
+    mDb.transaction();
     QSqlQuery queryEdit(mDb);
 
     queryEdit.prepare("UPDATE games SET event_id = :event_id, "
@@ -754,14 +1114,17 @@ bool DbManager::EditGame(const Game& game)
     queryEdit.bindValue(":state", game.state);
     queryEdit.bindValue(":document", game.document.c_str());
 
-    if(queryEdit.exec())
+    if(queryEdit.exec() && LogScore(ScoreEntry::cScored, before, game, undoOf))
     {
-        qDebug() << "Edit game success";
-        success = true;
+        InvalidateStats(before);
+        InvalidateStats(game);
+        success = mDb.commit();
+        ALogDebug("Edit game success");
     }
     else
     {
         TLogError("Edit game failed: " + queryEdit.lastError().text().toStdString());
+        mDb.rollback();
     }
     return success;
 }
@@ -770,18 +1133,28 @@ bool DbManager::DeleteGame(int id)
 {
     bool success = false;
 
+    Game before = GetGameById(id);
+    if ((before.id == id) && IsArchived(before.eventId))
+    {
+        TLogError("Delete game failed: the season is closed");
+        return false;
+    }
+
+    mDb.transaction();
     QSqlQuery queryDel(mDb);
     queryDel.prepare("DELETE FROM games WHERE id= :id");
     queryDel.bindValue(":id", id);
 
-    if(queryDel.exec())
+    if(queryDel.exec() && ((before.id != id) || LogScore(ScoreEntry::cDeleted, before, before)))
     {
-        qDebug() << "Delete game success";
-        success = true;
+        InvalidateStats(before);
+        success = mDb.commit();
+        ALogDebug("Delete game success");
     }
     else
     {
         TLogError("Delete game failed: " + queryDel.lastError().text().toStdString());
+        mDb.rollback();
     }
 
     return success;
@@ -791,41 +1164,538 @@ bool DbManager::DeleteGameByEventId(int eventId)
 {
     bool success = false;
 
+    if (IsArchived(eventId))
+    {
+        TLogError("Delete games failed: the season is closed");
+        return false;
+    }
+
+    // The deletion of each game is logged first
+    mDb.transaction();
+    QSqlQuery queryLog(mDb);
+    queryLog.prepare("INSERT INTO score_log (event_id, game_id, kind, turn, team1_id, team2_id, old_score1, old_score2, new_score1, new_score2, undo_of, date) "
+                     "SELECT event_id, id, :kind, turn, team1_id, team2_id, team1_score, team2_score, team1_score, team2_score, 0, datetime('now') "
+                     "FROM games WHERE event_id = :event_id ORDER BY id");
+    queryLog.bindValue(":kind", ScoreEntry::cDeleted);
+    queryLog.bindValue(":event_id", eventId);
+
     QSqlQuery queryAdd(mDb);
     queryAdd.prepare("DELETE FROM games WHERE event_id= :event_id");
     queryAdd.bindValue(":event_id", eventId);
 
-    if(queryAdd.exec())
+    if(queryLog.exec() && queryAdd.exec())
     {
-        qDebug() << "Delete game success";
-        success = true;
+        mStats.clear();
+        success = mDb.commit();
+        ALogDebug("Delete game success");
     }
     else
     {
         TLogError("Delete game failed: " + queryAdd.lastError().text().toStdString());
+        mDb.rollback();
     }
 
     return success;
 }
 
-QList<Reward> DbManager::GetRewardsForTeam(int team_id)
+/**
+ * @brief Append an entry to the score log, in the transaction of the change
+ */
+bool DbManager::LogScore(int kind, const Game &before, const Game &after, std::int64_t undoOf)
 {
     QSqlQuery query(mDb);
-    query.prepare("SELECT * FROM rewards WHERE team_id = :teamId");
-    query.bindValue(":teamId", team_id);
+    query.prepare("INSERT INTO score_log (event_id, game_id, kind, turn, team1_id, team2_id, old_score1, old_score2, new_score1, new_score2, undo_of, date) "
+                  "VALUES (:event_id, :game_id, :kind, :turn, :team1_id, :team2_id, :old_score1, :old_score2, :new_score1, :new_score2, :undo_of, datetime('now'))");
+    query.bindValue(":event_id", after.eventId);
+    query.bindValue(":game_id", after.id);
+    query.bindValue(":kind", kind);
+    query.bindValue(":turn", after.turn);
+    query.bindValue(":team1_id", after.team1Id);
+    query.bindValue(":team2_id", after.team2Id);
+    query.bindValue(":old_score1", before.team1Score);
+    query.bindValue(":old_score2", before.team2Score);
+    query.bindValue(":new_score1", after.team1Score);
+    query.bindValue(":new_score2", after.team2Score);
+    query.bindValue(":undo_of", static_cast<qlonglong>(undoOf));
+
+    bool success = query.exec();
+    if (!success)
+    {
+        TLogError("Score log failed: " + query.lastError().text().toStdString());
+    }
+    return success;
+}
 
-    QList<Reward> result;
+/**
+ * @brief Forget the statistics of the players of the teams of a game
+ */
+void DbManager::InvalidateStats(const Game &game)
+{
+    if (mStats.empty())
+    {
+        return;
+    }
 
-    if(query.exec())
+    QSqlQuery query(mDb);
+    query.prepare("SELECT player1_id, player2_id, player3_id FROM teams WHERE id = :team1 OR id = :team2");
+    query.bindValue(":team1", game.team1Id);
+    query.bindValue(":team2", game.team2Id);
+
+    if (query.exec())
     {
         while (query.next())
         {
-            Reward reward;
-            FillFrom(query, reward);
-            result.append(reward);
+            for (int i = 0; i < 3; i++)
+            {
+                mStats.erase(query.value(i).toInt());
+            }
         }
     }
-    return result;
+    else
+    {
+        mStats.clear();
+    }
+}
+
+/**
+ * @brief All the games of a player with the players of both teams, in one query
+ *
+ * The games of the closed seasons are read from the archives, without any query.
+ */
+const PlayerStats &DbManager::GetPlayerStats(int playerId)
+{
+    auto cached = mStats.find(playerId);
+    if (cached != mStats.end())
+    {
+        return cached->second;
+    }
+
+    TRACE_SCOPE("db.GetPlayerStats");
+    PlayerStats stats(playerId);
+    int team1Players[3];
+    int team2Players[3];
+
+    for (auto const &a : mArchives)
+    {
+        std::unordered_map<int, std::deque<Team>> eventTeams;
+        for (auto const &team : a.second->GetTeamsByPlayerId(playerId))
+        {
+            for (auto const &game : a.second->GetGamesByTeamId(team.id))
+            {
+                auto it = eventTeams.find(game.eventId);
+                if (it == eventTeams.end())
+                {
+                    it = eventTeams.emplace(game.eventId, a.second->GetTeams(game.eventId)).first;
+                }
+
+                for (int i = 0; i < 3; i++)
+                {
+                    team1Players[i] = -1;
+                    team2Players[i] = -1;
+                }
+                for (auto const &t : it->second)
+                {
+                    int *players = (t.id == game.team1Id) ? team1Players : ((t.id == game.team2Id) ? team2Players : nullptr);
+                    if (players != nullptr)
+                    {
+                        players[0] = t.player1Id;
+                        players[1] = t.player2Id;
+                        players[2] = t.player3Id;
+                    }
+                }
+                stats.AddGame(game, a.first, team1Players, team2Players);
+            }
+        }
+    }
+
+    QSqlQuery query(mDb);
+    query.prepare("WITH mine AS (SELECT id FROM teams WHERE player1_id = :playerId OR player2_id = :playerId OR player3_id = :playerId) "
+                  "SELECT g.*, e.year, "
+                  "t1.player1_id AS p11, t1.player2_id AS p12, t1.player3_id AS p13, "
+                  "t2.player1_id AS p21, t2.player2_id AS p22, t2.player3_id AS p23 "
+                  "FROM games g JOIN events e ON e.id = g.event_id "
+                  "LEFT JOIN teams t1 ON t1.id = g.team1_id "
+                  "LEFT JOIN teams t2 ON t2.id = g.team2_id "
+                  "WHERE g.team1_id IN (SELECT id FROM mine) OR g.team2_id IN (SELECT id FROM mine) "
+                  "ORDER BY e.date, g.turn, g.id");
+    query.bindValue(":playerId", playerId);
+
+    if (query.exec())
+    {
+        static const char *cColumns[6] = { "p11", "p12", "p13", "p21", "p22", "p23" };
+        while (query.next())
+        {
+            Game game;
+            FillFrom(query, game);
+            for (int i = 0; i < 3; i++)
+            {
+                // No team row for the dummy team of a bye
+                QVariant v1 = query.value(cColumns[i]);
+                QVariant v2 = query.value(cColumns[i + 3]);
+                team1Players[i] = v1.isNull() ? -1 : v1.toInt();
+                team2Players[i] = v2.isNull() ? -1 : v2.toInt();
+            }
+            stats.AddGame(game, query.value("year").toInt(), team1Players, team2Players);
+        }
+    }
+    else
+    {
+        TLogError("Get player statistics failed: " + query.lastError().text().toStdString());
+    }
+
+    stats.Finish();
+    return mStats.emplace(playerId, stats).first->second;
+}
+
+std::deque<ScoreEntry> DbManager::GetScoreLog(int eventId, std::int64_t after) const
+{
+    TRACE_SCOPE("db.GetScoreLog");
+    QSqlQuery query(mDb);
+    query.prepare("SELECT * FROM score_log WHERE event_id = :event_id AND seq > :after ORDER BY seq");
+    query.bindValue(":event_id", eventId);
+    query.bindValue(":after", static_cast<qlonglong>(after));
+
+    std::deque<ScoreEntry> log;
+    if (query.exec())
+    {
+        while (query.next())
+        {
+            ScoreEntry entry;
+            entry.seq = query.value("seq").toLongLong();
+            entry.eventId = query.value("event_id").toInt();
+            entry.gameId = query.value("game_id").toInt();
+            entry.kind = query.value("kind").toInt();
+            entry.turn = query.value("turn").toInt();
+            entry.team1Id = query.value("team1_id").toInt();
+            entry.team2Id = query.value("team2_id").toInt();
+            entry.oldScore1 = query.value("old_score1").toInt();
+            entry.oldScore2 = query.value("old_score2").toInt();
+            entry.newScore1 = query.value("new_score1").toInt();
+            entry.newScore2 = query.value("new_score2").toInt();
+            entry.undoOf = query.value("undo_of").toLongLong();
+            log.push_back(entry);
+        }
+    }
+    else
+    {
+        TLogError("Get score log failed: " + query.lastError().text().toStdString());
+    }
+    return log;
+}
+
+QString DbManager::GetArchivePath(int year) const
+{
+    return QFileInfo(mDb.databaseName()).absolutePath() + "/archives/season-" + QString::number(year) + ".tca";
+}
+
+/**
+ * @brief Map the archives of the closed seasons, next to the database file
+ */
+void DbManager::OpenArchives()
+{
+    TRACE_SCOPE("db.OpenArchives");
+    mArchives.clear();
+
+    QDir dir(QFileInfo(mDb.databaseName()).absolutePath() + "/archives");
+    for (auto const &file : dir.entryInfoList(QStringList() << "season-*.tca", QDir::Files))
+    {
+        std::unique_ptr<SeasonArchive> archive(new SeasonArchive());
+        if (archive->Open(file.absoluteFilePath()))
+        {
+            int year = archive->GetYear();
+            mArchives[year] = std::move(archive);
+            ALogInfo("Season " << year << " archived in " << file.fileName().toStdString());
+        }
+    }
+}
+
+const SeasonArchive *DbManager::GetArchive(int year) const
+{
+    auto it = mArchives.find(year);
+    return (it != mArchives.end()) ? it->second.get() : nullptr;
+}
+
+const SeasonArchive *DbManager::FindArchive(int eventId) const
+{
+    for (auto const &a : mArchives)
+    {
+        if (a.second->HasEvent(eventId))
+        {
+            return a.second.get();
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Move a finished season into a read-only archive
+ *
+ * The archive is written and checked first, then the rows of the season are
+ * removed from the database in one transaction. Rewards and ratings stay in
+ * the database (they refer to the ids, which are never reused).
+ */
+bool DbManager::CloseSeason(int year)
+{
+    TRACE_SCOPE("db.CloseSeason");
+
+    if (GetArchive(year) != nullptr)
+    {
+        TLogError("Season already closed");
+        return false;
+    }
+
+    std::deque<Event> events = GetEvents(year);
+    std::deque<Team> teams;
+    std::deque<Game> games;
+
+    if (events.size() == 0U)
+    {
+        TLogError("Close season failed: no event");
+        return false;
+    }
+
+    for (auto const &e : events)
+    {
+        std::deque<Team> t = GetTeams(e.id);
+        teams.insert(teams.end(), t.begin(), t.end());
+
+        std::deque<Game> g = GetGamesByEventId(e.id);
+        games.insert(games.end(), g.begin(), g.end());
+    }
+
+    QString path = GetArchivePath(year);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    std::unique_ptr<SeasonArchive> archive(new SeasonArchive());
+    bool success = SeasonArchive::Write(path, year, events, teams, games) && archive->Open(path) &&
+                   (archive->EventCount() == events.size()) && (archive->TeamCount() == teams.size()) &&
+                   (archive->GameCount() == games.size());
+
+    if (success)
+    {
+        mDb.transaction();
+        QSqlQuery query(mDb);
+
+        for (auto const &sql : { "DELETE FROM games WHERE event_id IN (SELECT id FROM events WHERE year = :year)",
+                                 "DELETE FROM score_log WHERE event_id IN (SELECT id FROM events WHERE year = :year)",
+                                 "DELETE FROM teams WHERE event_id IN (SELECT id FROM events WHERE year = :year)",
+                                 "DELETE FROM events WHERE year = :year" })
+        {
+            query.prepare(sql);
+            query.bindValue(":year", year);
+            if (!query.exec())
+            {
+                TLogError("Close season failed: " + query.lastError().text().toStdString());
+                success = false;
+                break;
+            }
+        }
+
+        success = success && mDb.commit();
+        if (!success)
+        {
+            mDb.rollback();
+        }
+    }
+
+    if (success)
+    {
+        mArchives[year] = std::move(archive);
+        mStats.clear(); // the teams and games of the season left the live tables
+        ALogInfo("Season " << year << " closed: " << events.size() << " events, " << games.size() << " games");
+    }
+    else
+    {
+        archive.reset();
+        QFile::remove(path);
+    }
+    return success;
+}
+
+std::deque<Rating> DbManager::GetRatings() const
+{
+    TRACE_SCOPE("db.GetRatings");
+    QSqlQuery query("SELECT * FROM ratings", mDb);
+    std::deque<Rating> result;
+
+    while (query.next())
+    {
+        Rating rating;
+        rating.playerId = query.value("player_id").toInt();
+        rating.value = query.value("rating").toDouble();
+        rating.games = query.value("games").toInt();
+        result.push_back(rating);
+    }
+    return result;
+}
+
+/**
+ * @brief Ratings of some players only, read through the primary key
+ */
+std::deque<Rating> DbManager::GetRatings(const std::vector<int> &playerIds) const
+{
+    TRACE_SCOPE("db.GetRatings");
+    std::deque<Rating> result;
+
+    if (playerIds.size() > 0U)
+    {
+        QStringList ids;
+        for (auto id : playerIds)
+        {
+            ids << QString::number(id);
+        }
+
+        QSqlQuery query("SELECT * FROM ratings WHERE player_id IN (" + ids.join(',') + ")", mDb);
+        while (query.next())
+        {
+            Rating rating;
+            rating.playerId = query.value("player_id").toInt();
+            rating.value = query.value("rating").toDouble();
+            rating.games = query.value("games").toInt();
+            result.push_back(rating);
+        }
+    }
+    return result;
+}
+
+bool DbManager::GetRatingDelta(int gameId, double &delta) const
+{
+    bool found = false;
+    QSqlQuery query(mDb);
+    query.prepare("SELECT delta FROM rating_deltas WHERE game_id = :game_id");
+    query.bindValue(":game_id", gameId);
+
+    if (query.exec() && query.next())
+    {
+        delta = query.value("delta").toDouble();
+        found = true;
+    }
+    return found;
+}
+
+/**
+ * @brief Store the ratings in one transaction
+ *
+ * @param replaceAll: the previous ratings and deltas are deleted (full recompute),
+ * otherwise the given rows are inserted or replaced.
+ */
+bool DbManager::StoreRatings(const std::deque<Rating> &ratings, const std::deque<RatingDelta> &deltas, bool replaceAll)
+{
+    TRACE_SCOPE("db.StoreRatings");
+    bool success = true;
+
+    mDb.transaction();
+    QSqlQuery query(mDb);
+
+    if (replaceAll)
+    {
+        success = query.exec("DELETE FROM ratings") && query.exec("DELETE FROM rating_deltas");
+    }
+
+    if (success)
+    {
+        query.prepare("INSERT OR REPLACE INTO ratings (player_id, rating, games) VALUES (:player_id, :rating, :games)");
+        for (auto const &r : ratings)
+        {
+            query.bindValue(":player_id", r.playerId);
+            query.bindValue(":rating", r.value);
+            query.bindValue(":games", r.games);
+            if (!query.exec())
+            {
+                success = false;
+                break;
+            }
+        }
+    }
+
+    if (success)
+    {
+        query.prepare("INSERT OR REPLACE INTO rating_deltas (game_id, delta) VALUES (:game_id, :delta)");
+        for (auto const &d : deltas)
+        {
+            query.bindValue(":game_id", d.gameId);
+            query.bindValue(":delta", d.delta);
+            if (!query.exec())
+            {
+                success = false;
+                break;
+            }
+        }
+    }
+
+    if (success)
+    {
+        success = mDb.commit();
+        ALogDebug("Store ratings success");
+    }
+    else
+    {
+        TLogError("Store ratings failed: " + query.lastError().text().toStdString());
+        mDb.rollback();
+    }
+    return success;
+}
+
+bool DbManager::DeleteRatingDelta(int gameId)
+{
+    bool success = false;
+
+    QSqlQuery queryDel(mDb);
+    queryDel.prepare("DELETE FROM rating_deltas WHERE game_id= :game_id");
+    queryDel.bindValue(":game_id", gameId);
+
+    if(queryDel.exec())
+    {
+        success = true;
+    }
+    else
+    {
+        TLogError("Delete rating delta failed: " + queryDel.lastError().text().toStdString());
+    }
+
+    return success;
+}
+
+/**
+ * @brief All the events of all the seasons with their teams and games
+ */
+std::vector<RatedEvent> DbManager::GetRatingHistory()
+{
+    TRACE_SCOPE("db.GetRatingHistory");
+    std::vector<RatedEvent> history;
+
+    for (auto const &season : GetSeasons())
+    {
+        for (auto const &event : GetEvents(season.toInt()))
+        {
+            RatedEvent e;
+            e.event = event;
+            e.teams = GetTeams(event.id);
+            e.games = GetGamesByEventId(event.id);
+            history.push_back(e);
+        }
+    }
+    return history;
+}
+
+QList<Reward> DbManager::GetRewardsForTeam(int team_id)
+{
+    QSqlQuery query(mDb);
+    query.prepare("SELECT * FROM rewards WHERE team_id = :teamId");
+    query.bindValue(":teamId", team_id);
+
+    QList<Reward> result;
+
+    if(query.exec())
+    {
+        while (query.next())
+        {
+            Reward reward;
+            FillFrom(query, reward);
+            result.append(reward);
+        }
+    }
+    return result;
 }
 
 bool DbManager::AddReward(const Reward &reward)
@@ -844,7 +1714,7 @@ bool DbManager::AddReward(const Reward &reward)
 
     if(queryAdd.exec())
     {
-        qDebug() << "Add reward success";
+        ALogDebug("Add reward success");
         success = true;
     }
     else
@@ -856,6 +1726,149 @@ bool DbManager::AddReward(const Reward &reward)
     return success;
 }
 
+/**
+ * @brief Rewards of an event, summed per team in one grouped query
+ *
+ * The canceled rewards are not counted. Teams without any reward are not listed.
+ */
+std::deque<RewardTotal> DbManager::GetRewardTotals(int eventId)
+{
+    TRACE_SCOPE("db.GetRewardTotals");
+    std::deque<RewardTotal> result;
+
+    QSqlQuery query(mDb);
+    query.prepare("SELECT team_id, SUM(total), COUNT(*) FROM rewards "
+                  "WHERE event_id = :event_id AND state <> :canceled GROUP BY team_id ORDER BY SUM(total) DESC, team_id");
+    query.bindValue(":event_id", eventId);
+    query.bindValue(":canceled", Reward::cStateRewardCanceled);
+
+    if (query.exec())
+    {
+        while (query.next())
+        {
+            RewardTotal total;
+            total.id = query.value(0).toInt();
+            total.total = query.value(1).toInt();
+            total.count = query.value(2).toInt();
+            result.push_back(total);
+        }
+    }
+    else
+    {
+        TLogError("Get reward totals failed: " + query.lastError().text().toStdString());
+    }
+    return result;
+}
+
+/**
+ * @brief Rewards paid out by each event of the list, in one grouped query
+ *
+ * The rewards stay in the database when a season is archived, so the closed
+ * events are summed as well.
+ */
+std::deque<RewardTotal> DbManager::GetRewardTotals(const std::deque<Event> &events)
+{
+    TRACE_SCOPE("db.GetRewardTotalsByEvent");
+    std::deque<RewardTotal> result;
+
+    if (events.size() > 0U)
+    {
+        QStringList ids;
+        for (auto const &event : events)
+        {
+            ids << QString::number(event.id);
+        }
+
+        QSqlQuery query(mDb);
+        query.prepare("SELECT event_id, SUM(total), COUNT(*) FROM rewards "
+                      "WHERE event_id IN (" + ids.join(',') + ") AND state <> :canceled GROUP BY event_id");
+        query.bindValue(":canceled", Reward::cStateRewardCanceled);
+
+        if (query.exec())
+        {
+            while (query.next())
+            {
+                RewardTotal total;
+                total.id = query.value(0).toInt();
+                total.total = query.value(1).toInt();
+                total.count = query.value(2).toInt();
+                result.push_back(total);
+            }
+        }
+        else
+        {
+            TLogError("Get event reward totals failed: " + query.lastError().text().toStdString());
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Pay out an event from its final ranking, in one transaction
+ *
+ * amounts[0] goes to the first team of the ranking, amounts[1] to the second
+ * and so on; null amounts are skipped. The rewards of a previous distribution
+ * of the event are replaced, the ones added by hand are kept.
+ */
+bool DbManager::AssignRankingRewards(int eventId, const std::deque<Rank> &ranking, const std::vector<int> &amounts)
+{
+    TRACE_SCOPE("db.AssignRankingRewards");
+    bool success = false;
+
+    mDb.transaction();
+    QSqlQuery query(mDb);
+    query.prepare("DELETE FROM rewards WHERE event_id = :event_id AND state = :state");
+    query.bindValue(":event_id", eventId);
+    query.bindValue(":state", Reward::cStateRewardRanking);
+    success = query.exec();
+
+    if (success)
+    {
+        query.prepare("INSERT INTO rewards (event_id, team_id, total, comment, state, document) "
+                      "VALUES (:event_id, :team_id, :total, :comment, :state, :document)");
+
+        std::uint32_t place = 0U;
+        for (auto const &rank : ranking)
+        {
+            if (place >= amounts.size())
+            {
+                break;
+            }
+
+            int total = amounts[place];
+            place++;
+            if (total > 0)
+            {
+                query.bindValue(":event_id", eventId);
+                query.bindValue(":team_id", rank.id);
+                query.bindValue(":total", total);
+                query.bindValue(":comment", QString("Classement : %1").arg(place));
+                query.bindValue(":state", Reward::cStateRewardRanking);
+                query.bindValue(":document", "");
+
+                if (!query.exec())
+                {
+                    success = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (success)
+    {
+        success = mDb.commit();
+        ALogDebug("Assign ranking rewards success");
+    }
+    else
+    {
+        TLogError("Assign ranking rewards failed: " + query.lastError().text().toStdString());
+        mDb.rollback();
+    }
+
+    return success;
+}
+
 bool DbManager::DeleteReward(int id)
 {
     bool success = false;
@@ -866,7 +1879,7 @@ bool DbManager::DeleteReward(int id)
 
     if(queryDel.exec())
     {
-        qDebug() << "Delete reward success";
+        ALogDebug("Delete reward success");
         success = true;
     }
     else
@@ -882,6 +1895,12 @@ bool DbManager::AddTeam(const Team &team)
 {
     bool success = false;
 
+    if (IsArchived(team.eventId))
+    {
+        TLogError("Add team failed: the season is closed");
+        return false;
+    }
+
     QSqlQuery queryAdd(mDb);
     queryAdd.prepare("INSERT INTO teams (event_id, team_name, player1_id, player2_id, player3_id, state, document, number) "
                      "VALUES (:event_id, :team_name, :player1_id, :player2_id, :player3_id, :state, :document, :number)");
@@ -896,8 +1915,9 @@ bool DbManager::AddTeam(const Team &team)
 
     if(queryAdd.exec())
     {
-        qDebug() << "Add team success";
+        ALogDebug("Add team success");
         success = true;
+        mStats.clear();
     }
     else
     {
@@ -909,6 +1929,13 @@ bool DbManager::AddTeam(const Team &team)
 
 std::deque<Team> DbManager::GetTeams(int eventId) const
 {
+    TRACE_SCOPE("db.GetTeams");
+    const SeasonArchive *archive = FindArchive(eventId);
+    if (archive != nullptr)
+    {
+        return archive->GetTeams(eventId);
+    }
+
     QSqlQuery query(mDb);
     query.prepare("SELECT * FROM teams WHERE event_id = :event_id");
     query.bindValue(":event_id", eventId);
@@ -925,18 +1952,13 @@ std::deque<Team> DbManager::GetTeams(int eventId) const
             if (team.teamName == "")
             {
                 // Create a team name
-                Player p1, p2;
-
-                bool valid = FindPlayer(team.player1Id, p1);
-                valid = valid && FindPlayer(team.player2Id, p2);
-
-                if (valid)
+                if (mPlayers.Contains(team.player1Id) && mPlayers.Contains(team.player2Id))
                 {
-                    CreateName(team, p1, p2);
+                    team.teamName = mLabels.TeamName(mPlayers, team);
                 }
                 else
                 {
-                    std::cout << "Cannot find players" << std::endl;
+                    ALogWarning("Cannot find players of team " << team.id);
                 }
             }
 
@@ -949,7 +1971,7 @@ std::deque<Team> DbManager::GetTeams(int eventId) const
 std::deque<Team> DbManager::GetTeamsByPlayerId(int playerId)
 {
     QSqlQuery query(mDb);
-    query.prepare("SELECT * FROM teams WHERE player1_id = :playerId OR player2_id = :playerId");
+    query.prepare("SELECT * FROM teams WHERE player1_id = :playerId OR player2_id = :playerId OR player3_id = :playerId");
     query.bindValue(":playerId", playerId);
 
     std::deque<Team> result;
@@ -963,19 +1985,31 @@ std::deque<Team> DbManager::GetTeamsByPlayerId(int playerId)
             result.push_back(team);
         }
     }
+
+    for (auto const &a : mArchives)
+    {
+        std::deque<Team> teams = a.second->GetTeamsByPlayerId(playerId);
+        result.insert(result.end(), teams.begin(), teams.end());
+    }
     return result;
 }
 
 
 void DbManager::CreateName(Team &team, const Player &p1, const Player &p2)
 {
-    team.teamName = p1.name + " " + p1.lastName.substr(0, 3) + ". / " + p2.name + " " + p2.lastName.substr(0, 3) + ".";
+    team.teamName = LabelCache::DefaultTeamName(p1, p2);
 }
 
 bool DbManager::EditTeam(const Team &team)
 {
     bool success = false;
 
+    if (IsArchived(team.eventId))
+    {
+        TLogError("Edit team failed: the season is closed");
+        return false;
+    }
+
     QSqlQuery queryEdit(mDb);
 
     queryEdit.prepare("UPDATE teams SET event_id = :event_id, team_name = :team_name, player1_id = :player1_id, "
@@ -993,8 +2027,10 @@ bool DbManager::EditTeam(const Team &team)
 
     if(queryEdit.exec())
     {
-        qDebug() << "Edit team success";
+        ALogDebug("Edit team success");
         success = true;
+        mStats.clear();
+        mLabels.InvalidateTeam(team.id);
     }
     else
     {
@@ -1007,14 +2043,26 @@ bool DbManager::DeleteTeam(int id)
 {
     bool success = false;
 
+    // Only the live teams: the teams of a closed season are in its archive
+    QSqlQuery queryFind(mDb);
+    queryFind.prepare("SELECT event_id FROM teams WHERE id = :id");
+    queryFind.bindValue(":id", id);
+    if (!queryFind.exec() || !queryFind.next() || IsArchived(queryFind.value(0).toInt()))
+    {
+        TLogError("Delete team failed: unknown team or closed season");
+        return false;
+    }
+
     QSqlQuery queryAdd(mDb);
     queryAdd.prepare("DELETE FROM teams WHERE id = :id");
     queryAdd.bindValue(":id", id);
 
     if(queryAdd.exec())
     {
-        qDebug() << "Delete team success";
+        ALogDebug("Delete team success");
         success = true;
+        mStats.clear();
+        mLabels.InvalidateTeam(id);
     }
     else
     {
@@ -1028,14 +2076,22 @@ bool DbManager::DeleteTeamByEventId(int eventId)
 {
     bool success = false;
 
+    if (IsArchived(eventId))
+    {
+        TLogError("Delete teams failed: the season is closed");
+        return false;
+    }
+
     QSqlQuery queryAdd(mDb);
     queryAdd.prepare("DELETE FROM teams WHERE event_id= :event_id");
     queryAdd.bindValue(":event_id", eventId);
 
     if(queryAdd.exec())
     {
-        qDebug() << "Delete team success";
+        ALogDebug("Delete team success");
         success = true;
+        mStats.clear();
+        mLabels.Clear();
     }
     else
     {
@@ -1046,6 +2102,26 @@ bool DbManager::DeleteTeamByEventId(int eventId)
 }
 
 
+void FillFrom(const QSqlQuery &query, Player &player)
+{
+    player.id = query.value("id").toInt();
+    player.uuid = query.value("uuid").toString().toStdString();
+    player.name = query.value("name").toString().toStdString();
+    player.lastName = query.value("last_name").toString().toStdString();
+    player.nickName = query.value("nick_name").toString().toStdString();
+    player.email = query.value("email").toString().toStdString();
+    player.mobilePhone = query.value("mobile_phone").toString().toStdString();
+    player.homePhone = query.value("home_phone").toString().toStdString();
+    player.birthDate = Util::FromISODate(query.value("birth_date").toString().toStdString());
+    player.road = query.value("road").toString().toStdString();
+    player.postCode = query.value("post_code").toInt();
+    player.city = query.value("city").toString().toStdString();
+    player.membership = query.value("membership").toString().toStdString();
+    player.comments = query.value("comments").toString().toStdString();
+    player.state = query.value("state").toInt();
+    player.document = query.value("document").toString().toStdString();
+}
+
 void FillFrom(const QSqlQuery &query, Team &team)
 {
     team.id = query.value("id").toInt();
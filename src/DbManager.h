@@ -5,11 +5,26 @@
 #include <QtCore>
 #include <QSqlTableModel>
 #include <QSqlQuery>
+#include <functional>
+#include <map>
+#include <memory>
 
 #include "IDataBase.h"
+#include "SearchIndex.h"
+#include "Ratings.h"
+#include "SeasonArchive.h"
+#include "BackupService.h"
+#include "ScoreLog.h"
+#include "PlayerStats.h"
+#include "CityDirectory.h"
+#include "DuplicateDetector.h"
+#include "LabelCache.h"
+#include "PlayerStore.h"
 
 
 
+void FillFrom(const QSqlQuery &query, Player &player);
+
 void FillFrom(const QSqlQuery &query, Team &team);
 
 void FillFrom(const QSqlQuery &query, Reward &reward);
@@ -49,14 +64,23 @@ public:
     ~DbManager();
 
     void Initialize();
+    bool IsOpen() const { return mDb.isOpen(); }
 
     // Player management
     static bool IsValid(const Player &player);
     bool AddPlayer(const Player &player, int id = -1); // you may specify an ID if you want
+    bool AddPlayers(const std::deque<Player> &players);
     bool EditPlayer(const Player &player);
-    bool FindPlayer(int id, Player &player) const;
-    std::deque<Player> &GetPlayerList();
+    bool FindPlayer(int id, Player &player) const; // all the fields, read from the base
+    // Names of the players, kept in memory
+    const PlayerStore &GetPlayers() const { return mPlayers; }
+    // Cached display names, valid until the next change of the players or teams
+    const std::string &GetPlayerName(int id) const { return mLabels.PlayerName(mPlayers, id); }
+    const std::string &GetTeamLabel(const Team *team) const { return mLabels.TeamLabel(team); }
+    void VisitPlayers(const std::function<void (const Player &)> &visit) const; // all the fields, row after row from the base
     bool PlayerExists(const Player &player) const;
+    std::vector<DuplicateMatch> FindDuplicates(const Player &player) const;
+    SearchIndex &GetPlayerIndex();
     bool DeletePlayer(int id);
 
     // Events management
@@ -80,28 +104,71 @@ public:
     std::deque<Game> GetGamesByEventId(int event_id) const;
     Game GetGameById(int game_id) const;
     std::deque<Game> GetGamesByTeamId(int teamId);
-    bool AddGames(const std::deque<Game> &games);
-    bool EditGame(const Game &game);
+    bool AddGames(std::deque<Game> &games);
+    bool AddGames(const std::function<Game *()> &next);
+    bool EditGame(const Game &game, std::int64_t undoOf = 0);
     bool DeleteGame(int id);
     bool DeleteGameByEventId(int eventId);
 
+    // Score log: every change of the games, in order (entries after a sequence number)
+    std::deque<ScoreEntry> GetScoreLog(int eventId, std::int64_t after = 0) const;
+
+    // Closed seasons: moved to a read-only archive, still read through the methods above
+    bool CloseSeason(int year);
+    const SeasonArchive *GetArchive(int year) const;
+    bool IsArchived(int eventId) const { return FindArchive(eventId) != nullptr; }
+
+    // Backup copies of the database file, taken in the background
+    void RequestBackup() { mBackup.Request(); }
+    bool WaitBackup() { return mBackup.Wait(); }
+
+    // History of a player, all seasons (cached until its games change)
+    const PlayerStats &GetPlayerStats(int playerId);
+
+    // Player ratings
+    std::deque<Rating> GetRatings() const;
+    std::deque<Rating> GetRatings(const std::vector<int> &playerIds) const;
+    bool GetRatingDelta(int gameId, double &delta) const;
+    bool StoreRatings(const std::deque<Rating> &ratings, const std::deque<RatingDelta> &deltas, bool replaceAll);
+    bool DeleteRatingDelta(int gameId);
+    std::vector<RatedEvent> GetRatingHistory();
+
     // Rewards
     QList<Reward> GetRewardsForTeam(int team_id);
     bool AddReward(const Reward &reward);
+    std::deque<RewardTotal> GetRewardTotals(int eventId); // per team
+    std::deque<RewardTotal> GetRewardTotals(const std::deque<Event> &events); // per event
+    bool AssignRankingRewards(int eventId, const std::deque<Rank> &ranking, const std::vector<int> &amounts);
     bool DeleteReward(int id);
 
     // From ICities
     virtual QStringList GetCities(int postCode);
+    // Allocation-free lookups, for the completion as the user types
+    const CityDirectory &GetCityDirectory() const { return mCityDirectory; }
 
     // Static members
     static void CreateName(Team &team, const Player &p1, const Player &p2);
 private:
     QSqlDatabase mDb;
-    QSqlDatabase mCities;
-    std::deque<Player> mPlayers; // Cached player list
+    CityDirectory mCityDirectory;
+    PlayerStore mPlayers; // Cached player list, names only
+    SearchIndex mPlayerIndex; // Search index over the cached player list
+    DuplicateDetector mDuplicates; // Near matches over the cached player list
+    mutable LabelCache mLabels; // Display names of the cached players and of the teams
     Infos mInfos;
+    std::map<int, std::unique_ptr<SeasonArchive>> mArchives; // year -> archive
+    BackupService mBackup;
+    std::unordered_map<int, PlayerStats> mStats; // player id -> statistics
+
+    QString GetArchivePath(int year) const;
+    void OpenArchives();
+    const SeasonArchive *FindArchive(int eventId) const;
 
     void UpdatePlayerList();
+    bool LogScore(int kind, const Game &before, const Game &after, std::int64_t undoOf = 0);
+    void InvalidateStats(const Game &game);
+    QString ReadVersion();
+    void CreateTables();
     void Upgrade();
     bool EditInfos();
 };
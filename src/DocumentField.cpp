@@ -0,0 +1,115 @@
+/*=============================================================================
+ * Tanca - DocumentField.cpp
+ *=============================================================================
+ * Integer members of the JSON documents attached to the entities
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <cstdlib>
+
+#include "DocumentField.h"
+
+/**
+ * @brief Position of the value of a key in a flat JSON object
+ * @param end: end of the value
+ * @return npos if the key does not exist
+ */
+static std::size_t FindValue(const std::string &document, const std::string &key, std::size_t &end)
+{
+    std::string quoted = "\"" + key + "\"";
+    std::size_t pos = document.find(quoted);
+
+    if (pos != std::string::npos)
+    {
+        pos = document.find_first_not_of(" \t\r\n", pos + quoted.size());
+        if ((pos != std::string::npos) && (document[pos] == ':'))
+        {
+            pos = document.find_first_not_of(" \t\r\n", pos + 1);
+        }
+        else
+        {
+            pos = std::string::npos;
+        }
+    }
+
+    if (pos != std::string::npos)
+    {
+        end = document.find_first_of(",} \t\r\n", pos);
+        if (end == std::string::npos)
+        {
+            end = document.size();
+        }
+    }
+    return pos;
+}
+
+int DocumentField::GetInteger(const std::string &document, const std::string &key, int defaultValue)
+{
+    int value = defaultValue;
+    std::size_t end;
+    std::size_t pos = FindValue(document, key, end);
+
+    if (pos != std::string::npos)
+    {
+        std::string number = document.substr(pos, end - pos);
+        char *last = nullptr;
+        long parsed = std::strtol(number.c_str(), &last, 10);
+        if ((last != number.c_str()) && (*last == '\0'))
+        {
+            value = static_cast<int>(parsed);
+        }
+    }
+    return value;
+}
+
+/**
+ * @brief Change or add an integer member, the other members are kept
+ */
+void DocumentField::SetInteger(std::string &document, const std::string &key, int value)
+{
+    std::size_t end;
+    std::size_t pos = FindValue(document, key, end);
+
+    if (pos != std::string::npos)
+    {
+        document.replace(pos, end - pos, std::to_string(value));
+    }
+    else
+    {
+        std::string member = "\"" + key + "\":" + std::to_string(value);
+        std::size_t close = document.find_last_of('}');
+        std::size_t last = (close == std::string::npos) ? close : document.find_last_not_of(" \t\r\n", close - 1);
+
+        if ((close == std::string::npos) || (last == std::string::npos))
+        {
+            // Empty (or not an object): replaced
+            document = "{" + member + "}";
+        }
+        else
+        {
+            document.insert(close, (document[last] == '{') ? member : ("," + member));
+        }
+    }
+}
+
+//=============================================================================
+// End of file DocumentField.cpp
+//=============================================================================
@@ -0,0 +1,49 @@
+/*=============================================================================
+ * Tanca - DocumentField.h
+ *=============================================================================
+ * Integer members of the JSON documents attached to the entities
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef DOCUMENT_FIELD_H
+#define DOCUMENT_FIELD_H
+
+#include <string>
+
+/**
+ * @brief Read and write one integer member of a flat JSON object
+ *
+ * The "document" column of the tables holds small JSON objects; these
+ * functions change one member without parsing the whole object, the other
+ * members are kept as they are.
+ */
+class DocumentField
+{
+public:
+    static int GetInteger(const std::string &document, const std::string &key, int defaultValue);
+    static void SetInteger(std::string &document, const std::string &key, int value);
+};
+
+#endif // DOCUMENT_FIELD_H
+
+//=============================================================================
+// End of file DocumentField.h
+//=============================================================================
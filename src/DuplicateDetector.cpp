@@ -0,0 +1,556 @@
+/*=============================================================================
+ * Tanca - DuplicateDetector.cpp
+ *=============================================================================
+ * Near matches of a player in the membership base
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+#include "DuplicateDetector.h"
+#include "SearchIndex.h"
+#include "Profiler.h"
+
+const std::uint32_t DuplicateMatch::cSameName;
+const std::uint32_t DuplicateMatch::cSimilarName;
+const std::uint32_t DuplicateMatch::cSwappedNames;
+const std::uint32_t DuplicateMatch::cSameEmail;
+const std::uint32_t DuplicateMatch::cSamePhone;
+const std::uint32_t DuplicateDetector::cMaxPattern;
+const std::size_t DuplicateDetector::cMaxRecent;
+
+static const std::size_t cMaxName = 64U;     // longer names are truncated
+static const std::size_t cPrefix = 3U;       // letters of a name in a block key
+static const std::size_t cPhoneDigits = 9U;  // "06 12 34 56 78" and "+33 6 12 34 56 78" are the same
+
+// Block kinds, part of the key
+static const std::uint8_t cBlockLastFirst = 1U;
+static const std::uint8_t cBlockFirstLast = 2U;
+static const std::uint8_t cBlockName = 3U;
+static const std::uint8_t cBlockEmail = 4U;
+static const std::uint8_t cBlockPhone = 5U;
+
+/**
+ * @brief Folded name reduced to letters and digits ("Jean-Pierre" is "jeanpierre")
+ */
+static std::size_t Normalize(const std::string &text, char *buffer)
+{
+    char folded[cMaxName];
+    std::size_t length = SearchIndex::Fold(text, folded, cMaxName);
+    std::size_t size = 0U;
+
+    for (std::size_t i = 0U; i < length; i++)
+    {
+        if (std::isalnum(static_cast<unsigned char>(folded[i])) != 0)
+        {
+            buffer[size++] = folded[i];
+        }
+    }
+    return size;
+}
+
+// FNV-1a over the kind and two strings
+static std::uint64_t Hash(std::uint8_t kind, const char *a, std::size_t aLength, const char *b = nullptr, std::size_t bLength = 0U)
+{
+    const std::uint64_t prime = 1099511628211ULL;
+    std::uint64_t hash = 14695981039346656037ULL;
+
+    hash = (hash ^ kind) * prime;
+    for (std::size_t i = 0U; i < aLength; i++)
+    {
+        hash = (hash ^ static_cast<std::uint8_t>(a[i])) * prime;
+    }
+    hash = (hash ^ 0xFFU) * prime;
+    for (std::size_t i = 0U; i < bLength; i++)
+    {
+        hash = (hash ^ static_cast<std::uint8_t>(b[i])) * prime;
+    }
+    return hash;
+}
+
+static std::uint64_t EmailKey(const std::string &email)
+{
+    char folded[cMaxName];
+    std::size_t length = SearchIndex::Fold(email, folded, cMaxName);
+    char *begin = folded;
+    char *end = folded + length;
+
+    while ((begin < end) && std::isspace(static_cast<unsigned char>(*begin)))
+    {
+        begin++;
+    }
+    while ((end > begin) && std::isspace(static_cast<unsigned char>(end[-1])))
+    {
+        end--;
+    }
+    return (std::find(begin, end, '@') != end) ? Hash(cBlockEmail, begin, static_cast<std::size_t>(end - begin)) : 0U;
+}
+
+static std::uint64_t PhoneKey(const std::string &phone)
+{
+    char digits[cMaxName];
+    std::size_t length = 0U;
+
+    for (std::size_t i = 0U; (i < phone.size()) && (length < cMaxName); i++)
+    {
+        if (std::isdigit(static_cast<unsigned char>(phone[i])) != 0)
+        {
+            digits[length++] = phone[i];
+        }
+    }
+    return (length >= cPhoneDigits) ? Hash(cBlockPhone, digits + length - cPhoneDigits, cPhoneDigits) : 0U;
+}
+
+/**
+ * @brief Characters of a string as bit masks, for the bit-parallel distance
+ */
+struct Pattern
+{
+    std::uint64_t peq[256];
+    std::size_t length;
+    const char *text;
+
+    Pattern(const char *t, std::size_t size)
+        : length(size)
+        , text(t)
+    {
+        std::memset(peq, 0, sizeof(peq));
+        for (std::size_t i = 0U; (i < size) && (i < DuplicateDetector::cMaxPattern); i++)
+        {
+            peq[static_cast<std::uint8_t>(t[i])] |= (1ULL << i);
+        }
+    }
+};
+
+// Classic dynamic programming, for the strings too long for a machine word
+static int Levenshtein(const char *a, std::size_t m, const char *b, std::size_t n)
+{
+    std::vector<int> row(n + 1U);
+    for (std::size_t j = 0U; j <= n; j++)
+    {
+        row[j] = static_cast<int>(j);
+    }
+    for (std::size_t i = 1U; i <= m; i++)
+    {
+        int diagonal = row[0];
+        row[0] = static_cast<int>(i);
+        for (std::size_t j = 1U; j <= n; j++)
+        {
+            int up = row[j];
+            row[j] = std::min(std::min(row[j] + 1, row[j - 1] + 1), diagonal + ((a[i - 1U] == b[j - 1U]) ? 0 : 1));
+            diagonal = up;
+        }
+    }
+    return row[n];
+}
+
+/**
+ * @brief Myers' bit-vector algorithm (Hyyrö's formulation, global distance)
+ *
+ * One column of the distance matrix is held in two bit vectors, so the
+ * cost is one step of a few word operations per character of the text.
+ */
+static int Distance(const Pattern &p, const char *text, std::size_t n)
+{
+    if (p.length == 0U)
+    {
+        return static_cast<int>(n);
+    }
+    if (p.length > DuplicateDetector::cMaxPattern)
+    {
+        return Levenshtein(p.text, p.length, text, n);
+    }
+
+    std::uint64_t pv = (p.length == 64U) ? ~0ULL : ((1ULL << p.length) - 1U);
+    std::uint64_t mv = 0U;
+    std::uint64_t last = 1ULL << (p.length - 1U);
+    int score = static_cast<int>(p.length);
+
+    for (std::size_t j = 0U; j < n; j++)
+    {
+        std::uint64_t eq = p.peq[static_cast<std::uint8_t>(text[j])];
+        std::uint64_t xv = eq | mv;
+        std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        std::uint64_t ph = mv | ~(xh | pv);
+        std::uint64_t mh = pv & xh;
+
+        if ((ph & last) != 0U)
+        {
+            score++;
+        }
+        else if ((mh & last) != 0U)
+        {
+            score--;
+        }
+
+        ph = (ph << 1) | 1U;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+// Distance if it is at most the limit, limit + 1 otherwise
+static int Bounded(const Pattern &p, const char *text, std::size_t size, int limit)
+{
+    int difference = static_cast<int>(p.length) - static_cast<int>(size);
+    if ((difference > limit) || (-difference > limit))
+    {
+        return limit + 1;
+    }
+    return std::min(Distance(p, text, size), limit + 1);
+}
+
+// Typos accepted for a name of that length
+static int MaxTypos(std::size_t length)
+{
+    return (length < 5U) ? 0 : ((length < 10U) ? 1 : 2);
+}
+
+static int CountReasons(std::uint32_t reasons)
+{
+    int count = 0;
+    for (; reasons != 0U; reasons &= (reasons - 1U))
+    {
+        count++;
+    }
+    return count;
+}
+
+/*****************************************************************************/
+std::string DuplicateMatch::ToString() const
+{
+    static const char *cLabels[] = { "même nom", "nom proche", "nom et prénom inversés", "même e-mail", "même téléphone" };
+    std::string text;
+
+    for (std::uint32_t i = 0U; i < 5U; i++)
+    {
+        if ((reasons & (1U << i)) != 0U)
+        {
+            text += (text.empty() ? "" : ", ") + std::string(cLabels[i]);
+        }
+    }
+    return text;
+}
+
+/*****************************************************************************/
+void DuplicateDetector::Clear()
+{
+    mEntries.clear();
+    mKeys.clear();
+    mBlocks.clear();
+    mRecent.clear();
+}
+
+void DuplicateDetector::Build(const std::deque<Player> &players)
+{
+    TRACE_SCOPE("duplicates.Build");
+    Clear();
+    mEntries.reserve(players.size());
+    mBlocks.reserve(players.size() * 6U);
+    for (auto const &player : players)
+    {
+        Add(player);
+    }
+    Finish();
+}
+
+void DuplicateDetector::Add(const Player &player)
+{
+    char last[cMaxName];
+    char first[cMaxName];
+    std::size_t lastLength = Normalize(player.lastName, last);
+    std::size_t firstLength = Normalize(player.name, first);
+    std::uint32_t index = static_cast<std::uint32_t>(mEntries.size());
+
+    Entry entry;
+    entry.id = player.id;
+    entry.offset = static_cast<std::uint32_t>(mKeys.size());
+    entry.length = static_cast<std::uint32_t>(lastLength + 1U + firstLength);
+    mEntries.push_back(entry);
+    mKeys.insert(mKeys.end(), last, last + lastLength);
+    mKeys.push_back(' ');
+    mKeys.insert(mKeys.end(), first, first + firstLength);
+
+    if ((lastLength + firstLength) > 0U)
+    {
+        AddBlock(Hash(cBlockLastFirst, last, std::min(lastLength, cPrefix), first, std::min<std::size_t>(firstLength, 1U)), index);
+        AddBlock(Hash(cBlockFirstLast, first, std::min(firstLength, cPrefix), last, std::min<std::size_t>(lastLength, 1U)), index);
+        AddBlock(Hash(cBlockName, last, lastLength, first, firstLength), index);
+    }
+
+    for (std::uint64_t key : { EmailKey(player.email), PhoneKey(player.mobilePhone), PhoneKey(player.homePhone) })
+    {
+        if (key != 0U)
+        {
+            AddBlock(key, index);
+        }
+    }
+}
+
+void DuplicateDetector::AddBlock(std::uint64_t key, std::uint32_t entry)
+{
+    // The same phone twice is one block, the blocks of the entry are the last ones
+    for (auto it = mRecent.rbegin(); (it != mRecent.rend()) && (it->entry == entry); ++it)
+    {
+        if (it->key == key)
+        {
+            return;
+        }
+    }
+
+    Block block;
+    block.key = key;
+    block.entry = entry;
+    mRecent.push_back(block);
+    if (mRecent.size() >= cMaxRecent)
+    {
+        Merge();
+    }
+}
+
+void DuplicateDetector::Merge()
+{
+    std::size_t middle = mBlocks.size();
+    std::sort(mRecent.begin(), mRecent.end());
+    mBlocks.insert(mBlocks.end(), mRecent.begin(), mRecent.end());
+    std::inplace_merge(mBlocks.begin(), mBlocks.begin() + middle, mBlocks.end());
+    mRecent.clear();
+}
+
+void DuplicateDetector::Finish()
+{
+    Merge();
+    mEntries.shrink_to_fit();
+    mKeys.shrink_to_fit();
+    mBlocks.shrink_to_fit();
+}
+
+std::size_t DuplicateDetector::MemoryUsage() const
+{
+    return (mEntries.capacity() * sizeof(Entry)) + mKeys.capacity() +
+           ((mBlocks.capacity() + mRecent.capacity()) * sizeof(Block));
+}
+
+void DuplicateDetector::Probe(std::uint64_t key, std::vector<std::uint32_t> &candidates) const
+{
+    Block lower;
+    lower.key = key;
+    lower.entry = 0U;
+
+    for (auto it = std::lower_bound(mBlocks.begin(), mBlocks.end(), lower); (it != mBlocks.end()) && (it->key == key); ++it)
+    {
+        candidates.push_back(it->entry);
+    }
+    for (auto const &b : mRecent)
+    {
+        if (b.key == key)
+        {
+            candidates.push_back(b.entry);
+        }
+    }
+}
+
+bool DuplicateDetector::InBlock(std::uint64_t key, std::uint32_t entry) const
+{
+    Block block;
+    block.key = key;
+    block.entry = entry;
+
+    if (std::binary_search(mBlocks.begin(), mBlocks.end(), block))
+    {
+        return true;
+    }
+    for (auto const &b : mRecent)
+    {
+        if ((b.key == key) && (b.entry == entry))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DuplicateDetector::SameName(std::uint32_t entry, const char *last, std::size_t lastLength, const char *first, std::size_t firstLength) const
+{
+    const Entry &e = mEntries[entry];
+    const char *key = mKeys.data() + e.offset;
+
+    return (e.length == (lastLength + 1U + firstLength)) &&
+           (std::memcmp(key, last, lastLength) == 0) &&
+           (std::memcmp(key + lastLength + 1U, first, firstLength) == 0);
+}
+
+bool DuplicateDetector::HasName(const Player &player) const
+{
+    char last[cMaxName];
+    char first[cMaxName];
+    std::size_t lastLength = Normalize(player.lastName, last);
+    std::size_t firstLength = Normalize(player.name, first);
+
+    if ((lastLength + firstLength) == 0U)
+    {
+        return false;
+    }
+
+    Block lower;
+    lower.key = Hash(cBlockName, last, lastLength, first, firstLength);
+    lower.entry = 0U;
+
+    for (auto it = std::lower_bound(mBlocks.begin(), mBlocks.end(), lower); (it != mBlocks.end()) && (it->key == lower.key); ++it)
+    {
+        if (SameName(it->entry, last, lastLength, first, firstLength))
+        {
+            return true;
+        }
+    }
+    for (auto const &b : mRecent)
+    {
+        if ((b.key == lower.key) && SameName(b.entry, last, lastLength, first, firstLength))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<DuplicateMatch> DuplicateDetector::Find(const Player &player) const
+{
+    char last[cMaxName];
+    char first[cMaxName];
+    std::size_t lastLength = Normalize(player.lastName, last);
+    std::size_t firstLength = Normalize(player.name, first);
+    std::vector<std::uint32_t> candidates;
+    std::vector<DuplicateMatch> matches;
+
+    std::uint64_t contacts[3] = { EmailKey(player.email), PhoneKey(player.mobilePhone), PhoneKey(player.homePhone) };
+
+    if ((lastLength + firstLength) > 0U)
+    {
+        std::size_t lastInitial = std::min<std::size_t>(lastLength, 1U);
+        std::size_t firstInitial = std::min<std::size_t>(firstLength, 1U);
+
+        Probe(Hash(cBlockLastFirst, last, std::min(lastLength, cPrefix), first, firstInitial), candidates);
+        Probe(Hash(cBlockFirstLast, first, std::min(firstLength, cPrefix), last, lastInitial), candidates);
+        // Swapped names
+        Probe(Hash(cBlockLastFirst, first, std::min(firstLength, cPrefix), last, lastInitial), candidates);
+        Probe(Hash(cBlockFirstLast, last, std::min(lastLength, cPrefix), first, firstInitial), candidates);
+    }
+    for (std::uint64_t key : contacts)
+    {
+        if (key != 0U)
+        {
+            Probe(key, candidates);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    if (candidates.empty())
+    {
+        return matches;
+    }
+
+    // "last first" and "first last" of the query
+    char name[(2U * cMaxName) + 1U];
+    char swapped[(2U * cMaxName) + 1U];
+    std::size_t length = lastLength + 1U + firstLength;
+    std::memcpy(name, last, lastLength);
+    name[lastLength] = ' ';
+    std::memcpy(name + lastLength + 1U, first, firstLength);
+    std::memcpy(swapped, first, firstLength);
+    swapped[firstLength] = ' ';
+    std::memcpy(swapped + firstLength + 1U, last, lastLength);
+
+    Pattern pattern(name, length);
+    Pattern swappedPattern(swapped, length);
+    int limit = MaxTypos(length - 1U);
+
+    for (std::uint32_t index : candidates)
+    {
+        const Entry &entry = mEntries[index];
+        DuplicateMatch match;
+        match.playerId = entry.id;
+        match.reasons = 0U;
+        match.distance = limit + 1;
+
+        if ((lastLength + firstLength) > 0U)
+        {
+            const char *key = mKeys.data() + entry.offset;
+            int distance = Bounded(pattern, key, entry.length, limit);
+            int swappedDistance = Bounded(swappedPattern, key, entry.length, limit);
+
+            if (distance == 0)
+            {
+                match.reasons |= DuplicateMatch::cSameName;
+            }
+            else if (distance <= limit)
+            {
+                match.reasons |= DuplicateMatch::cSimilarName;
+            }
+            else if (swappedDistance <= limit)
+            {
+                match.reasons |= DuplicateMatch::cSwappedNames;
+            }
+            match.distance = std::min(distance, swappedDistance);
+        }
+
+        // The candidate may come from a name block: look for it in the other blocks
+        for (std::uint32_t k = 0U; k < 3U; k++)
+        {
+            if ((contacts[k] != 0U) && InBlock(contacts[k], index))
+            {
+                match.reasons |= (k == 0U) ? DuplicateMatch::cSameEmail : DuplicateMatch::cSamePhone;
+            }
+        }
+
+        if (match.reasons != 0U)
+        {
+            matches.push_back(match);
+        }
+    }
+
+    // Several reasons first, then the closest names
+    std::sort(matches.begin(), matches.end(), [](const DuplicateMatch &a, const DuplicateMatch &b) {
+        int countA = CountReasons(a.reasons);
+        int countB = CountReasons(b.reasons);
+        return (countA > countB) || ((countA == countB) && ((a.distance < b.distance) ||
+                                     ((a.distance == b.distance) && (a.playerId < b.playerId))));
+    });
+    return matches;
+}
+
+int DuplicateDetector::EditDistance(const std::string &a, const std::string &b)
+{
+    // The shorter string is the pattern
+    const std::string &shorter = (a.size() <= b.size()) ? a : b;
+    const std::string &longer = (a.size() <= b.size()) ? b : a;
+
+    Pattern pattern(shorter.data(), shorter.size());
+    return Distance(pattern, longer.data(), longer.size());
+}
+
+//=============================================================================
+// End of file DuplicateDetector.cpp
+//=============================================================================
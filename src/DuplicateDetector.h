@@ -0,0 +1,125 @@
+/*=============================================================================
+ * Tanca - DuplicateDetector.h
+ *=============================================================================
+ * Near matches of a player in the membership base
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef DUPLICATE_DETECTOR_H
+#define DUPLICATE_DETECTOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <deque>
+
+#include "IDataBase.h"
+
+/**
+ * @brief Player of the base that may be the same person
+ */
+struct DuplicateMatch
+{
+    static const std::uint32_t cSameName     = 0x01U;
+    static const std::uint32_t cSimilarName  = 0x02U;  // accents, typos
+    static const std::uint32_t cSwappedNames = 0x04U;  // first and last names inverted
+    static const std::uint32_t cSameEmail    = 0x08U;
+    static const std::uint32_t cSamePhone    = 0x10U;
+
+    int playerId;
+    std::uint32_t reasons;
+    int distance;   // edit distance of the names
+
+    std::string ToString() const;
+};
+
+/**
+ * @brief Finds the near duplicates of a player without comparing it to every entry
+ *
+ * The names are folded (case, accents) and reduced to letters and digits.
+ * Each entry is put in a few blocks: beginning of its last name with the
+ * initial of its first name, the opposite, its e-mail and its phone numbers.
+ * A query only looks at the entries of its own blocks (also with the names
+ * swapped), then compares the names with a bit-parallel edit distance.
+ * Two typos in the first three letters of both names are not found.
+ *
+ * The keys are kept end to end in one buffer and the blocks in one sorted
+ * array; the last blocks added are kept apart until there are enough of them
+ * to be merged, so that adding a player stays cheap.
+ */
+class DuplicateDetector
+{
+public:
+    static const std::uint32_t cMaxPattern = 64U; // names are compared 64 characters at once
+    static const std::size_t cMaxRecent = 4096U;  // blocks not merged yet
+
+    void Clear();
+    void Build(const std::deque<Player> &players);
+    void Add(const Player &player);
+    // Merge all the blocks and release the spare capacity once the players are added
+    void Finish();
+    std::uint32_t Size() const { return static_cast<std::uint32_t>(mEntries.size()); }
+    std::size_t MemoryUsage() const;
+
+    // Same folded first and last names, no allocation
+    bool HasName(const Player &player) const;
+    // Most likely first
+    std::vector<DuplicateMatch> Find(const Player &player) const;
+
+    // Levenshtein distance, bit-parallel when the shorter string fits in a machine word
+    static int EditDistance(const std::string &a, const std::string &b);
+
+private:
+    struct Entry
+    {
+        int id;
+        std::uint32_t offset;   // "last first", normalized, in mKeys
+        std::uint32_t length;
+    };
+
+    struct Block
+    {
+        std::uint64_t key;
+        std::uint32_t entry;
+
+        bool operator<(const Block &other) const
+        {
+            return (key < other.key) || ((key == other.key) && (entry < other.entry));
+        }
+    };
+
+    std::vector<Entry> mEntries;
+    std::vector<char> mKeys;
+    std::vector<Block> mBlocks; // sorted by key, then entry
+    std::vector<Block> mRecent; // last blocks added, in order
+
+    void AddBlock(std::uint64_t key, std::uint32_t entry);
+    void Merge();
+    void Probe(std::uint64_t key, std::vector<std::uint32_t> &candidates) const;
+    bool InBlock(std::uint64_t key, std::uint32_t entry) const;
+    bool SameName(std::uint32_t entry, const char *last, std::size_t lastLength, const char *first, std::size_t firstLength) const;
+};
+
+#endif // DUPLICATE_DETECTOR_H
+
+//=============================================================================
+// End of file DuplicateDetector.h
+//=============================================================================
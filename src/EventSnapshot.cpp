@@ -0,0 +1,102 @@
+/*=============================================================================
+ * Tanca - EventSnapshot.cpp
+ *=============================================================================
+ * Columnar, read-only copy of the games and teams used by the algorithms
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include "EventSnapshot.h"
+
+const std::uint32_t EventSnapshot::cNone;
+const std::uint32_t EventSnapshot::cDummy;
+
+void EventSnapshot::Build(const std::deque<Game> &games, const std::deque<Team> &teams)
+{
+    std::size_t nbTeams = teams.size();
+    std::size_t nbGames = games.size();
+
+    teamIds.clear();
+    player1Ids.clear();
+    player2Ids.clear();
+    mTeamIndex.clear();
+
+    teamIds.reserve(nbTeams);
+    player1Ids.reserve(nbTeams);
+    player2Ids.reserve(nbTeams);
+    mTeamIndex.reserve(nbTeams);
+
+    for (auto const &t : teams)
+    {
+        mTeamIndex[t.id] = static_cast<std::uint32_t>(teamIds.size());
+        teamIds.push_back(t.id);
+        player1Ids.push_back(t.player1Id);
+        player2Ids.push_back(t.player2Id);
+    }
+
+    gameIds.resize(nbGames);
+    eventIds.resize(nbGames);
+    turns.resize(nbGames);
+    team1.resize(nbGames);
+    team2.resize(nbGames);
+    score1.resize(nbGames);
+    score2.resize(nbGames);
+
+    std::uint32_t i = 0U;
+    for (auto const &g : games)
+    {
+        gameIds[i] = g.id;
+        eventIds[i] = g.eventId;
+        turns[i] = g.turn;
+        team1[i] = (g.team1Id == Team::cDummyTeam) ? cDummy : FindTeam(g.team1Id);
+        team2[i] = (g.team2Id == Team::cDummyTeam) ? cDummy : FindTeam(g.team2Id);
+        score1[i] = g.team1Score;
+        score2[i] = g.team2Score;
+        i++;
+    }
+
+    BuildIndex();
+}
+
+void EventSnapshot::BuildIndex()
+{
+    std::size_t nbTeams = teamIds.size();
+
+    mTeamIndex.clear();
+    mTeamIndex.reserve(nbTeams);
+    for (std::uint32_t t = 0U; t < nbTeams; t++)
+    {
+        mTeamIndex[teamIds[t]] = t;
+    }
+
+    mMet.assign(nbTeams * nbTeams, 0U);
+    for (std::uint32_t g = 0U; g < gameIds.size(); g++)
+    {
+        if (IsTeam(team1[g]) && IsTeam(team2[g]))
+        {
+            mMet[team1[g] * nbTeams + team2[g]] = 1U;
+            mMet[team2[g] * nbTeams + team1[g]] = 1U;
+        }
+    }
+}
+
+//=============================================================================
+// End of file EventSnapshot.cpp
+//=============================================================================
@@ -0,0 +1,103 @@
+/*=============================================================================
+ * Tanca - EventSnapshot.h
+ *=============================================================================
+ * Columnar, read-only copy of the games and teams used by the algorithms
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef EVENT_SNAPSHOT_H
+#define EVENT_SNAPSHOT_H
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+#include "IDataBase.h"
+
+/**
+ * @brief Struct of arrays holding only the numbers needed to rank and pair
+ *
+ * Teams and games are referenced by their index in the columns, the game
+ * columns store team indices instead of ids. No string is copied: names and
+ * documents stay in the original lists, which can be accessed by index.
+ */
+struct EventSnapshot
+{
+    static const std::uint32_t cNone = 0xFFFFFFFFU;   // Team not in the snapshot
+    static const std::uint32_t cDummy = 0xFFFFFFFEU;  // Dummy team of a bye
+
+    // Team columns
+    std::vector<int> teamIds;
+    std::vector<int> player1Ids;
+    std::vector<int> player2Ids;
+
+    // Game columns
+    std::vector<int> gameIds;
+    std::vector<int> eventIds;
+    std::vector<int> turns;
+    std::vector<std::uint32_t> team1;
+    std::vector<std::uint32_t> team2;
+    std::vector<int> score1;
+    std::vector<int> score2;
+
+    void Build(const std::deque<Game> &games, const std::deque<Team> &teams);
+    // Team index and met matrix, once the columns are filled
+    void BuildIndex();
+
+    std::uint32_t TeamCount() const { return static_cast<std::uint32_t>(teamIds.size()); }
+    std::uint32_t GameCount() const { return static_cast<std::uint32_t>(gameIds.size()); }
+
+    std::uint32_t FindTeam(int id) const
+    {
+        auto it = mTeamIndex.find(id);
+        return (it == mTeamIndex.end()) ? cNone : it->second;
+    }
+
+    static bool IsTeam(std::uint32_t index) { return index < cDummy; }
+
+    // Same rules as Game::IsPlayed() and Game::HasBye()
+    bool IsPlayed(std::uint32_t game) const
+    {
+        return (score1[game] != -1) && (score2[game] != -1) && ((score1[game] + score2[game]) > 0);
+    }
+
+    bool HasBye(std::uint32_t game) const
+    {
+        return (team1[game] == cDummy) || (team2[game] == cDummy);
+    }
+
+    // Both teams met in any game of the snapshot, played or not
+    bool HasMet(std::uint32_t t1, std::uint32_t t2) const
+    {
+        return mMet[t1 * teamIds.size() + t2] != 0U;
+    }
+
+private:
+    std::unordered_map<int, std::uint32_t> mTeamIndex;
+    std::vector<std::uint8_t> mMet; // Square matrix, TeamCount() x TeamCount()
+};
+
+#endif // EVENT_SNAPSHOT_H
+
+//=============================================================================
+// End of file EventSnapshot.h
+//=============================================================================
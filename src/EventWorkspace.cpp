@@ -0,0 +1,473 @@
+/*=============================================================================
+ * Tanca - EventWorkspace.cpp
+ *=============================================================================
+ * Several events kept in memory, each one with its own ranking engine
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+
+#include "EventWorkspace.h"
+#include "DbManager.h"
+#include "Profiler.h"
+#include "AsyncLog.h"
+
+const std::uint32_t EventWorkspace::cMaxSessions;
+
+EventSession::EventSession()
+    : teamsStale(false)
+    , lastUse(0U)
+    , mRanking(&mTournament.GetRanking())
+    , mRankingRound(1)
+    , mRankingDirty(true)
+{
+
+}
+
+EventSession::~EventSession()
+{
+    Wait();
+}
+
+void EventSession::SetTeams(const std::deque<Team> &list)
+{
+    Wait();
+    teams = list;
+    teamIds.Build(teams);
+    teamsStale = false;
+    mRankingDirty = true;
+    mBracket.reset();
+    mStandings.Reset(teams); // Replayed from the start of the log
+}
+
+void EventSession::SetGames(const std::deque<Game> &list)
+{
+    Wait();
+    games = list;
+    gameIds.Build(games);
+    mRankingDirty = true;
+    mBracket.reset();
+}
+
+void EventSession::SetGame(const Game &game)
+{
+    Wait();
+    int index = gameIds.IndexOf(game.id);
+    if (index >= 0)
+    {
+        games[index] = game;
+        mRankingDirty = true;
+    }
+}
+
+void EventSession::AddGames(const std::deque<Game> &list)
+{
+    Wait();
+    for (auto const &game : list)
+    {
+        gameIds.Add(game.id, static_cast<std::uint32_t>(games.size()));
+        games.push_back(game);
+
+        int match = Bracket::GetMatchId(game);
+        if (mBracket && (match > 0))
+        {
+            mBracket->SetGameId(static_cast<std::uint32_t>(match), game.id);
+        }
+    }
+    mRankingDirty = true;
+}
+
+void EventSession::RemoveGame(int id)
+{
+    Wait();
+    int index = gameIds.IndexOf(id);
+    if (index >= 0)
+    {
+        games.erase(games.begin() + index);
+        gameIds.Build(games);
+        mRankingDirty = true;
+        mBracket.reset();
+    }
+}
+
+void EventSession::SetRankingRound(int round)
+{
+    Wait();
+    if (round != mRankingRound)
+    {
+        mRankingRound = round;
+        mRankingDirty = true;
+    }
+}
+
+/**
+ * @brief Number of complete rounds, a bye counts as a game
+ */
+int EventSession::GetMaxRound() const
+{
+    int nbGames = teams.size() / 2;
+    if (teams.size() % 2)
+    {
+        nbGames += 1;
+    }
+
+    return (nbGames == 0) ? 0 : (games.size() / nbGames);
+}
+
+const std::deque<Rank> &EventSession::GetRanking()
+{
+    Wait();
+    ComputeRanking();
+    return *mRanking;
+}
+
+void EventSession::ApplyLog(const std::deque<ScoreEntry> &entries)
+{
+    if (entries.size() > 0U)
+    {
+        Wait();
+        mStandings.Apply(entries);
+        mRankingDirty = true;
+    }
+}
+
+/**
+ * @brief The standings are up to date with the games, and all the rounds are ranked
+ */
+bool EventSession::IsLive() const
+{
+    if (mStandings.GetGameCount() != games.size())
+    {
+        return false;
+    }
+
+    for (auto const &game : games)
+    {
+        if (game.turn >= mRankingRound)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EventSession::RankAsync()
+{
+    // Never read the flag while a task may write it
+    if (!mTask.valid() && mRankingDirty)
+    {
+        mTask = std::async(std::launch::async, [this]() { ComputeRanking(); });
+    }
+}
+
+void EventSession::Wait()
+{
+    if (mTask.valid())
+    {
+        mTask.get();
+    }
+}
+
+void EventSession::ComputeRanking()
+{
+    if (mRankingDirty)
+    {
+        if (IsLive())
+        {
+            mRanking = &mStandings.GetRanking();
+        }
+        else
+        {
+            TRACE_SCOPE("workspace.Rank");
+            mTournament.GenerateTeamRanking(games, teams, mRankingRound);
+            mRanking = &mTournament.GetRanking();
+        }
+        mRankingDirty = false;
+    }
+}
+
+std::string EventSession::BuildSwissRound(std::deque<Game> &newGames, const std::unordered_map<int, double> &strength) const
+{
+    // Own engine: the cached ranking is left untouched
+    Tournament tournament;
+    tournament.SetStrength(strength);
+    return tournament.BuildSwissRounds(games, teams, newGames);
+}
+
+/**
+ * @brief Replay the bracket games in the order of the rounds
+ *
+ * The games played before the bracket (Swiss rounds) only shift the turns.
+ */
+Bracket *EventSession::GetBracket()
+{
+    if (!mBracket && event.IsKnockout())
+    {
+        std::vector<std::pair<int, int>> seeded; // seed, team id
+        for (auto const &team : teams)
+        {
+            int seed = Bracket::GetSeed(team);
+            if (seed > 0)
+            {
+                seeded.push_back(std::make_pair(seed, team.id));
+            }
+        }
+
+        if (seeded.size() > 0U)
+        {
+            TRACE_SCOPE("workspace.Bracket");
+            std::sort(seeded.begin(), seeded.end());
+            std::vector<int> seeds;
+            for (auto const &s : seeded)
+            {
+                seeds.push_back(s.second);
+            }
+
+            std::deque<Game> previous;
+            std::vector<const Game *> played;
+            for (auto const &game : games)
+            {
+                if (Bracket::GetMatchId(game) > 0)
+                {
+                    played.push_back(&game);
+                }
+                else
+                {
+                    previous.push_back(game);
+                }
+            }
+            std::stable_sort(played.begin(), played.end(), [](const Game *a, const Game *b) {
+                return a->turn < b->turn;
+            });
+
+            mBracket.reset(new Bracket());
+            mBracket->Build(seeds, event.type == Event::cDoubleElimination, static_cast<int>(Tournament::CountRounds(previous)));
+
+            std::vector<std::uint32_t> changed;
+            for (auto game : played)
+            {
+                std::uint32_t match = static_cast<std::uint32_t>(Bracket::GetMatchId(*game));
+                mBracket->SetGameId(match, game->id);
+
+                int winner = Bracket::GetWinner(*game);
+                if ((winner != Bracket::cNone) && !mBracket->SetResult(match, winner, changed))
+                {
+                    ALogError("Game " << game->id << " does not match the bracket");
+                }
+            }
+        }
+    }
+    return mBracket.get();
+}
+
+/*****************************************************************************/
+EventWorkspace::EventWorkspace(DbManager &db, std::uint32_t maxSessions)
+    : mDatabase(db)
+    , mMaxSessions(std::max(maxSessions, 1U))
+    , mClock(0U)
+    , mPinned(-1)
+{
+
+}
+
+EventSession *EventWorkspace::Open(int eventId)
+{
+    EventSession *session = Find(eventId);
+
+    if (session == nullptr)
+    {
+        TRACE_SCOPE("workspace.Open");
+        Event event = mDatabase.GetEvent(eventId);
+        if (event.IsValid())
+        {
+            Evict();
+
+            std::unique_ptr<EventSession> created(new EventSession());
+            session = created.get();
+            session->event = event;
+            mSessions[eventId] = std::move(created);
+
+            ReloadTeams(*session);
+            ReloadGames(*session);
+            ALogDebug("Event " << eventId << " loaded, " << mSessions.size() << " in the workspace");
+        }
+    }
+    else if (session->teamsStale)
+    {
+        ReloadTeams(*session);
+    }
+
+    if (session != nullptr)
+    {
+        session->lastUse = ++mClock;
+        Sync(*session);
+    }
+    return session;
+}
+
+EventSession *EventWorkspace::Find(int eventId)
+{
+    auto it = mSessions.find(eventId);
+    return (it == mSessions.end()) ? nullptr : it->second.get();
+}
+
+void EventWorkspace::Close(int eventId)
+{
+    // The destructor waits for the background task
+    mSessions.erase(eventId);
+}
+
+void EventWorkspace::Clear()
+{
+    mSessions.clear();
+    mPinned = -1;
+}
+
+/**
+ * @brief Make room for a new session: close the least recently used ones
+ *
+ * The pinned session is kept, the caller holds a pointer to it.
+ */
+void EventWorkspace::Evict()
+{
+    while (mSessions.size() >= mMaxSessions)
+    {
+        auto oldest = mSessions.end();
+        for (auto it = mSessions.begin(); it != mSessions.end(); ++it)
+        {
+            if ((it->first != mPinned) && ((oldest == mSessions.end()) || (it->second->lastUse < oldest->second->lastUse)))
+            {
+                oldest = it;
+            }
+        }
+
+        if (oldest == mSessions.end())
+        {
+            break; // only the pinned session is left
+        }
+        mSessions.erase(oldest);
+    }
+}
+
+void EventWorkspace::ReloadTeams(EventSession &session)
+{
+    session.SetTeams(mDatabase.GetTeams(session.event.id));
+}
+
+void EventWorkspace::ReloadGames(EventSession &session)
+{
+    session.SetGames(mDatabase.GetGamesByEventId(session.event.id));
+}
+
+void EventWorkspace::Sync(EventSession &session)
+{
+    session.ApplyLog(mDatabase.GetScoreLog(session.event.id, session.GetLogCursor()));
+}
+
+void EventWorkspace::InvalidateTeams()
+{
+    for (auto &s : mSessions)
+    {
+        s.second->teamsStale = true;
+    }
+}
+
+void EventWorkspace::RankAll()
+{
+    for (auto &s : mSessions)
+    {
+        Sync(*s.second);
+        s.second->RankAsync();
+    }
+}
+
+/**
+ * @brief Only the ratings of the players of the event are read
+ */
+std::unordered_map<int, double> EventWorkspace::GetStrength(const EventSession &session)
+{
+    std::unordered_map<int, double> strength;
+
+    if (session.event.HasOption(Event::cOptionSeededFirstRound) && (session.games.size() == 0U))
+    {
+        std::vector<int> playerIds;
+        std::vector<const Team *> rated;
+        for (auto const &team : session.teams)
+        {
+            std::size_t count = playerIds.size();
+            for (int id : { team.player1Id, team.player2Id, team.player3Id })
+            {
+                if ((id >= 0) && (id != Player::cDummyPlayer))
+                {
+                    playerIds.push_back(id);
+                }
+            }
+
+            // A team without any player (the dummy team) is the weakest one
+            if (playerIds.size() > count)
+            {
+                rated.push_back(&team);
+            }
+        }
+
+        RatingEngine ratings;
+        ratings.SetRatings(mDatabase.GetRatings(playerIds));
+        for (auto team : rated)
+        {
+            strength[team->id] = ratings.GetTeamRating(*team);
+        }
+    }
+    return strength;
+}
+
+std::vector<Pairing> EventWorkspace::Pair(const std::vector<EventSession *> &sessions)
+{
+    TRACE_SCOPE("workspace.Pair");
+    std::vector<Pairing> result(sessions.size());
+    std::vector<std::unordered_map<int, double>> strengths;
+    std::vector<std::future<void>> tasks;
+
+    // The database is read here, not by the tasks
+    for (auto session : sessions)
+    {
+        strengths.push_back(GetStrength(*session));
+    }
+
+    for (std::uint32_t i = 0; i < sessions.size(); i++)
+    {
+        Pairing *pairing = &result[i];
+        const std::unordered_map<int, double> *strength = &strengths[i];
+        pairing->session = sessions[i];
+        tasks.push_back(std::async(std::launch::async, [pairing, strength]() {
+            pairing->error = pairing->session->BuildSwissRound(pairing->games, *strength);
+        }));
+    }
+
+    for (auto &t : tasks)
+    {
+        t.get();
+    }
+    return result;
+}
+
+//=============================================================================
+// End of file EventWorkspace.cpp
+//=============================================================================
@@ -0,0 +1,176 @@
+/*=============================================================================
+ * Tanca - EventWorkspace.h
+ *=============================================================================
+ * Several events kept in memory, each one with its own ranking engine
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef EVENT_WORKSPACE_H
+#define EVENT_WORKSPACE_H
+
+#include <cstdint>
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <future>
+#include <unordered_map>
+
+#include "IDataBase.h"
+#include "Tournament.h"
+#include "Brackets.h"
+#include "Ratings.h"
+#include "ScoreLog.h"
+
+class DbManager;
+
+/**
+ * @brief One loaded event: its teams, its games and its cached ranking
+ *
+ * The ranking may be computed by a background task. The task only reads the
+ * teams and the games, so they can be displayed meanwhile; any modification
+ * goes through the methods below, which wait for the task first.
+ *
+ * The ranking of all the rounds comes from the standings fed by the score
+ * log, it is not computed again after each score.
+ */
+class EventSession
+{
+public:
+    Event event;
+    std::deque<Team> teams;
+    std::deque<Game> games;
+    IdIndex<Team> teamIds;
+    IdIndex<Game> gameIds;
+
+    EventSession();
+    ~EventSession();
+
+    const Team *FindTeam(int id) const { return teamIds.Find(id); }
+    const Game *FindGame(int id) const { return gameIds.Find(id); }
+
+    void SetTeams(const std::deque<Team> &list);
+    void SetGames(const std::deque<Game> &list);
+    void SetGame(const Game &game);
+    void AddGames(const std::deque<Game> &list);
+    void RemoveGame(int id);
+
+    int GetRankingRound() const { return mRankingRound; }
+    void SetRankingRound(int round);
+    int GetMaxRound() const;
+
+    // Ranking up to the current round, computed now if the task is not done
+    const std::deque<Rank> &GetRanking();
+    // Score log entries after the cursor
+    std::int64_t GetLogCursor() const { return mStandings.GetCursor(); }
+    void ApplyLog(const std::deque<ScoreEntry> &entries);
+    void RankAsync();
+    void Wait();
+
+    // Next Swiss round, the session data is only read. The strength seeds the first round.
+    std::string BuildSwissRound(std::deque<Game> &newGames, const std::unordered_map<int, double> &strength) const;
+
+    // Knockout event: bracket rebuilt from the team seeds and the games, nullptr if not seeded yet
+    Bracket *GetBracket();
+
+    bool teamsStale; // player names have changed since the teams were loaded
+    std::uint32_t lastUse;
+
+private:
+    Tournament mTournament;
+    LiveStandings mStandings;
+    const std::deque<Rank> *mRanking;
+    int mRankingRound;
+    bool mRankingDirty;
+    std::future<void> mTask;
+    std::unique_ptr<Bracket> mBracket;
+
+    void ComputeRanking();
+    bool IsLive() const;
+};
+
+/**
+ * @brief The next round of an event, built by EventWorkspace::Pair()
+ */
+struct Pairing
+{
+    EventSession *session;
+    std::deque<Game> games;
+    std::string error;
+};
+
+/**
+ * @brief Cache of the open events, switching between them does not reload anything
+ *
+ * Each session owns its Tournament so that the rankings and the pairings of
+ * several events can be computed at the same time. The least recently used
+ * session is closed when the cache is full, except the pinned one (the
+ * event displayed). The database is only accessed from the calling thread.
+ */
+class EventWorkspace
+{
+public:
+    static const std::uint32_t cMaxSessions = 8U;
+
+    explicit EventWorkspace(DbManager &db, std::uint32_t maxSessions = cMaxSessions);
+
+    // Cached session, or loaded from the database. May close another session!
+    EventSession *Open(int eventId);
+    EventSession *Find(int eventId);
+    void Close(int eventId);
+    void Clear();
+    // This session is never closed to make room, -1 for none
+    void Pin(int eventId) { mPinned = eventId; }
+
+    void ReloadTeams(EventSession &session);
+    void ReloadGames(EventSession &session);
+    // Apply the new entries of the score log
+    void Sync(EventSession &session);
+
+    // Player names are part of the team names
+    void InvalidateTeams();
+
+    // Rating of each team, for a first Swiss round with the seeded option (empty otherwise)
+    std::unordered_map<int, double> GetStrength(const EventSession &session);
+
+    // Start the ranking of all the modified sessions in the background
+    void RankAll();
+
+    // Next Swiss round of each session, computed concurrently
+    std::vector<Pairing> Pair(const std::vector<EventSession *> &sessions);
+
+    std::uint32_t GetSize() const { return static_cast<std::uint32_t>(mSessions.size()); }
+
+private:
+    DbManager &mDatabase;
+    std::uint32_t mMaxSessions;
+    std::uint32_t mClock;
+    int mPinned;
+    std::unordered_map<int, std::unique_ptr<EventSession>> mSessions;
+
+    void Evict();
+};
+
+#endif // EVENT_WORKSPACE_H
+
+//=============================================================================
+// End of file EventWorkspace.h
+//=============================================================================
@@ -0,0 +1,550 @@
+/*=============================================================================
+ * Tanca - Exporter.cpp
+ *=============================================================================
+ * Streaming CSV/JSON export of players, teams, games and rankings
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <cstring>
+
+#include "Exporter.h"
+#include "DbManager.h"
+#include "SearchIndex.h"
+#include "CourtAllocator.h"
+#include "Util.h"
+#include "Log.h"
+
+Exporter::Exporter()
+    : mFile(nullptr)
+    , mStdout(false)
+    , mFormat(cCsv)
+    , mError(false)
+    , mRows(0U)
+    , mSize(0U)
+{
+
+}
+
+Exporter::~Exporter()
+{
+    (void) Close();
+}
+
+int Exporter::FormatFromFileName(const std::string &fileName)
+{
+    int format = cCsv;
+    std::size_t pos = fileName.find_last_of('.');
+
+    if (pos != std::string::npos)
+    {
+        if (Util::ToLower(fileName.substr(pos + 1)) == "json")
+        {
+            format = cJson;
+        }
+    }
+    return format;
+}
+
+/**
+ * @brief Create a field name from a table title: "Équipe 1" gives "equipe_1"
+ */
+std::string Exporter::NormalizeTitle(const std::string &title)
+{
+    std::string folded = SearchIndex::Fold(title);
+    std::string name;
+
+    for (auto c : folded)
+    {
+        if (c == ' ')
+        {
+            name.push_back('_');
+        }
+        else if ((c != '(') && (c != ')'))
+        {
+            name.push_back(c);
+        }
+    }
+    return name;
+}
+
+bool Exporter::Open(const std::string &fileName, const std::string &rootName)
+{
+    (void) Close();
+
+    mFormat = FormatFromFileName(fileName);
+    mError = false;
+    mRows = 0U;
+    mSize = 0U;
+    mTitles.clear();
+
+    // "-" is the standard output, for the command line
+    mStdout = (fileName == "-");
+    mFile = mStdout ? stdout : std::fopen(fileName.c_str(), "wb");
+    if (mFile != nullptr)
+    {
+        if (mFormat == cJson)
+        {
+            Write("{\"");
+            Write(rootName);
+            Write("\":[");
+        }
+    }
+    else
+    {
+        TLogError("Cannot open export file: " + fileName);
+    }
+
+    return (mFile != nullptr);
+}
+
+void Exporter::SetHeader(const std::vector<std::string> &titles)
+{
+    mTitles.clear();
+    for (auto const &t : titles)
+    {
+        mTitles.push_back(NormalizeTitle(t));
+    }
+
+    if (mFormat == cCsv)
+    {
+        for (std::uint32_t i = 0; i < mTitles.size(); i++)
+        {
+            if (i != 0)
+            {
+                Write(";", 1);
+            }
+            WriteCsvField(mTitles[i]);
+        }
+        Write("\n", 1);
+    }
+}
+
+void Exporter::AddRow(const std::list<Value> &row)
+{
+    std::uint32_t column = 0U;
+
+    if (mFormat == cJson)
+    {
+        Write((mRows == 0U) ? "{" : ",{");
+    }
+
+    for (auto const &data : row)
+    {
+        std::string field = (data.GetType() == Value::INTEGER) ? std::to_string(data.GetInteger()) : data.GetString();
+
+        if (mFormat == cJson)
+        {
+            if (column != 0U)
+            {
+                Write(",", 1);
+            }
+            WriteJsonString((column < mTitles.size()) ? mTitles[column] : std::to_string(column));
+            Write(":", 1);
+            if (data.GetType() == Value::INTEGER)
+            {
+                Write(field);
+            }
+            else
+            {
+                WriteJsonString(field);
+            }
+        }
+        else
+        {
+            if (column != 0U)
+            {
+                Write(";", 1);
+            }
+            WriteCsvField(field);
+        }
+        column++;
+    }
+
+    Write((mFormat == cJson) ? "}" : "\n");
+    mRows++;
+}
+
+bool Exporter::Close()
+{
+    bool success = false;
+
+    if (mFile != nullptr)
+    {
+        if (mFormat == cJson)
+        {
+            Write("]}");
+        }
+        Flush();
+
+        success = !mError;
+        if ((mStdout ? std::fflush(mFile) : std::fclose(mFile)) != 0)
+        {
+            success = false;
+        }
+        mFile = nullptr;
+    }
+    return success;
+}
+
+void Exporter::Write(const char *data, std::size_t size)
+{
+    while (size > 0U)
+    {
+        if (mSize == cBufferSize)
+        {
+            Flush();
+        }
+
+        std::size_t chunk = std::min(size, cBufferSize - mSize);
+        std::memcpy(&mBuffer[mSize], data, chunk);
+        mSize += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+void Exporter::Flush()
+{
+    if ((mFile != nullptr) && (mSize > 0U))
+    {
+        if (std::fwrite(mBuffer, 1U, mSize, mFile) != mSize)
+        {
+            mError = true;
+        }
+    }
+    mSize = 0U;
+}
+
+void Exporter::WriteCsvField(const std::string &field)
+{
+    if (field.find_first_of(";\"\r\n") == std::string::npos)
+    {
+        Write(field);
+    }
+    else
+    {
+        // Quote the field, double the quotes
+        Write("\"", 1);
+        for (auto c : field)
+        {
+            if (c == '"')
+            {
+                Write("\"", 1);
+            }
+            Write(&c, 1);
+        }
+        Write("\"", 1);
+    }
+}
+
+void Exporter::WriteJsonString(const std::string &str)
+{
+    Write("\"", 1);
+    for (auto c : str)
+    {
+        switch (c)
+        {
+        case '"':  Write("\\\""); break;
+        case '\\': Write("\\\\"); break;
+        case '\n': Write("\\n"); break;
+        case '\r': Write("\\r"); break;
+        case '\t': Write("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20U)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+                Write(escaped);
+            }
+            else
+            {
+                Write(&c, 1);
+            }
+            break;
+        }
+    }
+    Write("\"", 1);
+}
+
+/**
+ * @brief "(number) name" of a team, the default team if not found
+ */
+std::string Exporter::TeamLabel(const Team *team)
+{
+    static const Team cNoTeam;
+    if (team == nullptr)
+    {
+        team = &cNoTeam;
+    }
+    return "(" + std::to_string(team->number) + ") " + team->teamName;
+}
+
+/**
+ * @brief Full name of a player, the dummy player if not found
+ */
+std::string Exporter::PlayerName(const PlayerStore &players, int playerId)
+{
+    std::uint32_t row = players.IndexOf(playerId);
+    return (row != PlayerStore::cNotFound) ? players.FullName(row) : Player::Dummy().FullName();
+}
+
+/*****************************************************************************/
+bool Exporter::ExportPlayers(const std::string &fileName, const DbManager &db)
+{
+    Exporter exporter;
+
+    if (!exporter.Open(fileName, "players"))
+    {
+        return false;
+    }
+
+    exporter.SetHeader({"Id", "UUID", "Prénom", "Nom", "Pseudonyme", "E-mail", "Téléphone (mobile)", "Téléphone (maison)",
+                        "Date de naissance", "Rue", "Code postal", "Ville", "Licences", "Commentaires", "Statut", "Divers"});
+
+    db.VisitPlayers([&exporter](const Player &p) {
+        exporter.AddRow({p.id, p.uuid, p.name, p.lastName, p.nickName, p.email
+                , p.mobilePhone, p.homePhone, Util::ToISODateTime(p.birthDate), p.road, p.postCode
+                , p.city, p.membership, p.comments, p.state, p.document});
+    });
+
+    return exporter.Close();
+}
+
+bool Exporter::ExportTeams(const std::string &fileName, const std::deque<Team> &teams, const PlayerStore &players)
+{
+    Exporter exporter;
+
+    if (!exporter.Open(fileName, "teams"))
+    {
+        return false;
+    }
+
+    exporter.SetHeader({"Id", "Numéro", "Joueur 1", "Joueur 2", "Joueur 3", "Nom de l'équipe"});
+
+    for (auto const &team : teams)
+    {
+        exporter.AddRow({team.id, team.number
+                , PlayerName(players, team.player1Id)
+                , PlayerName(players, team.player2Id)
+                , PlayerName(players, team.player3Id)
+                , team.teamName});
+    }
+
+    return exporter.Close();
+}
+
+bool Exporter::ExportGames(const std::string &fileName, const std::deque<Game> &games, const std::deque<Team> &teams)
+{
+    Exporter exporter;
+
+    if (!exporter.Open(fileName, "games"))
+    {
+        return false;
+    }
+
+    exporter.SetHeader({"Id", "Partie", "Équipe 1", "Équipe 2", "Score 1", "Score 2", "Terrain"});
+
+    IdIndex<Team> teamIds;
+    teamIds.Build(teams);
+
+    for (auto const &game : games)
+    {
+        exporter.AddRow({game.id, game.turn + 1
+                , TeamLabel(teamIds.Find(game.team1Id))
+                , TeamLabel(teamIds.Find(game.team2Id))
+                , game.team1Score, game.team2Score, CourtAllocator::GetCourt(game)});
+    }
+
+    return exporter.Close();
+}
+
+bool Exporter::ExportRanking(const std::string &fileName, const std::deque<Rank> &ranking, const std::deque<Team> &teams, const PlayerStore &players, bool isSeason)
+{
+    Exporter exporter;
+
+    if (!exporter.Open(fileName, "ranking"))
+    {
+        return false;
+    }
+
+    if (isSeason)
+    {
+        exporter.SetHeader({"Id", "Rang", "Joueur", "Gagnés", "Nuls", "Perdus", "Points marqués", "Points concédés", "Différence", "Parties jouées"});
+    }
+    else
+    {
+        exporter.SetHeader({"Id", "Rang", "Numéro d'équipe", "Équipe", "Gagnés", "Nuls", "Perdus", "Points marqués", "Points concédés", "Différence", "Buchholz"});
+    }
+
+    IdIndex<Team> teamIds;
+    teamIds.Build(teams);
+
+    int line = 1;
+    for (auto const &rank : ranking)
+    {
+        if (isSeason)
+        {
+            std::uint32_t row = players.IndexOf(rank.id);
+            if (row != PlayerStore::cNotFound)
+            {
+                int nbGames = rank.gamesWon + rank.gamesLost + rank.gamesDraw;
+                exporter.AddRow({rank.id, line, players.FullName(row), rank.gamesWon, rank.gamesDraw, rank.gamesLost, rank.pointsWon, rank.pointsLost, rank.Difference(), nbGames});
+            }
+        }
+        else
+        {
+            const Team *team = teamIds.Find(rank.id);
+            if (team != nullptr)
+            {
+                exporter.AddRow({team->id, line, team->number, team->teamName, rank.gamesWon, rank.gamesDraw, rank.gamesLost, rank.pointsWon, rank.pointsLost, rank.Difference(), rank.pointsOpponents});
+            }
+        }
+        line++;
+    }
+
+    return exporter.Close();
+}
+
+/**
+ * @brief Ratings of the players, the best first
+ */
+bool Exporter::ExportRatings(const std::string &fileName, const std::deque<Rating> &ratings, const PlayerStore &players)
+{
+    Exporter exporter;
+
+    if (!exporter.Open(fileName, "ratings"))
+    {
+        return false;
+    }
+
+    exporter.SetHeader({"Id", "Rang", "Joueur", "Classement Elo", "Parties jouées"});
+
+    int line = 1;
+    for (auto const &rating : ratings)
+    {
+        std::uint32_t row = players.IndexOf(rating.playerId);
+        if (row != PlayerStore::cNotFound)
+        {
+            exporter.AddRow({rating.playerId, line, players.FullName(row), static_cast<int>(rating.value + 0.5), rating.games});
+            line++;
+        }
+    }
+
+    return exporter.Close();
+}
+
+bool Exporter::ExportRewardTotals(const std::string &fileName, const std::deque<RewardTotal> &totals, const std::deque<Team> &teams)
+{
+    Exporter exporter;
+
+    if (!exporter.Open(fileName, "rewards"))
+    {
+        return false;
+    }
+
+    exporter.SetHeader({"Id", "Numéro", "Nom de l'équipe", "Montant", "Récompenses"});
+
+    IdIndex<Team> teamIds;
+    teamIds.Build(teams);
+
+    for (auto const &total : totals)
+    {
+        const Team *team = teamIds.Find(total.id);
+        if (team != nullptr)
+        {
+            exporter.AddRow({team->id, team->number, team->teamName, total.total, total.count});
+        }
+    }
+
+    return exporter.Close();
+}
+
+bool Exporter::ExportRewardTotals(const std::string &fileName, const std::deque<RewardTotal> &totals, const std::deque<Event> &events)
+{
+    Exporter exporter;
+
+    if (!exporter.Open(fileName, "rewards"))
+    {
+        return false;
+    }
+
+    exporter.SetHeader({"Id", "Date", "Titre", "Montant", "Récompenses"});
+
+    // In the order of the events, the ones without any reward are listed too
+    for (auto const &event : events)
+    {
+        int amount = 0;
+        int count = 0;
+        for (auto const &total : totals)
+        {
+            if (total.id == event.id)
+            {
+                amount = total.total;
+                count = total.count;
+            }
+        }
+        exporter.AddRow({event.id, Util::ToISODateTime(event.date), event.title, amount, count});
+    }
+
+    return exporter.Close();
+}
+
+/**
+ * @brief Export all the games of a season, one event after the other
+ *
+ * Only one event is loaded in memory at a time.
+ */
+bool Exporter::ExportSeason(const std::string &fileName, DbManager &db, int year)
+{
+    Exporter exporter;
+
+    if (!exporter.Open(fileName, "games"))
+    {
+        return false;
+    }
+
+    exporter.SetHeader({"Id", "Événement", "Date", "Partie", "Équipe 1", "Équipe 2", "Score 1", "Score 2", "Terrain"});
+
+    std::deque<Event> events = db.GetEvents(year);
+    for (auto const &event : events)
+    {
+        std::deque<Team> teams = db.GetTeams(event.id);
+        std::deque<Game> games = db.GetGamesByEventId(event.id);
+        std::string date = Util::ToISODateTime(event.date);
+
+        IdIndex<Team> teamIds;
+        teamIds.Build(teams);
+
+        for (auto const &game : games)
+        {
+            exporter.AddRow({game.id, event.title, date, game.turn + 1
+                    , TeamLabel(teamIds.Find(game.team1Id))
+                    , TeamLabel(teamIds.Find(game.team2Id))
+                    , game.team1Score, game.team2Score, CourtAllocator::GetCourt(game)});
+        }
+    }
+
+    return exporter.Close();
+}
+
+//=============================================================================
+// End of file Exporter.cpp
+//=============================================================================
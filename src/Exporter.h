@@ -0,0 +1,105 @@
+/*=============================================================================
+ * Tanca - Exporter.h
+ *=============================================================================
+ * Streaming CSV/JSON export of players, teams, games and rankings
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <cstdio>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+
+#include "Value.h"
+#include "IDataBase.h"
+#include "Tournament.h"
+#include "Ratings.h"
+#include "PlayerStore.h"
+
+class DbManager;
+
+/**
+ * @brief Writes rows to a file as they come, through a fixed-size buffer
+ *
+ * The output format is selected by the file extension: ".json" produces an
+ * object holding an array of rows, anything else is a CSV file (';' separator).
+ * The file name "-" writes CSV to the standard output.
+ */
+class Exporter
+{
+public:
+    static const int cCsv = 0;
+    static const int cJson = 1;
+
+    static const std::size_t cBufferSize = 16U * 1024U;
+
+    Exporter();
+    ~Exporter();
+
+    bool Open(const std::string &fileName, const std::string &rootName);
+    void SetHeader(const std::vector<std::string> &titles);
+    void AddRow(const std::list<Value> &row);
+    bool Close();
+
+    int GetFormat() const { return mFormat; }
+
+    static int FormatFromFileName(const std::string &fileName);
+    static std::string NormalizeTitle(const std::string &title);
+    static std::string TeamLabel(const Team *team);
+    static std::string PlayerName(const PlayerStore &players, int playerId);
+
+    // Data driven exports, no widget involved
+    static bool ExportPlayers(const std::string &fileName, const DbManager &db);
+    static bool ExportTeams(const std::string &fileName, const std::deque<Team> &teams, const PlayerStore &players);
+    static bool ExportGames(const std::string &fileName, const std::deque<Game> &games, const std::deque<Team> &teams);
+    static bool ExportRanking(const std::string &fileName, const std::deque<Rank> &ranking, const std::deque<Team> &teams, const PlayerStore &players, bool isSeason);
+    static bool ExportSeason(const std::string &fileName, DbManager &db, int year);
+    static bool ExportRatings(const std::string &fileName, const std::deque<Rating> &ratings, const PlayerStore &players);
+    static bool ExportRewardTotals(const std::string &fileName, const std::deque<RewardTotal> &totals, const std::deque<Team> &teams);
+    static bool ExportRewardTotals(const std::string &fileName, const std::deque<RewardTotal> &totals, const std::deque<Event> &events);
+
+private:
+    std::FILE *mFile;
+    bool mStdout;
+    int mFormat;
+    bool mError;
+    std::uint32_t mRows;
+    std::vector<std::string> mTitles;
+    char mBuffer[cBufferSize];
+    std::size_t mSize;
+
+    void Write(const char *data, std::size_t size);
+    void Write(const std::string &data) { Write(data.data(), data.size()); }
+    void WriteCsvField(const std::string &field);
+    void WriteJsonString(const std::string &str);
+    void Flush();
+};
+
+#endif // EXPORTER_H
+
+//=============================================================================
+// End of file Exporter.h
+//=============================================================================
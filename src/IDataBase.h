@@ -3,10 +3,96 @@
 
 #include <string>
 #include <deque>
+#include <vector>
 #include <chrono>
+#include <cstdint>
+#include <unordered_map>
 
 #include <Util.h>
 
+/**
+ * @brief Hashed index of a list by entity id, returns pointers into the list
+ *
+ * The index refers to the list given to Build(): it must be rebuilt when
+ * elements are erased or inserted anywhere else than at the end.
+ */
+template <typename T>
+class IdIndex
+{
+public:
+    IdIndex()
+        : mList(nullptr)
+    {
+
+    }
+
+    void Build(const std::deque<T> &list)
+    {
+        mList = &list;
+        mIndex.clear();
+        mIndex.reserve(list.size());
+        for (std::uint32_t i = 0; i < list.size(); i++)
+        {
+            mIndex[list[i].id] = i;
+        }
+    }
+
+    // The element has been appended to the list
+    void Add(int id, std::uint32_t index)
+    {
+        mIndex[id] = index;
+    }
+
+    int IndexOf(int id) const
+    {
+        auto it = mIndex.find(id);
+        return (it == mIndex.end()) ? -1 : static_cast<int>(it->second);
+    }
+
+    const T *Find(int id) const
+    {
+        auto it = mIndex.find(id);
+        return (it == mIndex.end()) ? nullptr : &(*mList)[it->second];
+    }
+
+private:
+    const std::deque<T> *mList;
+    std::unordered_map<int, std::uint32_t> mIndex;
+};
+
+/**
+ * @brief Linear search without copy, for lists too small to be indexed
+ */
+template <typename T>
+const T *FindById(const std::deque<T> &list, const int id)
+{
+    for (auto const &i : list)
+    {
+        if (i.id == id)
+        {
+            return &i;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Non-owning selection of the elements of an event
+ */
+template <typename T>
+std::vector<const T *> SelectByEventId(const std::deque<T> &list, const int eventId)
+{
+    std::vector<const T *> view;
+    for (auto const &i : list)
+    {
+        if (i.eventId == eventId)
+        {
+            view.push_back(&i);
+        }
+    }
+    return view;
+}
+
 struct Player
 {
     static const int cDummyPlayer = 999999999;
@@ -53,11 +139,34 @@ struct Player
         document = "";
     }
 
-    std::string FullName()
+    std::string FullName() const
     {
         return name + " " + lastName;
     }
 
+    // Stands for the missing players of the teams
+    static const Player &Dummy()
+    {
+        static const Player dummy;
+        return dummy;
+    }
+
+    // Name of a player found (or not) by pointer
+    static std::string FullName(const Player *player)
+    {
+        return (player != nullptr) ? player->FullName() : Dummy().FullName();
+    }
+
+    static const Player *Find(const std::deque<Player> &players, const int id)
+    {
+        return (id == Player::cDummyPlayer) ? &Dummy() : FindById(players, id);
+    }
+
+    static const Player *Find(const IdIndex<Player> &players, const int id)
+    {
+        return (id == Player::cDummyPlayer) ? &Dummy() : players.Find(id);
+    }
+
     static bool Find(const std::deque<Player> &players, const int id, Player &player)
     {
         bool found = false;
@@ -122,10 +231,13 @@ struct Event
     static const int cRoundRobin   = 0;
     // type 1 was used in the past
     static const int cSwissRounds   = 2;
+    static const int cSingleElimination = 3;
+    static const int cDoubleElimination = 4;
 
     // Option, maybe manage it with a bitmask so that is can be used in many ways
     static const int cNoOption   = 0;
     static const int cOptionSeasonRanking = 1; // if set, count this event for the season ranking
+    static const int cOptionSeededFirstRound = 2; // Swiss: first round by the ratings of the players
 
     Event()
         : id(-1)
@@ -142,6 +254,11 @@ struct Event
         return (option & opt) != 0;
     }
 
+    bool IsKnockout() const
+    {
+        return (type == cSingleElimination) || (type == cDoubleElimination);
+    }
+
     bool IsValid()
     {
         return (id != -1);
@@ -190,6 +307,11 @@ struct Team
      * @param team
      * @return
      */
+    static const Team *Find(const std::deque<Team> &teams, const int id)
+    {
+        return FindById(teams, id);
+    }
+
     static bool Find(const std::deque<Team> &teams, const int id, Team &team)
     {
         bool found = false;
@@ -206,18 +328,9 @@ struct Team
         return found;
     }
 
-    static std::deque<Team> FindByEventId(const std::deque<Team> &teams, const int eventId)
+    static std::vector<const Team *> FindByEventId(const std::deque<Team> &teams, const int eventId)
     {
-        std::deque<Team> t;
-        for (auto const &i : teams)
-        {
-            if (i.eventId == eventId)
-            {
-                t.push_back(i);
-            }
-        }
-
-        return t;
+        return SelectByEventId(teams, eventId);
     }
 
     /**
@@ -253,6 +366,7 @@ struct Reward
     static const int cStateNoReward = -1;
     static const int cStateRewardOk = 0;
     static const int cStateRewardCanceled = 1;
+    static const int cStateRewardRanking = 2; // Paid out from the final ranking, replaced if distributed again
 
     int id;
     int eventId;
@@ -274,6 +388,16 @@ struct Reward
 
 };
 
+/**
+ * @brief Sum of the rewards of a team or of an event
+ */
+struct RewardTotal
+{
+    int id;     // team or event id
+    int total;
+    int count;  // number of rewards
+};
+
 struct Game
 {
     int id;
@@ -311,6 +435,11 @@ struct Game
      * @param team
      * @return
      */
+    static const Game *Find(const std::deque<Game> &games, const int id)
+    {
+        return FindById(games, id);
+    }
+
     static bool Find(const std::deque<Game> &games, const int id, Game &game)
     {
         bool found = false;
@@ -327,18 +456,9 @@ struct Game
         return found;
     }
 
-    static std::deque<Game> FindByEventId(const std::deque<Game> &games, const int eventId)
+    static std::vector<const Game *> FindByEventId(const std::deque<Game> &games, const int eventId)
     {
-        std::deque<Game> g;
-        for (auto const &i : games)
-        {
-            if (i.eventId == eventId)
-            {
-                g.push_back(i);
-            }
-        }
-
-        return g;
+        return SelectByEventId(games, eventId);
     }
 
 
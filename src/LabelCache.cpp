@@ -0,0 +1,117 @@
+/*=============================================================================
+ * Tanca - LabelCache.cpp
+ *=============================================================================
+ * Display names of the players and teams, built once per change
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include "LabelCache.h"
+
+// "First Las."
+static std::string ShortName(const std::string &name, const std::string &lastName)
+{
+    return name + " " + lastName.substr(0, 3) + ".";
+}
+
+/*****************************************************************************/
+void LabelCache::Clear()
+{
+    mPlayerNames.clear();
+    mTeamNames.clear();
+    mTeamLabels.clear();
+}
+/*****************************************************************************/
+void LabelCache::InvalidatePlayers()
+{
+    // The labels hold the team names: a default name rebuilt is seen by the check of TeamLabel()
+    mPlayerNames.clear();
+    mTeamNames.clear();
+}
+/*****************************************************************************/
+void LabelCache::InvalidateTeam(int teamId)
+{
+    mTeamNames.erase(teamId);
+    mTeamLabels.erase(teamId);
+}
+/*****************************************************************************/
+const std::string &LabelCache::PlayerName(const PlayerStore &players, int playerId)
+{
+    static const std::string cDummyName = Player::Dummy().FullName();
+
+    auto it = mPlayerNames.find(playerId);
+    if (it == mPlayerNames.end())
+    {
+        std::uint32_t row = players.IndexOf(playerId);
+        if (row == PlayerStore::cNotFound)
+        {
+            return cDummyName;
+        }
+        it = mPlayerNames.emplace(playerId, players.FullName(row)).first;
+    }
+    return it->second;
+}
+/*****************************************************************************/
+const std::string &LabelCache::TeamName(const PlayerStore &players, const Team &team)
+{
+    auto it = mTeamNames.find(team.id);
+    if ((it == mTeamNames.end()) || (it->second.player1Id != team.player1Id) || (it->second.player2Id != team.player2Id))
+    {
+        std::uint32_t row1 = players.IndexOf(team.player1Id);
+        std::uint32_t row2 = players.IndexOf(team.player2Id);
+
+        TeamEntry &entry = mTeamNames[team.id];
+        entry.player1Id = team.player1Id;
+        entry.player2Id = team.player2Id;
+        entry.name = ShortName(players.GetName(row1), players.GetLastName(row1)) + " / " +
+                     ShortName(players.GetName(row2), players.GetLastName(row2));
+        return entry.name;
+    }
+    return it->second.name;
+}
+/*****************************************************************************/
+const std::string &LabelCache::TeamLabel(const Team *team)
+{
+    static const Team cNoTeam;
+    if (team == nullptr)
+    {
+        team = &cNoTeam;
+    }
+
+    auto it = mTeamLabels.find(team->id);
+    if ((it == mTeamLabels.end()) || (it->second.number != team->number) || (it->second.name != team->teamName))
+    {
+        LabelEntry &entry = mTeamLabels[team->id];
+        entry.number = team->number;
+        entry.name = team->teamName;
+        entry.label = "(" + std::to_string(team->number) + ") " + team->teamName;
+        return entry.label;
+    }
+    return it->second.label;
+}
+/*****************************************************************************/
+std::string LabelCache::DefaultTeamName(const Player &p1, const Player &p2)
+{
+    return ShortName(p1.name, p1.lastName) + " / " + ShortName(p2.name, p2.lastName);
+}
+
+//=============================================================================
+// End of file LabelCache.cpp
+//=============================================================================
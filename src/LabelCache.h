@@ -0,0 +1,88 @@
+/*=============================================================================
+ * Tanca - LabelCache.h
+ *=============================================================================
+ * Display names of the players and teams, built once per change
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef LABEL_CACHE_H
+#define LABEL_CACHE_H
+
+#include <string>
+#include <unordered_map>
+
+#include "IDataBase.h"
+#include "PlayerStore.h"
+
+/**
+ * @brief Names shown in the tables, kept between two refreshes
+ *
+ * Each label is built the first time it is asked, then the same string is
+ * returned until the player list or the team changes. A team label also
+ * remembers the number and name it was made of, so a stale entry is rebuilt
+ * instead of being shown.
+ *
+ * The references stay valid until the next invalidation. Not thread safe:
+ * used by the database manager from the user interface thread.
+ */
+class LabelCache
+{
+public:
+    void Clear();
+    // Player edited, added or deleted: player names and default team names
+    void InvalidatePlayers();
+    // Team edited or deleted
+    void InvalidateTeam(int teamId);
+
+    // "First Last", the dummy player name if not found
+    const std::string &PlayerName(const PlayerStore &players, int playerId);
+    // Default name of a team without one: "First Las. / First Las.", both players must exist
+    const std::string &TeamName(const PlayerStore &players, const Team &team);
+    // "(number) name", the default team if not found
+    const std::string &TeamLabel(const Team *team);
+
+    static std::string DefaultTeamName(const Player &p1, const Player &p2);
+
+private:
+    struct TeamEntry
+    {
+        int player1Id;
+        int player2Id;
+        std::string name;
+    };
+
+    struct LabelEntry
+    {
+        int number;
+        std::string name;
+        std::string label;
+    };
+
+    std::unordered_map<int, std::string> mPlayerNames; // player id -> full name
+    std::unordered_map<int, TeamEntry> mTeamNames;      // team id -> default name
+    std::unordered_map<int, LabelEntry> mTeamLabels;    // team id -> label
+};
+
+#endif // LABEL_CACHE_H
+
+//=============================================================================
+// End of file LabelCache.h
+//=============================================================================
@@ -23,16 +23,27 @@
  *=============================================================================
  */
 
+#include <algorithm>
+#include <climits>
+
 #include <QStandardPaths>
-#include <iostream>
 #include <QMessageBox>
+#include <QInputDialog>
 #include <QFileDialog>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
 
 #include "Value.h"
 #include "Log.h"
+#include "AsyncLog.h"
+#include "Profiler.h"
+#include "RoundRobin.h"
+#include "CourtAllocator.h"
 #include "Util.h"
 #include "MainWindow.h"
 #include "TableHelper.h"
+#include "Exporter.h"
 #include "ui_MainWindow.h"
 #include "ui_RewardWindow.h"
 
@@ -44,6 +55,7 @@ static QStringList gEventsTableHeader;
 static QStringList gPlayersTableHeader;
 static QStringList gTeamsTableHeader;
 static QStringList gRewardsTableHeader;
+static QStringList gTracesTableHeader;
 
 #ifdef USE_WINDOWS_OS
 static QString gAppDataPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/tanca";
@@ -58,11 +70,30 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , mDatabase(gDbFullPath)
-    , mCurrentRankingRound(1)
+    , mWorkspace(mDatabase)
+    , mSession(nullptr)
+    , mRankingDirty(true)
+    , mPlayersDirty(true)
+    , mEventsLoaded(false)
+    , mPlayersView(Change::cPlayers, [this](const Change &) {
+        // Default team names of the other events, reloaded when they are opened again
+        mWorkspace.InvalidateTeams();
+        InvalidatePlayers();
+    })
+    , mTeamsView(Change::cTeams, [this](const Change &) { UpdateTeamList(); })
+    , mGamesView(Change::cTeams, [this](const Change &) { ShowGameList(); })
+    , mRankingView(Change::cGames | Change::cTeams | Change::cPlayers, [this](const Change &) { InvalidateRanking(); })
+    , mRewardsView(Change::cRewards, [this](const Change &) { UpdateRewards(); })
+    , mEventsView(Change::cEvents, [this](const Change &) {
+        if (mEventsLoaded)
+        {
+            UpdateSeasons();
+        }
+    })
 {
     Log::SetLogPath(gAppDataPath.toStdString());
 
-    std::cout << "Application path set to: " << gAppDataPath.toStdString() << std::endl;
+    ALogInfo("Application path set to: " << gAppDataPath.toStdString());
 
     // Setup UI
     ui->setupUi(this);
@@ -89,6 +120,8 @@ MainWindow::MainWindow(QWidget *parent)
 
     // Setup signals for the menu
     connect(ui->actionImporter, &QAction::triggered, this, &MainWindow::slotImportPlayerFile);
+    connect(ui->actionExportSeason, &QAction::triggered, this, &MainWindow::slotExportSeason);
+    connect(ui->actionCloseSeason, &QAction::triggered, this, &MainWindow::slotCloseSeason);
     connect(ui->actionQuitter, &QAction::triggered, this, &QCoreApplication::quit);
     connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::slotAboutBox);
 
@@ -111,6 +144,7 @@ MainWindow::MainWindow(QWidget *parent)
 
     connect(ui->btnAddReward, &QPushButton::clicked, this, &MainWindow::slotAddReward);
     connect(ui->btnDeleteReward, &QPushButton::clicked, this, &MainWindow::slotDeleteReward);
+    connect(ui->btnRankingRewards, &QPushButton::clicked, this, &MainWindow::slotRankingRewards);
 
     connect(ui->eventTable, SIGNAL(itemSelectionChanged()), this, SLOT(slotEventItemActivated()));
     connect(ui->teamTable, SIGNAL(itemSelectionChanged()), this, SLOT(slotTeamItemActivated()));
@@ -119,10 +153,12 @@ MainWindow::MainWindow(QWidget *parent)
 
     connect(ui->buttonAddGame, &QPushButton::clicked, this, &MainWindow::slotAddGame);
     connect(ui->buttonEditGame, &QPushButton::clicked, this, &MainWindow::slotEditGame);
+    connect(ui->buttonUndoScore, &QPushButton::clicked, this, &MainWindow::slotUndoScore);
     connect(ui->buttonDeleteGame, &QPushButton::clicked, this, &MainWindow::slotDeleteGame);
     connect(ui->buttonDeleteAllGames, &QPushButton::clicked, this, &MainWindow::slotDeleteAllGames);
     connect(ui->buttonExportGames, &QPushButton::clicked, this, &MainWindow::slotExportGames);
 
+    connect(ui->tabWidget, SIGNAL(currentChanged(int)), this, SLOT(slotMainTabChanged(int)));
     connect(ui->tabWidget_2, SIGNAL(currentChanged(int)), this, SLOT(slotTabChanged(int)));
     connect(ui->radioEvent, &QRadioButton::toggled, this, &MainWindow::slotRankingOptionChanged);
     connect(ui->radioSeason, &QRadioButton::toggled, this, &MainWindow::slotRankingOptionChanged);
@@ -131,13 +167,23 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->btnRankingRight,&QPushButton::clicked, this,  &MainWindow::slotRankingRight);
     connect(ui->buttonExportRanking, &QPushButton::clicked, this, &MainWindow::slotExportRanking);
 
+    // Subscribe the views to the data they render, in the refresh order
+    mBus.Attach(mPlayersView);
+    mBus.Attach(mTeamsView);
+    mBus.Attach(mGamesView);
+    mBus.Attach(mRankingView);
+    mBus.Attach(mRewardsView);
+    mBus.Attach(mEventsView);
+    mBus.Attach(mServer);
+    mServer.SetGamesProvider([this]() { return GamesToJson(); });
+
     // Setup other stuff
-    mDatabase.Initialize();
-    gGamesTableHeader << tr("Id") << tr("Partie") << tr("Équipe 1") << tr("Équipe 2") << tr("Score 1") << tr("Score 2");
+    gGamesTableHeader << tr("Id") << tr("Partie") << tr("Équipe 1") << tr("Équipe 2") << tr("Score 1") << tr("Score 2") << tr("Terrain");
     gEventsTableHeader << tr("Id") << tr("Date") << tr("Type") << tr("Titre") << tr("État");
     gPlayersTableHeader << tr("Id") << tr("UUID") << tr("Prénom") << tr("Nom") << tr("Pseudonyme") << tr("E-mail") << tr("Téléphone (mobile)") << tr("Téléphone (maison)") << tr("Date de naissance") << tr("Rue") << tr("Code postal") << tr("Ville") << tr("Licences") << tr("Commentaires") << tr("Statut") << tr("Divers");
     gTeamsTableHeader << tr("Id") << tr("Numéro") << tr("Joueur 1") << tr("Joueur 2") << tr("Joueur 3") << ("Nom de l'équipe");
     gRewardsTableHeader << tr("Id") << tr("Montant") << tr("Commentaire");
+    gTracesTableHeader << tr("Id") << tr("Étape") << tr("Nombre") << tr("Médiane (ms)") << tr("90 % (ms)") << tr("99 % (ms)") << tr("Max (ms)");
 }
 
 MainWindow::~MainWindow()
@@ -146,78 +192,184 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
+/**
+ * @brief Open the database and fill the visible tab, called once the window is shown
+ *
+ * The other tabs are filled when they are displayed for the first time.
+ */
 void MainWindow::Initialize()
 {
+    TRACE_SCOPE("ui.Initialize");
+    mDatabase.Initialize();
     mServer.Initialize();
 
-    // Initialize views
-    UpdatePlayersTable();
-    UpdateSeasons();
+    slotMainTabChanged(ui->tabWidget->currentIndex());
 }
 
-void MainWindow::ExportTable(QTableWidget *table, const QString &title)
+QString MainWindow::GetExportFileName(const QString &title)
 {
-    QString fileName = QFileDialog::getSaveFileName(this, title,
+    return QFileDialog::getSaveFileName(this, title,
                                  QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
                                  tr("Excel CSV (*.csv);;JSON (*.json)"));
+}
+
+void MainWindow::slotExportSeason()
+{
+    QString fileName = GetExportFileName(tr("Exporter toutes les parties de la saison"));
     if (!fileName.isEmpty())
     {
-        TableHelper helper(table);
-        helper.Export(fileName);
+        int year = ui->comboSeasons->currentText().toInt();
+        if (!Exporter::ExportSeason(fileName.toStdString(), mDatabase, year))
+        {
+            TLogError("Season export failure");
+        }
+    }
+}
+
+/**
+ * @brief Archive the selected season, it can no more be modified
+ */
+void MainWindow::slotCloseSeason()
+{
+    int year = ui->comboSeasons->currentText().toInt();
+
+    if (mDatabase.GetArchive(year) != nullptr)
+    {
+        return;
+    }
+
+    if (QMessageBox::warning(this, tr("Clôture de la saison"),
+                             tr("La saison %1 sera archivée et ne pourra plus être modifiée. Continuer ?").arg(year),
+                             QMessageBox::Ok | QMessageBox::Cancel) == QMessageBox::Ok)
+    {
+        mWorkspace.Clear();
+        mSession = nullptr;
+
+        if (!mDatabase.CloseSeason(year))
+        {
+            (void) QMessageBox::warning(this, tr("Tanca"),
+                                        tr("Impossible d'archiver la saison"),
+                                        QMessageBox::Ok);
+        }
+        UpdateSeasons();
+    }
+}
+
+void MainWindow::slotMainTabChanged(int index)
+{
+    Q_UNUSED(index);
+    if ((ui->tabWidget->currentWidget() == ui->tab) && mPlayersDirty)
+    {
+        UpdatePlayersTable();
+    }
+    else if ((ui->tabWidget->currentWidget() == ui->tab_2) && !mEventsLoaded)
+    {
+        UpdateSeasons();
     }
 }
 
 void MainWindow::slotTabChanged(int index)
 {
     Q_UNUSED(index);
-    // Refresh ranking
-    UpdateRanking();
+    // Refresh ranking only if something has changed since the last display
+    if ((ui->tabWidget_2->currentWidget() == ui->tab_6) && mRankingDirty)
+    {
+        UpdateRanking();
+    }
 }
 
 void MainWindow::slotAboutBox()
 {
     QDialog about;
     uiAboutBox.setupUi(&about);
+
+    uiAboutBox.checkProfiler->setChecked(Profiler::IsEnabled());
+    UpdateTraces();
+
+    connect(uiAboutBox.checkProfiler, &QCheckBox::toggled, [](bool checked) {
+        Profiler::SetEnabled(checked);
+    });
+    connect(uiAboutBox.buttonClearTraces, &QPushButton::clicked, [this]() {
+        Profiler::Clear();
+        UpdateTraces();
+    });
+    connect(uiAboutBox.buttonExportTraces, &QPushButton::clicked, [this]() {
+        QString fileName = QFileDialog::getSaveFileName(this, tr("Exporter la trace"),
+                                     QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation),
+                                     tr("Chrome trace (*.json)"));
+        if (!fileName.isEmpty() && !Profiler::ExportChromeTrace(fileName.toStdString()))
+        {
+            TLogError("Trace export failure");
+        }
+    });
+
     about.exec();
 }
 
+/**
+ * @brief Per-stage durations of the session, in milliseconds
+ */
+void MainWindow::UpdateTraces()
+{
+    TableHelper helper(uiAboutBox.tableTraces);
+    std::vector<Profiler::Stats> stats = Profiler::GetStats();
+    auto ms = [](std::uint64_t us) { return QString::number(us / 1000.0, 'f', 3).toStdString(); };
+
+    helper.Initialize(gTracesTableHeader, stats.size());
+    int id = 0;
+    for (auto const &s : stats)
+    {
+        helper.AppendLine({id, s.stage, static_cast<int>(s.count), ms(s.p50), ms(s.p90), ms(s.p99), ms(s.max)}, false);
+        id++;
+    }
+    helper.Finish();
+}
+
 // ===========================================================================================
 // PLAYERS MANAGEMENT
 // ===========================================================================================
 void MainWindow::slotFilterPlayer()
 {
     QString filter = ui->lineEditPlayerFilter->text();
+    bool showAll = filter.isEmpty();
+    const std::unordered_set<int> &matches = mDatabase.GetPlayerIndex().Find(filter.toStdString());
+
     for( int i = 0; i < ui->playersWidget->rowCount(); ++i )
     {
-        bool match = false;
-        for( int j = 0; j < ui->playersWidget->columnCount(); ++j )
+        bool match = showAll;
+        if (!match)
         {
-            QTableWidgetItem *item = ui->playersWidget->item( i, j );
-            if( item->text().contains(filter, Qt::CaseInsensitive) )
-            {
-                match = true;
-                break;
-            }
+            QTableWidgetItem *item = ui->playersWidget->item( i, 0 );
+            match = (matches.count(item->text().toInt()) > 0);
         }
         ui->playersWidget->setRowHidden( i, !match );
     }
 }
 
 
+void MainWindow::InvalidatePlayers()
+{
+    mPlayersDirty = true;
+    if (ui->tabWidget->currentWidget() == ui->tab)
+    {
+        UpdatePlayersTable();
+    }
+}
+
 void MainWindow::UpdatePlayersTable()
 {
+    TRACE_SCOPE("ui.UpdatePlayersTable");
+    mPlayersDirty = false;
     TableHelper helper(ui->playersWidget);
-    std::deque<Player> &list = mDatabase.GetPlayerList();
-    helper.Initialize(gPlayersTableHeader, list.size());
+    helper.Initialize(gPlayersTableHeader, static_cast<int>(mDatabase.GetPlayers().Size()));
 
-    foreach (Player p, list)
-    {
+    mDatabase.VisitPlayers([&helper](const Player &p) {
         std::list<Value> rowData = {p.id, p.uuid, p.name, p.lastName, p.nickName, p.email
                , p.mobilePhone, p.homePhone, Util::ToISODateTime(p.birthDate), p.road, p.postCode
                , p.city, p.membership, p.comments, p.state, p.document};
 
         helper.AppendLine(rowData, false);
-    }
+    });
 
     ui->playersWidget->hideColumn(1); // don't show the UUID
     ui->playersWidget->hideColumn(14); // don't show the State
@@ -230,36 +382,64 @@ void MainWindow::slotAddPlayer()
 {
     if (playerWindow->AddPlayer(mDatabase))
     {
-        UpdatePlayersTable();
+        mBus.Post(Change::cPlayers);
     }
 }
 
 void MainWindow::slotEditPlayer()
 {
+    std::uint8_t changed = SelectedPlayerChange();
     if (playerWindow->EditPlayer(mDatabase, ui->playersWidget))
     {
-        UpdatePlayersTable();
+        mBus.Post(changed);
     }
 }
 
 void MainWindow::slotDeletePlayer()
 {
+    std::uint8_t changed = SelectedPlayerChange();
     if (playerWindow->DeletePlayer(mDatabase, ui->playersWidget))
     {
-        UpdatePlayersTable();
+        mBus.Post(changed);
+    }
+}
+
+/**
+ * @brief Entities to refresh when the selected player is edited or deleted
+ *
+ * The team and game lists only show the names of the players of the current
+ * event: they are rebuilt only if the player is in one of its teams.
+ */
+std::uint8_t MainWindow::SelectedPlayerChange()
+{
+    std::uint8_t changed = Change::cPlayers;
+    TableHelper helper(ui->playersWidget);
+    int id;
+    if (helper.GetFirstColumnValue(id) &&
+        (std::find(mPlayersInTeams.begin(), mPlayersInTeams.end(), id) != mPlayersInTeams.end()))
+    {
+        changed |= Change::cTeams;
     }
+    return changed;
 }
 
 void MainWindow::slotExportPlayers()
 {
-    ExportTable(ui->playersWidget, tr("Exporter la base de joueurs au format Excel (CSV)"));
+    QString fileName = GetExportFileName(tr("Exporter la base de joueurs au format Excel (CSV)"));
+    if (!fileName.isEmpty())
+    {
+        if (!Exporter::ExportPlayers(fileName.toStdString(), mDatabase))
+        {
+            TLogError("Players export failure");
+        }
+    }
 }
 
 void MainWindow::slotImportPlayerFile()
 {
     if (playerWindow->ImportPlayerFile(mDatabase))
     {
-        UpdatePlayersTable();
+        mBus.Post(Change::cPlayers);
     }
 }
 
@@ -268,39 +448,53 @@ void MainWindow::slotImportPlayerFile()
 // ===========================================================================================
 void MainWindow::slotExportTeams()
 {
-     ExportTable(ui->teamTable, tr("Exporter la liste des équipes au format Excel (CSV)"));
+    QString fileName = GetExportFileName(tr("Exporter la liste des équipes au format Excel (CSV)"));
+    if (!fileName.isEmpty() && (mSession != nullptr))
+    {
+        if (!Exporter::ExportTeams(fileName.toStdString(), mSession->teams, mDatabase.GetPlayers()))
+        {
+            TLogError("Teams export failure");
+        }
+    }
 }
 
 void MainWindow::UpdateTeamList()
 {
-    mTeams = mDatabase.GetTeams(mCurrentEvent.id);
+    if (mSession != nullptr)
+    {
+        mWorkspace.ReloadTeams(*mSession);
+    }
+    ShowTeamList();
+}
+
+/**
+ * @brief Display the teams of the selected event, as loaded in its session
+ */
+void MainWindow::ShowTeamList()
+{
+    TRACE_SCOPE("ui.ShowTeamList");
+    static const std::deque<Team> cNoTeams;
+    const std::deque<Team> &teams = (mSession != nullptr) ? mSession->teams : cNoTeams;
+
     mPlayersInTeams.clear();
 
     TableHelper helper(ui->teamTable);
-    helper.Initialize(gTeamsTableHeader, mTeams.size());
+    helper.Initialize(gTeamsTableHeader, teams.size());
     teamWindow->ClearIds();
 
-    foreach (Team team, mTeams)
+    for (auto const &team : teams)
     {
-        Player p1, p2, p3;
-        if (mDatabase.FindPlayer(team.player1Id, p1))
-        {
-            mPlayersInTeams.push_back(team.player1Id);
-        }
-
-        if (mDatabase.FindPlayer(team.player2Id, p2))
-        {
-            mPlayersInTeams.push_back(team.player2Id);
-        }
-
-        if (mDatabase.FindPlayer(team.player3Id, p3))
+        for (int id : { team.player1Id, team.player2Id, team.player3Id })
         {
-            mPlayersInTeams.push_back(team.player3Id);
+            if (mDatabase.GetPlayers().Contains(id))
+            {
+                mPlayersInTeams.push_back(id);
+            }
         }
 
         teamWindow->AddId(team.number);
 
-        std::list<Value> rowData = {team.id, team.number, p1.FullName(), p2.FullName(), p3.FullName(), team.teamName};
+        std::list<Value> rowData = {team.id, team.number, mDatabase.GetPlayerName(team.player1Id), mDatabase.GetPlayerName(team.player2Id), mDatabase.GetPlayerName(team.player3Id), team.teamName};
         helper.AppendLine(rowData, false);
     }
 
@@ -312,20 +506,20 @@ void MainWindow::UpdateTeamList()
 void MainWindow::slotAddTeam()
 {
     int selection = ui->eventTable->currentRow();
-    if (selection > -1)
+    if ((selection > -1) && (mSession != nullptr))
     {
         // Prepare widget contents
-        teamWindow->Initialize(mDatabase.GetPlayerList(), mPlayersInTeams, false);
+        teamWindow->Initialize(mDatabase.GetPlayers(), mPlayersInTeams, false);
 
         if (teamWindow->exec() == QDialog::Accepted)
         {
             Team team;
             teamWindow->GetTeam(team);
-            team.eventId = mCurrentEvent.id;
+            team.eventId = mSession->event.id;
             team.number = teamWindow->GetNumber();
             if (mDatabase.AddTeam(team))
             {
-                UpdateTeamList();
+                mBus.Post(Change::cTeams);
             }
         }
     }
@@ -338,17 +532,14 @@ void MainWindow::slotEditTeam()
     int id;
     if (helper.GetFirstColumnValue(id))
     {
-        Team team;
-        if (Team::Find(mTeams, id, team))
+        const Team *found = FindTeam(id);
+        if (found != nullptr)
         {
+            Team team = *found; // edited copy
             // Prepare widget contents
-            teamWindow->Initialize(mDatabase.GetPlayerList(), mPlayersInTeams, true);
+            teamWindow->Initialize(mDatabase.GetPlayers(), mPlayersInTeams, true);
 
-            Player p1, p2;
-            (void) mDatabase.FindPlayer(team.player1Id, p1);
-            (void) mDatabase.FindPlayer(team.player2Id, p2);
-
-            teamWindow->SetTeam(p1, p2, team);
+            teamWindow->SetTeam(team);
 
             if (teamWindow->exec() == QDialog::Accepted)
             {
@@ -356,8 +547,7 @@ void MainWindow::slotEditTeam()
                 team.number = teamWindow->GetNumber();
                 if (mDatabase.EditTeam(team))
                 {
-                    UpdateTeamList();
-                    UpdateGameList();
+                    mBus.Post(Change::cTeams);
                 }
             }
         }
@@ -366,7 +556,7 @@ void MainWindow::slotEditTeam()
 
 void MainWindow::slotDeleteTeam()
 {
-    if (mGames.size() == 0)
+    if ((mSession == nullptr) || (mSession->games.size() == 0))
     {
         TableHelper helper(ui->teamTable);
 
@@ -375,7 +565,7 @@ void MainWindow::slotDeleteTeam()
         {
             if (mDatabase.DeleteTeam(id))
             {
-                UpdateTeamList();
+                mBus.Post(Change::cTeams);
             }
         }
     }
@@ -390,7 +580,7 @@ void MainWindow::slotDeleteTeam()
 void MainWindow::slotTeamItemActivated()
 {
     int row = ui->teamTable->currentRow();
-    if (row > -1)
+    if ((row > -1) && (mSession != nullptr))
     {
         int id;
         TableHelper helper(ui->teamTable);
@@ -400,13 +590,15 @@ void MainWindow::slotTeamItemActivated()
             mSelectedTeam = id;
         }
 
-        mTournament.GenerateTeamRanking(mGames, mTeams, 99);
+        // All the rounds, the cached ranking of the session may stop before
+        Tournament tournament;
+        tournament.GenerateTeamRanking(mSession->games, mSession->teams, INT_MAX);
 
-        Rank rank;
-        if (mTournament.GetTeamRank(mSelectedTeam, rank))
+        const Rank *rank = tournament.GetTeamRank(mSelectedTeam);
+        if (rank != nullptr)
         {
-            ui->lblPlayedGames->setText(QString("%1").arg(rank.gamesLost + rank.gamesWon + rank.gamesDraw));
-            ui->lblWonGames->setText(QString("%1").arg(rank.gamesWon));
+            ui->lblPlayedGames->setText(QString("%1").arg(rank->gamesLost + rank->gamesWon + rank->gamesDraw));
+            ui->lblWonGames->setText(QString("%1").arg(rank->gamesWon));
         }
 
         UpdateRewards();
@@ -431,6 +623,19 @@ void MainWindow::UpdateRewards()
     }
 
     helper.Finish();
+
+    // What the event pays out, all teams
+    int total = 0;
+    int count = 0;
+    if (mSession != nullptr)
+    {
+        for (auto const &t : mDatabase.GetRewardTotals(mSession->event.id))
+        {
+            total += t.total;
+            count += t.count;
+        }
+    }
+    ui->lblEventRewards->setText(tr("Total du concours : %1 (%2 récompenses)").arg(total).arg(count));
 }
 
 void MainWindow::slotAddReward()
@@ -439,11 +644,11 @@ void MainWindow::slotAddReward()
     Ui::RewardWindow ui;
     ui.setupUi(&dialog);
 
-    if (dialog.exec() == QDialog::Accepted)
+    if ((dialog.exec() == QDialog::Accepted) && (mSession != nullptr))
     {
         Reward reward;
 
-        reward.eventId = mCurrentEvent.id;
+        reward.eventId = mSession->event.id;
         reward.teamId = mSelectedTeam;
         reward.total = ui.spinReward->value();
         reward.state = Reward::cStateRewardOk;
@@ -451,7 +656,7 @@ void MainWindow::slotAddReward()
 
         if (mDatabase.AddReward(reward))
         {
-            UpdateRewards();
+            mBus.Post(Change::cRewards);
         }
         else
         {
@@ -469,8 +674,60 @@ void MainWindow::slotDeleteReward()
     {
         if (mDatabase.DeleteReward(id))
         {
-            UpdateRewards();
+            mBus.Post(Change::cRewards);
+        }
+    }
+}
+
+/**
+ * @brief Pay out the whole event from its final ranking
+ *
+ * The amounts are given place after place, a new distribution replaces the
+ * previous one.
+ */
+void MainWindow::slotRankingRewards()
+{
+    if (mSession == nullptr)
+    {
+        return;
+    }
+
+    bool ok = false;
+    QString text = QInputDialog::getText(this, tr("Primes du classement"),
+                                         tr("Montants par place, séparés par des virgules (1er, 2e, ...) :"),
+                                         QLineEdit::Normal, QString(), &ok);
+    if (!ok)
+    {
+        return;
+    }
+
+    std::vector<int> amounts;
+    for (auto const &field : text.split(',', QString::SkipEmptyParts))
+    {
+        int amount = field.trimmed().toInt(&ok);
+        if (!ok || (amount < 0))
+        {
+            (void) QMessageBox::warning(this, tr("Tanca"),
+                                        tr("Montant invalide : %1").arg(field.trimmed()),
+                                        QMessageBox::Ok);
+            return;
         }
+        amounts.push_back(amount);
+    }
+
+    // All the rounds, the cached ranking of the session may stop before
+    Tournament tournament;
+    tournament.GenerateTeamRanking(mSession->games, mSession->teams, INT_MAX);
+
+    if (mDatabase.AssignRankingRewards(mSession->event.id, tournament.GetRanking(), amounts))
+    {
+        mBus.Post(Change::cRewards);
+    }
+    else
+    {
+        (void) QMessageBox::warning(this, tr("Tanca"),
+                                    tr("Impossible d'enregistrer les primes"),
+                                    QMessageBox::Ok);
     }
 }
 
@@ -479,10 +736,24 @@ void MainWindow::slotDeleteReward()
 // ===========================================================================================
 void MainWindow::UpdateRanking()
 {
+    TRACE_SCOPE("ui.UpdateRanking");
+    static const std::deque<Team> cNoTeams;
+    static const std::deque<Rank> cNoRanking;
     bool isSeason = ui->radioSeason->isChecked(); // Display option
     TableHelper helper(ui->tableContest);
 
-    if (isSeason)
+    const SeasonArchive *archive = mDatabase.GetArchive(ui->comboSeasons->currentText().toInt());
+
+    if (isSeason && (archive != nullptr))
+    {
+        // Closed season: ranked on the columns of the archive
+        ui->lblRankingRound->setEnabled(false);
+        EventSnapshot snapshot;
+        archive->GetSnapshot(snapshot);
+        mSeasonTournament.GeneratePlayerRanking(snapshot, mEvents);
+        helper.Show(mDatabase.GetPlayers(), cNoTeams, true, mSeasonTournament.GetRanking());
+    }
+    else if (isSeason)
     {
         ui->lblRankingRound->setEnabled(false);
         std::deque<Game> games;
@@ -497,17 +768,34 @@ void MainWindow::UpdateRanking()
             teams.insert(teams.end(), t.begin(), t.end());
         }
 
-        mTournament.GeneratePlayerRanking(games, teams, mEvents);
+        mSeasonTournament.GeneratePlayerRanking(games, teams, mEvents);
+        helper.Show(mDatabase.GetPlayers(), teams, true, mSeasonTournament.GetRanking());
     }
-    else
+    else if (mSession != nullptr)
     {
+        // Already computed in the background if the games did not change since
+        mWorkspace.Sync(*mSession);
         ui->lblRankingRound->setEnabled(true);
-        ui->lblRankingRound->setText(QString().number(mCurrentRankingRound));
-        mTournament.GenerateTeamRanking(mGames, mTeams, mCurrentRankingRound);
+        ui->lblRankingRound->setText(QString().number(mSession->GetRankingRound()));
+        helper.Show(mDatabase.GetPlayers(), mSession->teams, false, mSession->GetRanking());
+    }
+    else
+    {
+        helper.Show(mDatabase.GetPlayers(), cNoTeams, false, cNoRanking);
     }
-    helper.Show(mDatabase.GetPlayerList(), mTeams, isSeason, mTournament.GetRanking());
+    mRankingDirty = false;
+}
 
-    UpdateBrackets();
+/**
+ * @brief Games have changed: refresh the ranking now if it is displayed, later otherwise
+ */
+void MainWindow::InvalidateRanking()
+{
+    mRankingDirty = true;
+    if (ui->tabWidget_2->currentWidget() == ui->tab_6)
+    {
+        UpdateRanking();
+    }
 }
 
 
@@ -519,33 +807,45 @@ void MainWindow::slotRankingOptionChanged(bool checked)
 
 void MainWindow::slotRankingLeft()
 {
-    if (mCurrentRankingRound > 1)
+    if ((mSession != nullptr) && (mSession->GetRankingRound() > 1))
     {
-        mCurrentRankingRound--;
+        mSession->SetRankingRound(mSession->GetRankingRound() - 1);
     }
     UpdateRanking();
 }
 
 void MainWindow::slotRankingRight()
 {
-    int nbGames = mTeams.size() / 2;
-    if (mTeams.size()%2)
-    {
-        nbGames += 1;
-    }
-
-    int maxTurn = (nbGames == 0) ? 0 : (mGames.size() / nbGames);
-
-    if (mCurrentRankingRound < maxTurn)
+    if ((mSession != nullptr) && (mSession->GetRankingRound() < mSession->GetMaxRound()))
     {
-        mCurrentRankingRound++;
+        mSession->SetRankingRound(mSession->GetRankingRound() + 1);
     }
     UpdateRanking();
 }
 
 void MainWindow::slotExportRanking()
 {
-    ExportTable(ui->tableContest, tr("Exporter le classement au format Excel (CSV)"));
+    QString fileName = GetExportFileName(tr("Exporter le classement au format Excel (CSV)"));
+    if (!fileName.isEmpty())
+    {
+        // The ranking has been computed by the last call to UpdateRanking()
+        bool isSeason = ui->radioSeason->isChecked();
+        bool success = false;
+
+        if (isSeason)
+        {
+            success = Exporter::ExportRanking(fileName.toStdString(), mSeasonTournament.GetRanking(), std::deque<Team>(), mDatabase.GetPlayers(), true);
+        }
+        else if (mSession != nullptr)
+        {
+            success = Exporter::ExportRanking(fileName.toStdString(), mSession->GetRanking(), mSession->teams, mDatabase.GetPlayers(), false);
+        }
+
+        if (!success)
+        {
+            TLogError("Ranking export failure");
+        }
+    }
 }
 
 // ===========================================================================================
@@ -564,22 +864,55 @@ void MainWindow::UpdateEventsTable()
 
     helper.Finish();
 
+    mSession = nullptr;
+
     if (mEvents.size() > 0)
     {
         // Will refresh all the UI elements for that event
         ui->eventTable->selectRow(mEvents.size() - 1);
+        if (mSession == nullptr)
+        {
+            // Same row as before: no selection signal
+            slotEventItemActivated();
+        }
+
+        // The selected event is displayed first, the others are loaded after
+        QTimer::singleShot(0, this, &MainWindow::PrefetchEvents);
     }
     else
     {
         // Empty teams and games
         ui->teamTable->clear();
         ui->gameTable->clear();
+        UpdateEventActions();
     }
 }
 
+/**
+ * @brief Load the last events of the season and rank them in the background
+ *
+ * Switching to one of these events then displays the cached data at once.
+ * The selected event (another one may have been selected meanwhile) is
+ * pinned in the workspace and keeps its place.
+ */
+void MainWindow::PrefetchEvents()
+{
+    TRACE_SCOPE("ui.PrefetchEvents");
+    std::uint32_t count = 0U;
+
+    for (auto it = mEvents.rbegin(); (it != mEvents.rend()) && (count < (EventWorkspace::cMaxSessions - 1U)); ++it)
+    {
+        if ((mSession == nullptr) || (it->id != mSession->event.id))
+        {
+            (void) mWorkspace.Open(it->id);
+            count++;
+        }
+    }
+    mWorkspace.RankAll();
+}
+
 void MainWindow::slotEventItemActivated()
 {
-    mCurrentRankingRound = 1;
     int row = ui->eventTable->currentRow();
     if (row > -1)
     {
@@ -588,14 +921,16 @@ void MainWindow::slotEventItemActivated()
 
         if (helper.GetFirstColumnValue(id))
         {
-            mCurrentEvent = mDatabase.GetEvent(id);
+            // Cached events are not reloaded
+            mSession = mWorkspace.Open(id);
+            mWorkspace.Pin((mSession != nullptr) ? id : -1);
 
-            if (mCurrentEvent.IsValid())
+            if (mSession != nullptr)
             {
-                std::cout << "Current event id: " << mCurrentEvent.id << std::endl;
-                UpdateTeamList();
-                UpdateGameList();
-                UpdateRanking();
+                ALogDebug("Current event id: " << id);
+                ShowTeamList();
+                ShowGameList();
+                mBus.Post(Change::cGames); // ranking and network clients
             }
             else
             {
@@ -603,6 +938,31 @@ void MainWindow::slotEventItemActivated()
             }
         }
     }
+    UpdateEventActions();
+}
+
+/**
+ * @brief True if the selected event can be modified (its season is not closed)
+ */
+bool MainWindow::IsEditable() const
+{
+    return (mSession != nullptr) && !mDatabase.IsArchived(mSession->event.id);
+}
+
+/**
+ * @brief The events of a closed season are read-only
+ */
+void MainWindow::UpdateEventActions()
+{
+    bool editable = IsEditable();
+    for (auto button : { ui->buttonEditEvent, ui->buttonDeleteEvent,
+                         ui->buttonAddTeam, ui->buttonEditTeam, ui->buttonDeleteTeam,
+                         ui->buttonCreateGames, ui->buttonAddGame, ui->buttonEditGame,
+                         ui->buttonUndoScore, ui->buttonDeleteGame, ui->buttonDeleteAllGames,
+                         ui->btnRankingRewards })
+    {
+        button->setEnabled(editable);
+    }
 }
 
 void MainWindow::slotAddEvent()
@@ -615,7 +975,7 @@ void MainWindow::slotAddEvent()
         event.year = Util::GetYear(event.date);
         if (mDatabase.AddEvent(event))
         {
-            UpdateSeasons();
+            mBus.Post(Change::cEvents);
         }
     }
 }
@@ -625,13 +985,13 @@ void MainWindow::slotEditEvent()
     TableHelper helper(ui->eventTable);
 
     int id;
-    if (helper.GetFirstColumnValue(id))
+    if (helper.GetFirstColumnValue(id) && (mSession != nullptr))
     {
-        eventWindow->SetEvent(mCurrentEvent);
+        eventWindow->SetEvent(mSession->event);
         if (eventWindow->exec() == QDialog::Accepted)
         {
-            eventWindow->GetEvent(mCurrentEvent);
-            if (!mDatabase.EditEvent(mCurrentEvent))
+            eventWindow->GetEvent(mSession->event);
+            if (!mDatabase.EditEvent(mSession->event))
             {
                 TLogError("Cannot edit event!");
             }
@@ -654,6 +1014,10 @@ void MainWindow::slotDeleteEvent()
                                     tr("Attention ! Toutes les parties associées seront perdues. Continuer ?"),
                                     QMessageBox::Ok | QMessageBox::Cancel) == QMessageBox::Ok)
         {
+            // The ratings keep the points of the games played, they are replayed without them
+            std::deque<Game> games = mDatabase.GetGamesByEventId(id);
+            bool rated = std::any_of(games.begin(), games.end(), [](const Game &g) { return g.IsPlayed(); });
+
             bool success = mDatabase.DeleteGameByEventId(id);
             success = success && mDatabase.DeleteTeamByEventId(id);
             success = success && mDatabase.DeleteEvent(id);
@@ -662,7 +1026,18 @@ void MainWindow::slotDeleteEvent()
             {
                 TLogError("Delete event failure");
             }
-            UpdateSeasons();
+
+            if (rated)
+            {
+                RecomputeRatings();
+            }
+
+            if ((mSession != nullptr) && (mSession->event.id == id))
+            {
+                mSession = nullptr;
+            }
+            mWorkspace.Close(id);
+            mBus.Post(Change::cEvents);
         }
     }
 }
@@ -672,6 +1047,13 @@ void MainWindow::slotDeleteEvent()
 // ===========================================================================================
 void MainWindow::UpdateSeasons()
 {
+    if (!mEventsLoaded)
+    {
+        // First display of the events: the ratings are needed to pair and score
+        LoadRatings();
+        mEventsLoaded = true;
+    }
+
     QStringList seasons = mDatabase.GetSeasons();
 
     ui->comboSeasons->clear();
@@ -692,39 +1074,75 @@ void MainWindow::slotSeasonChanged(int index)
 // ===========================================================================================
 void MainWindow::slotGenerateGames()
 {
-    if (mTeams.size()%2)
+    if (mSession == nullptr)
+    {
+        return;
+    }
+
+    if (mSession->event.IsKnockout())
+    {
+        GenerateBracketGames();
+        return;
+    }
+
+    // Courts are given after the pairing, the teams avoid the courts already played
+    CourtAllocator allocator(CourtAllocator::GetCourts(mSession->event));
+    allocator.AddHistory(mSession->games);
+
+    if (mSession->teams.size()%2)
     {
         (void) QMessageBox::warning(this, tr("Tanca"),
                                     tr("Nombre impair d'équipes, ajoutez une équipe fictive"),
                                     QMessageBox::Ok);
     }
-    else
+    else if (mSession->event.type == Event::cRoundRobin)
     {
-        std::deque<Game> games;
-        std::string error;
+        // The schedule continues after the rounds already generated, the games
+        // are streamed to the database without building a list
+        int rounds = ui->spinNbRounds->value();
+        RoundRobinStream stream(mSession->teams, Tournament::CountRounds(mSession->games), static_cast<std::uint32_t>(rounds));
+        CourtStream courts(allocator, [&stream]() { return stream.Next(); });
 
-        if (mCurrentEvent.type == Event::cRoundRobin)
+        if (stream.GetTotal() > 0U)
         {
-            int rounds = ui->spinNbRounds->value();
-            error = mTournament.BuildRoundRobinRounds(mTeams, rounds, games);
+            mSession->event.state = Event::cStarted;
+            mDatabase.UpdateEventState(mSession->event);
+
+            if (!mDatabase.AddGames([&courts]() { return courts.Next(); }))
+            {
+                TLogError("Cannot store rounds!");
+            }
+            UpdateGameList();
         }
         else
         {
-            // Swiss algorithm
-            error = mTournament.BuildSwissRounds(mGames, mTeams, games);
+            TLogError("Cannot build rounds!");
+            (void) QMessageBox::warning(this, tr("Tanca"),
+                                        tr("Impossible de générer les parties : pas assez d'équipes"),
+                                        QMessageBox::Ok);
         }
+    }
+    else
+    {
+        // Swiss algorithm
+        std::deque<Game> games;
+        std::string error = mSession->BuildSwissRound(games, mWorkspace.GetStrength(*mSession));
 
         if (games.size() > 0)
         {
-            mCurrentEvent.state = Event::cStarted;
-            mDatabase.UpdateEventState(mCurrentEvent);
+            allocator.Assign(games);
+            mSession->event.state = Event::cStarted;
+            mDatabase.UpdateEventState(mSession->event);
 
-            if (!mDatabase.AddGames(games))
+            if (mDatabase.AddGames(games))
+            {
+                AddGameRows(games);
+            }
+            else
             {
                 TLogError("Cannot store rounds!");
+                UpdateGameList();
             }
-
-            UpdateGameList();
         }
         else
         {
@@ -736,85 +1154,464 @@ void MainWindow::slotGenerateGames()
     }
 }
 
+/**
+ * @brief Games of the bracket whose two teams are known
+ *
+ * The first time, the teams are seeded with the ranking of the games already
+ * played (Swiss rounds before the finals); the seeds are kept in the teams.
+ */
+void MainWindow::GenerateBracketGames()
+{
+    Bracket *bracket = mSession->GetBracket();
+
+    if (bracket == nullptr)
+    {
+        Tournament tournament;
+        tournament.GenerateTeamRanking(mSession->games, mSession->teams, INT_MAX);
+        std::vector<int> seeds = Bracket::Seeds(tournament.GetRanking(), mSession->teams);
 
-bool MainWindow::FindGame(const int id, Game &game)
+        for (std::uint32_t i = 0U; i < seeds.size(); i++)
+        {
+            Team team = *mSession->FindTeam(seeds[i]);
+            Bracket::SetSeed(team, static_cast<int>(i) + 1);
+            if (!mDatabase.EditTeam(team))
+            {
+                TLogError("Cannot store the seed of the team!");
+            }
+        }
+        mWorkspace.ReloadTeams(*mSession);
+        bracket = mSession->GetBracket();
+    }
+
+    if ((bracket == nullptr) || (bracket->GetSize() == 0U))
+    {
+        (void) QMessageBox::warning(this, tr("Tanca"),
+                                    tr("Impossible de générer les parties : pas assez d'équipes"),
+                                    QMessageBox::Ok);
+        return;
+    }
+
+    std::deque<Game> games;
+    for (auto match : bracket->GetMatchesToPlay())
+    {
+        Game game;
+        bracket->MakeGame(match, mSession->event.id, game);
+        games.push_back(game);
+    }
+
+    if (games.size() > 0)
+    {
+        CourtAllocator allocator(CourtAllocator::GetCourts(mSession->event));
+        allocator.AddHistory(mSession->games);
+        allocator.Assign(games);
+        mSession->event.state = Event::cStarted;
+        mDatabase.UpdateEventState(mSession->event);
+
+        if (mDatabase.AddGames(games))
+        {
+            AddGameRows(games);
+        }
+        else
+        {
+            TLogError("Cannot store rounds!");
+            UpdateGameList();
+        }
+    }
+    else
+    {
+        (void) QMessageBox::information(this, tr("Tanca"),
+                                        tr("Aucune partie à générer : entrez les scores des parties en cours"),
+                                        QMessageBox::Ok);
+    }
+}
+
+/**
+ * @brief Update the games of the bracket matches whose teams have changed
+ *
+ * A game is created as soon as its two teams are known; a game whose teams
+ * are not known anymore (a previous result was corrected) is deleted.
+ */
+void MainWindow::AdvanceBracket(const std::vector<std::uint32_t> &changed)
 {
-    bool found = false;
-    for (size_t i = 0; i < mGames.size(); i++)
+    Bracket *bracket = mSession->GetBracket();
+    if (bracket == nullptr)
     {
-        if (mGames[i].id == id)
+        return;
+    }
+
+    // Collect first: removing a game resets the bracket of the session
+    std::deque<Game> edited;
+    std::deque<Game> created;
+    std::vector<int> deleted;
+
+    for (auto match : changed)
+    {
+        const Bracket::Match &m = bracket->GetMatch(match);
+        const Game *found = (m.gameId >= 0) ? mSession->FindGame(m.gameId) : nullptr;
+
+        if (found != nullptr)
         {
-            found = true;
-            game = mGames[i];
-            break;
+            if (bracket->IsReady(match))
+            {
+                Game game = *found;
+                game.team1Id = m.team1;
+                game.team2Id = m.team2;
+                edited.push_back(game);
+            }
+            else
+            {
+                deleted.push_back(found->id);
+            }
+        }
+        else if (bracket->IsReady(match))
+        {
+            Game game;
+            bracket->MakeGame(match, mSession->event.id, game);
+            created.push_back(game);
         }
     }
 
-    return found;
+    for (auto const &game : edited)
+    {
+        if (mDatabase.EditGame(game))
+        {
+            UpdateGameRow(game);
+        }
+        else
+        {
+            TLogError("Cannot edit game!");
+        }
+    }
+
+    if (created.size() > 0)
+    {
+        CourtAllocator allocator(CourtAllocator::GetCourts(mSession->event));
+        allocator.AddHistory(mSession->games);
+        allocator.Assign(created);
+        if (mDatabase.AddGames(created))
+        {
+            AddGameRows(created);
+        }
+        else
+        {
+            TLogError("Cannot store rounds!");
+        }
+    }
+
+    for (auto id : deleted)
+    {
+        if (mDatabase.DeleteGame(id))
+        {
+            RemoveGameRow(id);
+        }
+        else
+        {
+            TLogError("Delete game failure");
+        }
+    }
+}
+
+void MainWindow::LoadRatings()
+{
+    std::deque<Rating> ratings = mDatabase.GetRatings();
+    if (ratings.empty())
+    {
+        // New database, or upgraded from a version without ratings
+        RecomputeRatings();
+    }
+    else
+    {
+        mRatings.SetRatings(ratings);
+    }
+}
+
+/**
+ * @brief Replay the whole history, the stored ratings are replaced
+ */
+void MainWindow::RecomputeRatings()
+{
+    std::vector<RatedEvent> history = mDatabase.GetRatingHistory();
+    std::deque<RatingDelta> deltas;
+
+    mRatings.Recompute(history, deltas);
+    if (!mDatabase.StoreRatings(mRatings.GetRatings(), deltas, true))
+    {
+        TLogError("Cannot store the ratings!");
+    }
 }
 
-void MainWindow::UpdateBrackets()
+/**
+ * @brief Incremental update when a score is stored or a game deleted
+ *
+ * The previous result of the game is taken back first, only the ratings of
+ * the players of the game are written.
+ */
+void MainWindow::CommitRating(const Game &game, bool deleted)
 {
-    QString json; // FIXME = mTournament.ToJsonString(mGames, mTeams);
+    const Team *team1 = FindTeam(game.team1Id);
+    const Team *team2 = FindTeam(game.team2Id);
+
+    if ((team1 == nullptr) || (team2 == nullptr))
+    {
+        return;
+    }
+
+    double delta;
+    if (mDatabase.GetRatingDelta(game.id, delta))
+    {
+        mRatings.Revert(*team1, *team2, delta);
+        mDatabase.DeleteRatingDelta(game.id);
+    }
+
+    std::deque<RatingDelta> deltas;
+    RatingDelta d;
+    d.gameId = game.id;
+    if (!deleted && mRatings.Apply(game, *team1, *team2, d.delta))
+    {
+        deltas.push_back(d);
+    }
 
-    mServer.SetGames(json.toStdString());
+    if (!mDatabase.StoreRatings(mRatings.GetRatings(*team1, *team2), deltas, false))
+    {
+        TLogError("Cannot store the ratings!");
+    }
 }
 
+const Game *MainWindow::FindGame(int id) const
+{
+    return (mSession != nullptr) ? mSession->FindGame(id) : nullptr;
+}
 
-void MainWindow::UpdateGameList()
+const Team *MainWindow::FindTeam(int id) const
 {
-    mGames = mDatabase.GetGamesByEventId(mCurrentEvent.id);
+    return (mSession != nullptr) ? mSession->FindTeam(id) : nullptr;
+}
 
-    UpdateBrackets();
+/**
+ * @brief Games of the current event, served to the brackets view through the network
+ */
+std::string MainWindow::GamesToJson() const
+{
+    TRACE_SCOPE("ui.GamesToJson");
+    static const std::deque<Game> cNoGames;
+    QJsonArray json;
+    for (auto const &g : (mSession != nullptr) ? mSession->games : cNoGames)
+    {
+        const Team *team1 = FindTeam(g.team1Id);
+        const Team *team2 = FindTeam(g.team2Id);
 
-    TableHelper helper(ui->gameTable);
-    helper.Initialize(gGamesTableHeader, mGames.size());
+        if ((team1 != nullptr) && (team2 != nullptr))
+        {
+            QJsonObject t1;
+            t1["name"] = team1->teamName.c_str();
+            t1["number"] = team1->number;
+            t1["score"] = (g.team1Score == -1) ? QJsonValue("") : QJsonValue(g.team1Score);
+
+            QJsonObject t2;
+            t2["name"] = team2->teamName.c_str();
+            t2["number"] = team2->number;
+            t2["score"] = (g.team2Score == -1) ? QJsonValue("") : QJsonValue(g.team2Score);
+
+            QJsonObject game;
+            game["round"] = g.turn;
+            game["court"] = CourtAllocator::GetCourt(g);
+            game["t1"] = t1;
+            game["t2"] = t2;
+
+            json.append(game);
+        }
+    }
 
-    foreach (Game game, mGames)
+    return QJsonDocument(json).toJson(QJsonDocument::Compact).toStdString();
+}
+
+std::list<Value> MainWindow::GameRowData(const Game &game) const
+{
+    // Be tolerant: only print found teams
+    int court = CourtAllocator::GetCourt(game);
+    return {game.id, (int)(game.turn + 1)
+            , mDatabase.GetTeamLabel(FindTeam(game.team1Id))
+            , mDatabase.GetTeamLabel(FindTeam(game.team2Id))
+            , game.team1Score, game.team2Score
+            , (court > 0) ? std::to_string(court) : std::string()};
+}
+
+void MainWindow::UpdateGameList()
+{
+    if (mSession != nullptr)
     {
-        Team t1, t2;
+        mWorkspace.ReloadGames(*mSession);
+    }
+    ShowGameList();
 
-        // Be tolerant: only print found teams (forget return code)
-        (void) Team::Find(mTeams, game.team1Id, t1);
-        (void) Team::Find(mTeams, game.team2Id, t2);
+    mBus.Post(Change::cGames);
+}
 
-        std::list<Value> gameData = {game.id, (int)(game.turn + 1)
-                , "(" + std::to_string(t1.number) + ") " + t1.teamName
-                , "(" + std::to_string(t2.number) + ") " + t2.teamName
-                , game.team1Score, game.team2Score};
-        helper.AppendLine(gameData, game.IsPlayed());
+/**
+ * @brief Display the games of the selected event, as loaded in its session
+ */
+void MainWindow::ShowGameList()
+{
+    TRACE_SCOPE("ui.ShowGameList");
+    static const std::deque<Game> cNoGames;
+    const std::deque<Game> &games = (mSession != nullptr) ? mSession->games : cNoGames;
+
+    mGameItems.clear();
+
+    TableHelper helper(ui->gameTable);
+    helper.Initialize(gGamesTableHeader, games.size());
 
+    int row = 0;
+    for (auto const &game : games)
+    {
+        helper.AppendLine(GameRowData(game), game.IsPlayed());
+        mGameItems[game.id] = ui->gameTable->item(row, 0);
+        row++;
     }
 
     helper.Finish();
     ui->gameTable->sortByColumn(1, Qt::AscendingOrder);
 }
 
+/**
+ * @brief Patch the row of one game (score edited), the other rows are left untouched
+ */
+void MainWindow::UpdateGameRow(const Game &game)
+{
+    if (mSession != nullptr)
+    {
+        mSession->SetGame(game);
+    }
+
+    auto it = mGameItems.find(game.id);
+    if (it != mGameItems.end())
+    {
+        TableHelper helper(ui->gameTable);
+        helper.BeginUpdate();
+        int row = it->second->row();
+        helper.SetLine(row, GameRowData(game), game.IsPlayed());
+        it->second = ui->gameTable->item(row, 0);
+        helper.EndUpdate();
+
+        mBus.Post(Change::cGames);
+    }
+    else
+    {
+        UpdateGameList();
+    }
+}
+
+void MainWindow::AddGameRows(const std::deque<Game> &games)
+{
+    TableHelper helper(ui->gameTable);
+
+    if ((mSession == nullptr) || (mSession->games.size() == 0))
+    {
+        // First games of the event, the table has no header yet
+        UpdateGameList();
+        return;
+    }
+
+    mSession->AddGames(games);
+
+    helper.BeginUpdate();
+    for (auto const &game : games)
+    {
+        int row = helper.InsertLine(GameRowData(game), game.IsPlayed());
+        mGameItems[game.id] = ui->gameTable->item(row, 0);
+    }
+    helper.EndUpdate();
+
+    mBus.Post(Change::cGames);
+}
+
+void MainWindow::RemoveGameRow(int id)
+{
+    if (mSession != nullptr)
+    {
+        mSession->RemoveGame(id);
+    }
+
+    auto item = mGameItems.find(id);
+    if (item != mGameItems.end())
+    {
+        TableHelper helper(ui->gameTable);
+        helper.RemoveLine(item->second->row());
+        mGameItems.erase(item);
+    }
+
+    mBus.Post(Change::cGames);
+}
+
 void MainWindow::slotAddGame()
 {
+    if (mSession == nullptr)
+    {
+        return;
+    }
+
     // Prepare widget contents
-    gameWindow->Initialize(mTeams);
+    gameWindow->Initialize(mSession->teams);
     gameWindow->AllowZeroNumber(false);
 
     if (gameWindow->exec() == QDialog::Accepted)
     {
         Game game;
         gameWindow->GetGame(game);
-        game.eventId = mCurrentEvent.id;
+        game.eventId = mSession->event.id;
         game.turn = gameWindow->GetNumber() - 1; // turns begin internally @ zero
 
         std::deque<Game> list;
         list.push_back(game);
         if (mDatabase.AddGames(list))
         {
-            if (mCurrentEvent.state != Event::cStarted)
+            if (mSession->event.state != Event::cStarted)
             {
-                mCurrentEvent.state = Event::cStarted;
-                mDatabase.UpdateEventState(mCurrentEvent);
+                mSession->event.state = Event::cStarted;
+                mDatabase.UpdateEventState(mSession->event);
             }
-            UpdateGameList();
+            AddGameRows(list);
+        }
+    }
+}
+
+/**
+ * @brief Store an edited score, with the bracket and the ratings
+ * @param undoOf: score log entry taken back, 0 for a new score
+ */
+bool MainWindow::StoreScore(const Game &game, std::int64_t undoOf)
+{
+    // A bracket game needs a winner, and the next matches must not be played yet
+    int match = Bracket::GetMatchId(game);
+    Bracket *bracket = (match > 0) ? mSession->GetBracket() : nullptr;
+    int winner = Bracket::GetWinner(game);
+    bool success = false;
+
+    if ((bracket != nullptr) && game.IsPlayed() &&
+        ((winner == Bracket::cNone) || !bracket->CanSetResult(static_cast<std::uint32_t>(match), winner)))
+    {
+        (void) QMessageBox::warning(this, tr("Tanca"),
+                                    tr("Résultat refusé : match nul, ou le match suivant est déjà joué"),
+                                    QMessageBox::Ok);
+    }
+    else if (!mDatabase.EditGame(game, undoOf))
+    {
+        TLogError("Cannot edit game!");
+    }
+    else
+    {
+        CommitRating(game, false);
+        UpdateGameRow(game);
+
+        std::vector<std::uint32_t> changed;
+        if ((bracket != nullptr) && (winner != Bracket::cNone) &&
+            bracket->SetResult(static_cast<std::uint32_t>(match), winner, changed))
+        {
+            AdvanceBracket(changed);
         }
+        success = true;
     }
+    return success;
 }
 
 void MainWindow::slotEditGame()
@@ -829,30 +1626,22 @@ void MainWindow::slotEditGame()
         if (data.contains(0))
         {
             int id = data[0].toInt();
-            std::cout << "Found team id: " << id << std::endl;
-            Game game;
+            ALogDebug("Found game id: " << id);
+            const Game *found = FindGame(id);
 
-            if (FindGame(id, game))
+            if (found != nullptr)
             {
-                Team team1;
-                Team team2;
-
+                Game game = *found; // edited copy
                 // Be tolerant if teams are not found
-                (void) Team::Find(mTeams, game.team1Id, team1);
-                (void) Team::Find(mTeams, game.team2Id, team2);
+                static const Team cNoTeam;
+                const Team *team1 = FindTeam(game.team1Id);
+                const Team *team2 = FindTeam(game.team2Id);
 
-                scoreWindow->SetGame(game, team1, team2);
+                scoreWindow->SetGame(game, (team1 != nullptr) ? *team1 : cNoTeam, (team2 != nullptr) ? *team2 : cNoTeam);
                 if (scoreWindow->exec() == QDialog::Accepted)
                 {
                     scoreWindow->GetGame(game);
-                    if (!mDatabase.EditGame(game))
-                    {
-                        TLogError("Cannot edit game!");
-                    }
-                    else
-                    {
-                        UpdateGameList();
-                    }
+                    StoreScore(game, 0);
                 }
             }
         }
@@ -864,8 +1653,46 @@ void MainWindow::slotEditGame()
 }
 
 
+/**
+ * @brief Take back the last score entered in the event, found in the score log
+ */
+void MainWindow::slotUndoScore()
+{
+    ScoreEntry entry;
+    if ((mSession == nullptr) || !ScoreEntry::FindUndo(mDatabase.GetScoreLog(mSession->event.id), entry))
+    {
+        return;
+    }
+
+    const Game *found = FindGame(entry.gameId);
+    if (found != nullptr)
+    {
+        Game game = *found;
+        game.team1Score = entry.oldScore1;
+        game.team2Score = entry.oldScore2;
+
+        if ((Bracket::GetMatchId(game) > 0) && !game.IsPlayed())
+        {
+            // The winner may already play the next match
+            (void) QMessageBox::warning(this, tr("Tanca"),
+                                        tr("Le résultat d'un match du tableau ne peut pas être annulé"),
+                                        QMessageBox::Ok);
+        }
+        else if (QMessageBox::question(this, tr("Annuler le pointage"),
+                                       tr("Remettre la partie %1 à son score précédent ?").arg(game.id)) == QMessageBox::Yes)
+        {
+            StoreScore(game, entry.seq);
+        }
+    }
+}
+
 void MainWindow::slotDeleteGame()
 {
+    if (!IsEditable())
+    {
+        return;
+    }
+
     TableHelper helper(ui->gameTable);
 
     int id;
@@ -875,17 +1702,31 @@ void MainWindow::slotDeleteGame()
                                     tr("Attention ! Tous les points associées seront perdus. Continuer ?"),
                                     QMessageBox::Ok | QMessageBox::Cancel) == QMessageBox::Ok)
         {
-            if (!mDatabase.DeleteGame(id))
+            const Game *game = FindGame(id);
+            if (game != nullptr)
+            {
+                CommitRating(*game, true);
+            }
+
+            if (mDatabase.DeleteGame(id))
+            {
+                RemoveGameRow(id);
+            }
+            else
             {
                 TLogError("Delete game failure");
             }
-            UpdateGameList();
         }
     }
 }
 
 void MainWindow::slotDeleteAllGames()
 {
+    if (!IsEditable())
+    {
+        return;
+    }
+
     if (QMessageBox::warning(this, tr("Suppression de toutes les rencontres"),
                                 tr("Attention ! Tous les points associées seront perdus. Continuer ?"),
                                 QMessageBox::Ok | QMessageBox::Cancel) == QMessageBox::Ok)
@@ -895,6 +1736,11 @@ void MainWindow::slotDeleteAllGames()
         for( int r = 0; r < ui->gameTable->rowCount(); ++r )
         {
             int id = ui->gameTable->item(r, 0)->text().toInt();
+            const Game *game = FindGame(id);
+            if (game != nullptr)
+            {
+                CommitRating(*game, true);
+            }
 
             if (!mDatabase.DeleteGame(id))
             {
@@ -908,7 +1754,14 @@ void MainWindow::slotDeleteAllGames()
 
 void MainWindow::slotExportGames()
 {
-    ExportTable(ui->gameTable, tr("Exporter la liste des parties au format Excel (CSV)"));
+    QString fileName = GetExportFileName(tr("Exporter la liste des parties au format Excel (CSV)"));
+    if (!fileName.isEmpty() && (mSession != nullptr))
+    {
+        if (!Exporter::ExportGames(fileName.toStdString(), mSession->games, mSession->teams))
+        {
+            TLogError("Games export failure");
+        }
+    }
 }
 
 std::string StateToString(const Event &event)
@@ -937,10 +1790,18 @@ std::string TypeToString(const Event &event)
     {
         return "Tournoi type toutes rondes";
     }
-    else if (event.type == Event::cSwissRounds)
+    else if ((event.type == Event::cSwissRounds) || (event.type == 1))
     {
         return "Tournoi type Suisse";
     }
+    else if (event.type == Event::cSingleElimination)
+    {
+        return "Élimination directe";
+    }
+    else if (event.type == Event::cDoubleElimination)
+    {
+        return "Double élimination";
+    }
     else
     {
         return "";
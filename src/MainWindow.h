@@ -27,6 +27,9 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QTableWidgetItem>
+#include <unordered_map>
+#include "Value.h"
 #include "DbManager.h"
 #include "PlayerWindow.h"
 #include "DatePickerWindow.h"
@@ -36,7 +39,10 @@
 #include "EventWindow.h"
 #include "ui_AboutWindow.h"
 #include "Tournament.h"
+#include "EventWorkspace.h"
+#include "Ratings.h"
 #include "Server.h"
+#include "ChangeBus.h"
 
 namespace Ui {
 class MainWindow;
@@ -72,6 +78,7 @@ private slots:
 
     void slotAddReward();
     void slotDeleteReward();
+    void slotRankingRewards();
 
     void slotAddEvent();
     void slotDeleteEvent();
@@ -87,14 +94,18 @@ private slots:
     void slotExportRanking();
     void slotExportGames();
     void slotTabChanged(int index);
+    void slotMainTabChanged(int index);
     void slotExportPlayers();
     void slotExportTeams();
+    void slotExportSeason();
     void slotRankingOptionChanged(bool checked);
     void slotRankingLeft();
     void slotRankingRight();
     void slotDeleteAllGames();
     void slotTeamItemActivated();
     void slotFilterPlayer();
+    void slotCloseSeason();
+    void slotUndoScore();
 private:
     void UpdatePlayersTable();
 
@@ -112,23 +123,55 @@ private:
     DbManager mDatabase;
     std::deque<int>  mPlayersInTeams; // Players already in teams
     std::deque<Event> mEvents;
-    std::deque<Team> mTeams;
-    std::deque<Game> mGames;
-    Event mCurrentEvent;
-    Tournament mTournament;
-    int mCurrentRankingRound;
+    EventWorkspace mWorkspace;
+    EventSession *mSession; // selected event, nullptr if none
+    std::unordered_map<int, QTableWidgetItem *> mGameItems; // game id -> first cell of its row in the game table
+    Tournament mSeasonTournament;
+    RatingEngine mRatings;
     int mSelectedTeam;
+    bool mRankingDirty;
+    bool mPlayersDirty;  // players table out of date, refreshed when shown
+    bool mEventsLoaded;  // events tab filled once shown
     Server mServer;
 
+    // Views refreshed by the change bus, once per frame
+    ChangeBus mBus;
+    ChangeListener mPlayersView;
+    ChangeListener mTeamsView;
+    ChangeListener mGamesView;
+    ChangeListener mRankingView;
+    ChangeListener mRewardsView;
+    ChangeListener mEventsView;
+
     void UpdateTeamList();
+    void ShowTeamList();
     bool FindPlayer(int id, Player &player);
     void UpdateGameList();
+    void ShowGameList();
+    const Team *FindTeam(int id) const;
+    std::list<Value> GameRowData(const Game &game) const;
+    void UpdateGameRow(const Game &game);
+    void AddGameRows(const std::deque<Game> &games);
+    void RemoveGameRow(int id);
+    void GenerateBracketGames();
+    void AdvanceBracket(const std::vector<std::uint32_t> &changed);
+    void LoadRatings();
+    void RecomputeRatings();
+    void CommitRating(const Game &game, bool deleted);
+    bool StoreScore(const Game &game, std::int64_t undoOf);
+    void InvalidatePlayers();
+    std::uint8_t SelectedPlayerChange();
+    void InvalidateRanking();
     void UpdateRanking();
-    bool FindGame(const int id, Game &game);
+    const Game *FindGame(int id) const;
     void UpdateSeasons();
     void UpdateEventsTable();
-    void ExportTable(QTableWidget *table, const QString &title);
-    void UpdateBrackets();
+    bool IsEditable() const;
+    void UpdateEventActions();
+    void PrefetchEvents();
+    QString GetExportFileName(const QString &title);
+    std::string GamesToJson() const;
+    void UpdateTraces();
     void UpdateRewards();
 };
 
@@ -0,0 +1,173 @@
+/*=============================================================================
+ * Tanca - PlayerStats.cpp
+ *=============================================================================
+ * Games, partners and opponents of a player, across the seasons
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+
+#include "PlayerStats.h"
+
+static bool IsRealPlayer(int id)
+{
+    return (id >= 0) && (id != Player::cDummyPlayer);
+}
+
+static void Count(StatsRecord &record, int id, int score, int oppScore)
+{
+    record.playerId = id;
+    record.games++;
+    if (score > oppScore)
+    {
+        record.won++;
+    }
+    else if (score < oppScore)
+    {
+        record.lost++;
+    }
+    else
+    {
+        record.draw++;
+    }
+}
+
+static std::deque<StatsRecord> Sorted(const std::unordered_map<int, StatsRecord> &records)
+{
+    std::deque<StatsRecord> list;
+    for (auto const &r : records)
+    {
+        list.push_back(r.second);
+    }
+    std::sort(list.begin(), list.end(), [](const StatsRecord &a, const StatsRecord &b) {
+        return (a.games > b.games) || ((a.games == b.games) && (a.playerId < b.playerId));
+    });
+    return list;
+}
+
+/*****************************************************************************/
+PlayerStats::PlayerStats(int id)
+    : playerId(id)
+    , won(0)
+    , lost(0)
+    , draw(0)
+    , pointsWon(0)
+    , pointsLost(0)
+{
+
+}
+
+int PlayerStats::WinRate() const
+{
+    return (GetPlayed() > 0) ? ((100 * won) / GetPlayed()) : 0;
+}
+
+const StatsRecord *PlayerStats::FindOpponent(int id) const
+{
+    for (auto const &r : opponents)
+    {
+        if (r.playerId == id)
+        {
+            return &r;
+        }
+    }
+    return nullptr;
+}
+
+void PlayerStats::AddGame(const Game &game, int year, const int team1Players[3], const int team2Players[3])
+{
+    const int *mine = nullptr;
+    const int *theirs = nullptr;
+
+    if (std::find(team1Players, team1Players + 3, playerId) != (team1Players + 3))
+    {
+        mine = team1Players;
+        theirs = team2Players;
+    }
+    else if (std::find(team2Players, team2Players + 3, playerId) != (team2Players + 3))
+    {
+        mine = team2Players;
+        theirs = team1Players;
+    }
+    else
+    {
+        return;
+    }
+
+    PlayerGame pg;
+    pg.game = game;
+    pg.year = year;
+    pg.pointsFor = (mine == team1Players) ? game.team1Score : game.team2Score;
+    pg.pointsAgainst = (mine == team1Players) ? game.team2Score : game.team1Score;
+
+    for (std::uint32_t i = 0U; i < 3U; i++)
+    {
+        if (IsRealPlayer(mine[i]) && (mine[i] != playerId))
+        {
+            pg.partners.push_back(mine[i]);
+        }
+        if (IsRealPlayer(theirs[i]))
+        {
+            pg.opponents.push_back(theirs[i]);
+        }
+    }
+
+    if (game.IsPlayed() && !game.HasBye())
+    {
+        if (pg.pointsFor > pg.pointsAgainst)
+        {
+            won++;
+        }
+        else if (pg.pointsFor < pg.pointsAgainst)
+        {
+            lost++;
+        }
+        else
+        {
+            draw++;
+        }
+        pointsWon += pg.pointsFor;
+        pointsLost += pg.pointsAgainst;
+
+        for (int id : pg.partners)
+        {
+            Count(mPartners[id], id, pg.pointsFor, pg.pointsAgainst);
+        }
+        for (int id : pg.opponents)
+        {
+            Count(mOpponents[id], id, pg.pointsFor, pg.pointsAgainst);
+        }
+    }
+
+    games.push_back(pg);
+}
+
+void PlayerStats::Finish()
+{
+    partners = Sorted(mPartners);
+    opponents = Sorted(mOpponents);
+    mPartners.clear();
+    mOpponents.clear();
+}
+
+//=============================================================================
+// End of file PlayerStats.cpp
+//=============================================================================
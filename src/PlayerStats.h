@@ -0,0 +1,112 @@
+/*=============================================================================
+ * Tanca - PlayerStats.h
+ *=============================================================================
+ * Games, partners and opponents of a player, across the seasons
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef PLAYER_STATS_H
+#define PLAYER_STATS_H
+
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+#include "IDataBase.h"
+
+/**
+ * @brief Results of the player with a partner, or against an opponent
+ */
+struct StatsRecord
+{
+    int playerId;
+    int games;
+    int won;
+    int lost;
+    int draw;
+
+    StatsRecord()
+        : playerId(-1)
+        , games(0)
+        , won(0)
+        , lost(0)
+        , draw(0)
+    {
+
+    }
+
+    // In percent
+    int WinRate() const { return (games > 0) ? ((100 * won) / games) : 0; }
+};
+
+/**
+ * @brief One game of the player, seen from its side
+ */
+struct PlayerGame
+{
+    Game game;
+    int year;
+    int pointsFor;
+    int pointsAgainst;
+    std::vector<int> partners;
+    std::vector<int> opponents;
+};
+
+/**
+ * @brief History of a player, built from the rows of one query
+ *
+ * The byes and the games not played yet are listed but not counted.
+ */
+class PlayerStats
+{
+public:
+    int playerId;
+    int won;
+    int lost;
+    int draw;
+    int pointsWon;
+    int pointsLost;
+
+    std::deque<PlayerGame> games;       // In the order given
+    std::deque<StatsRecord> partners;   // Most frequent first
+    std::deque<StatsRecord> opponents;  // Head-to-head, most frequent first
+
+    explicit PlayerStats(int id = -1);
+
+    int GetPlayed() const { return won + lost + draw; }
+    int WinRate() const;
+    const StatsRecord *FindOpponent(int id) const;
+
+    // Players of the teams, -1 if none; ignored if the player is in neither team
+    void AddGame(const Game &game, int year, const int team1Players[3], const int team2Players[3]);
+    // Sort the records, once all the games are added
+    void Finish();
+
+private:
+    std::unordered_map<int, StatsRecord> mPartners;
+    std::unordered_map<int, StatsRecord> mOpponents;
+};
+
+#endif // PLAYER_STATS_H
+
+//=============================================================================
+// End of file PlayerStats.h
+//=============================================================================
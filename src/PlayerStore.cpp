@@ -0,0 +1,196 @@
+/*=============================================================================
+ * Tanca - PlayerStore.cpp
+ *=============================================================================
+ * Compact list of the players of the base
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "PlayerStore.h"
+
+const std::uint32_t PlayerStore::cNotFound;
+const std::uint32_t PlayerStore::cDummyRow;
+
+static const std::uint32_t cMinSlots = 1024U; // power of two
+
+static std::uint32_t Hash(const char *text, std::size_t length)
+{
+    std::uint32_t hash = 2166136261U; // FNV-1a
+    for (std::size_t i = 0U; i < length; i++)
+    {
+        hash = (hash ^ static_cast<std::uint8_t>(text[i])) * 16777619U;
+    }
+    return hash;
+}
+
+PlayerStore::PlayerStore()
+    : mUsedSlots(0U)
+    , mSorted(true)
+{
+    Clear();
+}
+
+void PlayerStore::Clear()
+{
+    mRecords.clear();
+    mArena.assign(1U, '\0'); // offset 0 is the empty text
+    mSlots.clear();
+    mUsedSlots = 0U;
+    mSorted = true;
+    mDummy = MakeRecord(Player::Dummy());
+}
+
+void PlayerStore::Add(const Player &player)
+{
+    Record record = MakeRecord(player);
+
+    if (!mRecords.empty() && (mRecords.back().id >= record.id))
+    {
+        mSorted = false;
+    }
+    mRecords.push_back(record);
+}
+
+void PlayerStore::Finish()
+{
+    if (!mSorted)
+    {
+        std::stable_sort(mRecords.begin(), mRecords.end(), [](const Record &a, const Record &b) { return a.id < b.id; });
+        mSorted = true;
+    }
+
+    // Only needed to share the texts while adding
+    std::vector<std::uint32_t>().swap(mSlots);
+    mUsedSlots = 0U;
+    mRecords.shrink_to_fit();
+    mArena.shrink_to_fit();
+}
+
+std::uint32_t PlayerStore::IndexOf(int id) const
+{
+    if (id == Player::cDummyPlayer)
+    {
+        return cDummyRow;
+    }
+
+    auto it = std::lower_bound(mRecords.begin(), mRecords.end(), id, [](const Record &r, int value) { return r.id < value; });
+    if ((it == mRecords.end()) || (it->id != id))
+    {
+        return cNotFound;
+    }
+    return static_cast<std::uint32_t>(it - mRecords.begin());
+}
+
+std::string PlayerStore::FullName(std::uint32_t row) const
+{
+    return std::string(GetName(row)) + " " + GetLastName(row);
+}
+
+std::size_t PlayerStore::MemoryUsage() const
+{
+    return (mRecords.capacity() * sizeof(Record)) + mArena.capacity() + (mSlots.capacity() * sizeof(std::uint32_t));
+}
+
+PlayerStore::Record PlayerStore::MakeRecord(const Player &player)
+{
+    Record record;
+    record.id = player.id;
+    record.state = player.state;
+    record.name = Intern(player.name);
+    record.lastName = Intern(player.lastName);
+    record.nickName = Intern(player.nickName);
+    return record;
+}
+
+/**
+ * @brief Offset of the text in the arena, added if not already there
+ */
+std::uint32_t PlayerStore::Intern(const std::string &text)
+{
+    if (text.empty())
+    {
+        return 0U;
+    }
+
+    // Keep the table at most half full
+    if ((2U * (mUsedSlots + 1U)) > mSlots.size())
+    {
+        Grow();
+    }
+
+    std::uint32_t mask = static_cast<std::uint32_t>(mSlots.size()) - 1U;
+    std::uint32_t slot = Hash(text.data(), text.size()) & mask;
+    while (mSlots[slot] != 0U)
+    {
+        const char *stored = &mArena[mSlots[slot] - 1U];
+        if ((std::strncmp(stored, text.data(), text.size()) == 0) && (stored[text.size()] == '\0'))
+        {
+            return mSlots[slot] - 1U;
+        }
+        slot = (slot + 1U) & mask;
+    }
+
+    std::uint32_t offset = static_cast<std::uint32_t>(mArena.size());
+    mArena.insert(mArena.end(), text.begin(), text.end());
+    mArena.push_back('\0');
+    mSlots[slot] = offset + 1U;
+    mUsedSlots++;
+    return offset;
+}
+
+/**
+ * @brief Larger table, filled again with the texts of the arena (all of them are shared)
+ */
+void PlayerStore::Grow()
+{
+    std::uint32_t count = 0U;
+    for (std::size_t offset = 1U; offset < mArena.size(); offset += std::strlen(&mArena[offset]) + 1U)
+    {
+        count++;
+    }
+
+    std::uint32_t size = cMinSlots;
+    while (size < (4U * (count + 1U)))
+    {
+        size *= 2U;
+    }
+
+    std::vector<std::uint32_t> slots(size, 0U);
+    std::uint32_t mask = size - 1U;
+    for (std::size_t offset = 1U; offset < mArena.size(); offset += std::strlen(&mArena[offset]) + 1U)
+    {
+        std::uint32_t slot = Hash(&mArena[offset], std::strlen(&mArena[offset])) & mask;
+        while (slots[slot] != 0U)
+        {
+            slot = (slot + 1U) & mask;
+        }
+        slots[slot] = static_cast<std::uint32_t>(offset) + 1U;
+    }
+
+    mSlots.swap(slots);
+    mUsedSlots = count;
+}
+
+//=============================================================================
+// End of file PlayerStore.cpp
+//=============================================================================
@@ -0,0 +1,104 @@
+/*=============================================================================
+ * Tanca - PlayerStore.h
+ *=============================================================================
+ * Compact list of the players of the base
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef PLAYER_STORE_H
+#define PLAYER_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "IDataBase.h"
+
+/**
+ * @brief Players kept in memory, names only
+ *
+ * A Player holds a dozen strings: several hundred bytes each, mostly for
+ * fields only read when a player is edited or exported. The store keeps the
+ * fields shown in the lists (id, state, names) in a fixed-size record; the
+ * names point into a single character arena where each distinct text is
+ * stored once (the same first names and last names come back often).
+ * The other fields stay in the database and are read on demand.
+ *
+ * Rows are sorted by id once filled: a lookup is a binary search.
+ *
+ * The dummy player (missing team member) is always known, as in the list it
+ * replaces: it has its own row, cDummyRow, outside of [0, Size()).
+ */
+class PlayerStore
+{
+public:
+    static const std::uint32_t cNotFound = 0xFFFFFFFFU;
+    static const std::uint32_t cDummyRow = 0xFFFFFFFEU;
+
+    PlayerStore();
+
+    void Clear();
+    void Add(const Player &player);
+    // Sorts the rows and releases the memory used while filling
+    void Finish();
+
+    std::uint32_t Size() const { return static_cast<std::uint32_t>(mRecords.size()); }
+    std::uint32_t IndexOf(int id) const; // cNotFound if unknown
+    bool Contains(int id) const { return IndexOf(id) != cNotFound; }
+
+    int GetId(std::uint32_t row) const { return At(row).id; }
+    int GetState(std::uint32_t row) const { return At(row).state; }
+    const char *GetName(std::uint32_t row) const { return &mArena[At(row).name]; }
+    const char *GetLastName(std::uint32_t row) const { return &mArena[At(row).lastName]; }
+    const char *GetNickName(std::uint32_t row) const { return &mArena[At(row).nickName]; }
+    std::string FullName(std::uint32_t row) const;
+
+    // Bytes allocated by the store
+    std::size_t MemoryUsage() const;
+
+private:
+    struct Record
+    {
+        std::int32_t id;
+        std::int32_t state;
+        std::uint32_t name;     // offsets in the arena
+        std::uint32_t lastName;
+        std::uint32_t nickName;
+    };
+
+    std::vector<Record> mRecords;
+    Record mDummy;
+    std::vector<char> mArena;           // zero terminated texts
+    std::vector<std::uint32_t> mSlots;  // open addressing: arena offset + 1 of the texts, while filling
+    std::uint32_t mUsedSlots;
+    bool mSorted;
+
+    const Record &At(std::uint32_t row) const { return (row == cDummyRow) ? mDummy : mRecords[row]; }
+    Record MakeRecord(const Player &player);
+    std::uint32_t Intern(const std::string &text);
+    void Grow();
+};
+
+#endif // PLAYER_STORE_H
+
+//=============================================================================
+// End of file PlayerStore.h
+//=============================================================================
@@ -0,0 +1,201 @@
+/*=============================================================================
+ * Tanca - Profiler.cpp
+ *=============================================================================
+ * Scoped timing of the hot paths, exported as a Chrome trace
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <atomic>
+#include <mutex>
+#include <map>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "Profiler.h"
+#include "Log.h"
+
+namespace
+{
+
+struct TraceEvent
+{
+    const char *stage;
+    std::uint64_t start;     // microseconds since the epoch of the session
+    std::uint64_t duration;  // microseconds
+    std::uint32_t thread;
+};
+
+std::atomic<bool> gEnabled(false);
+std::atomic<std::uint32_t> gThreadCounter(0U);
+std::mutex gMutex;
+std::vector<TraceEvent> gEvents;
+std::uint32_t gDropped = 0U;
+const Profiler::Clock::time_point gEpoch = Profiler::Clock::now();
+
+// Small and stable thread numbers, nicer in the trace viewer than native ids
+std::uint32_t ThreadNumber()
+{
+    thread_local std::uint32_t number = gThreadCounter.fetch_add(1U) + 1U;
+    return number;
+}
+
+std::uint64_t Microseconds(Profiler::Clock::duration d)
+{
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count());
+}
+
+// Nearest rank on a sorted list
+std::uint64_t Percentile(const std::vector<std::uint64_t> &sorted, std::uint32_t percent)
+{
+    std::size_t rank = (sorted.size() * percent + 99U) / 100U;
+    if (rank > 0U)
+    {
+        rank--;
+    }
+    return sorted[std::min(rank, sorted.size() - 1U)];
+}
+
+void WriteJsonString(std::FILE *f, const char *str)
+{
+    std::fputc('"', f);
+    for (; *str != '\0'; str++)
+    {
+        if ((*str == '"') || (*str == '\\'))
+        {
+            std::fputc('\\', f);
+        }
+        std::fputc(*str, f);
+    }
+    std::fputc('"', f);
+}
+
+} // namespace
+
+const std::uint32_t Profiler::cMaxEvents;
+
+void Profiler::SetEnabled(bool enable)
+{
+    gEnabled.store(enable, std::memory_order_relaxed);
+}
+
+bool Profiler::IsEnabled()
+{
+    return gEnabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::Clear()
+{
+    std::lock_guard<std::mutex> lock(gMutex);
+    gEvents.clear();
+    gDropped = 0U;
+}
+
+void Profiler::Record(const char *stage, Clock::time_point start, Clock::time_point end)
+{
+    TraceEvent event;
+    event.stage = stage;
+    event.start = Microseconds(start - gEpoch);
+    event.duration = Microseconds(end - start);
+    event.thread = ThreadNumber();
+
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (gEvents.size() < cMaxEvents)
+    {
+        gEvents.push_back(event);
+    }
+    else
+    {
+        gDropped++;
+    }
+}
+
+/**
+ * @brief Percentiles of the durations of each stage, sorted by stage name
+ */
+std::vector<Profiler::Stats> Profiler::GetStats()
+{
+    std::map<std::string, std::vector<std::uint64_t>> durations;
+
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        for (auto const &e : gEvents)
+        {
+            durations[e.stage].push_back(e.duration);
+        }
+    }
+
+    std::vector<Stats> stats;
+    for (auto &d : durations)
+    {
+        std::sort(d.second.begin(), d.second.end());
+
+        Stats s;
+        s.stage = d.first;
+        s.count = static_cast<std::uint32_t>(d.second.size());
+        s.p50 = Percentile(d.second, 50U);
+        s.p90 = Percentile(d.second, 90U);
+        s.p99 = Percentile(d.second, 99U);
+        s.max = d.second.back();
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+/**
+ * @brief Write the session in the Trace Event Format (chrome://tracing, Perfetto)
+ */
+bool Profiler::ExportChromeTrace(const std::string &fileName)
+{
+    std::FILE *f = std::fopen(fileName.c_str(), "wb");
+    if (f == nullptr)
+    {
+        TLogError("Cannot open trace file: " + fileName);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(gMutex);
+
+    std::fputs("{\"traceEvents\":[", f);
+    for (std::size_t i = 0U; i < gEvents.size(); i++)
+    {
+        const TraceEvent &e = gEvents[i];
+
+        std::fputs((i == 0U) ? "\n{\"name\":" : ",\n{\"name\":", f);
+        WriteJsonString(f, e.stage);
+        std::fprintf(f, ",\"cat\":\"tanca\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":1,\"tid\":%u}",
+                     static_cast<unsigned long long>(e.start),
+                     static_cast<unsigned long long>(e.duration),
+                     static_cast<unsigned int>(e.thread));
+    }
+    std::fprintf(f, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%u}}\n", static_cast<unsigned int>(gDropped));
+
+    bool success = (std::ferror(f) == 0);
+    if (std::fclose(f) != 0)
+    {
+        success = false;
+    }
+    return success;
+}
+
+//=============================================================================
+// End of file Profiler.cpp
+//=============================================================================
@@ -0,0 +1,106 @@
+/*=============================================================================
+ * Tanca - Profiler.h
+ *=============================================================================
+ * Scoped timing of the hot paths, exported as a Chrome trace
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Collects the duration of the traced scopes of the session
+ *
+ * Disabled by default: a disabled trace only costs a boolean test.
+ * The stage names must be string literals, they are stored as pointers.
+ */
+class Profiler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const std::uint32_t cMaxEvents = 200000U;
+
+    struct Stats
+    {
+        std::string stage;
+        std::uint32_t count;
+        // Durations in microseconds
+        std::uint64_t p50;
+        std::uint64_t p90;
+        std::uint64_t p99;
+        std::uint64_t max;
+    };
+
+    static void SetEnabled(bool enable);
+    static bool IsEnabled();
+    static void Clear();
+
+    static void Record(const char *stage, Clock::time_point start, Clock::time_point end);
+
+    static std::vector<Stats> GetStats();
+    static bool ExportChromeTrace(const std::string &fileName);
+};
+
+/**
+ * @brief Measures the time spent between its construction and its destruction
+ */
+class ScopedTrace
+{
+public:
+    explicit ScopedTrace(const char *stage)
+        : mStage(stage)
+        , mActive(Profiler::IsEnabled())
+    {
+        if (mActive)
+        {
+            mStart = Profiler::Clock::now();
+        }
+    }
+
+    ~ScopedTrace()
+    {
+        if (mActive)
+        {
+            Profiler::Record(mStage, mStart, Profiler::Clock::now());
+        }
+    }
+
+private:
+    const char *mStage;
+    bool mActive;
+    Profiler::Clock::time_point mStart;
+};
+
+#define TRACE_CONCAT2(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT2(a, b)
+#define TRACE_SCOPE(stage) ScopedTrace TRACE_CONCAT(trace_, __LINE__)(stage)
+
+#endif // PROFILER_H
+
+//=============================================================================
+// End of file Profiler.h
+//=============================================================================
@@ -0,0 +1,310 @@
+/*=============================================================================
+ * Tanca - Ratings.cpp
+ *=============================================================================
+ * Elo ratings of the players, across the seasons
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <future>
+#include <thread>
+
+#include "Ratings.h"
+#include "Profiler.h"
+
+const int RatingEngine::cKFactor;
+
+// Real players of a team, returns their number
+static std::uint32_t GetPlayers(const Team &team, int players[3])
+{
+    std::uint32_t count = 0U;
+    for (int id : { team.player1Id, team.player2Id, team.player3Id })
+    {
+        if ((id >= 0) && (id != Player::cDummyPlayer))
+        {
+            players[count++] = id;
+        }
+    }
+    return count;
+}
+
+static double TeamRating(const std::unordered_map<int, Rating> &ratings, const Team &team)
+{
+    int players[3];
+    std::uint32_t count = GetPlayers(team, players);
+    double sum = 0.0;
+
+    for (std::uint32_t i = 0U; i < count; i++)
+    {
+        auto it = ratings.find(players[i]);
+        sum += (it != ratings.end()) ? it->second.value : Rating().value;
+    }
+    return (count > 0U) ? (sum / count) : Rating().value;
+}
+
+static void AddDelta(std::unordered_map<int, Rating> &ratings, const Team &team, double delta, int games)
+{
+    int players[3];
+    std::uint32_t count = GetPlayers(team, players);
+
+    for (std::uint32_t i = 0U; i < count; i++)
+    {
+        Rating &r = ratings[players[i]];
+        r.playerId = players[i];
+        r.value += delta;
+        r.games += games;
+    }
+}
+
+// Union-find over the events, with path halving
+static std::uint32_t FindRoot(std::vector<std::uint32_t> &parent, std::uint32_t i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+/*****************************************************************************/
+RatingEngine::RatingEngine()
+{
+
+}
+
+void RatingEngine::Clear()
+{
+    mRatings.clear();
+}
+
+void RatingEngine::SetRatings(const std::deque<Rating> &ratings)
+{
+    mRatings.clear();
+    for (auto const &r : ratings)
+    {
+        mRatings[r.playerId] = r;
+    }
+}
+
+std::deque<Rating> RatingEngine::GetRatings() const
+{
+    std::deque<Rating> ratings;
+    for (auto const &r : mRatings)
+    {
+        ratings.push_back(r.second);
+    }
+    std::sort(ratings.begin(), ratings.end(), [](const Rating &a, const Rating &b) {
+        return a.value > b.value;
+    });
+    return ratings;
+}
+
+Rating RatingEngine::GetRating(int playerId) const
+{
+    auto it = mRatings.find(playerId);
+    Rating rating;
+    if (it != mRatings.end())
+    {
+        rating = it->second;
+    }
+    rating.playerId = playerId;
+    return rating;
+}
+
+double RatingEngine::GetTeamRating(const Team &team) const
+{
+    return TeamRating(mRatings, team);
+}
+
+std::deque<Rating> RatingEngine::GetRatings(const Team &team1, const Team &team2) const
+{
+    std::deque<Rating> ratings;
+    int players[3];
+
+    for (auto team : { &team1, &team2 })
+    {
+        std::uint32_t count = GetPlayers(*team, players);
+        for (std::uint32_t i = 0U; i < count; i++)
+        {
+            ratings.push_back(GetRating(players[i]));
+        }
+    }
+    return ratings;
+}
+
+bool RatingEngine::Apply(const Game &game, const Team &team1, const Team &team2, double &delta)
+{
+    return Apply(mRatings, game, team1, team2, delta);
+}
+
+void RatingEngine::Revert(const Team &team1, const Team &team2, double delta)
+{
+    AddDelta(mRatings, team1, -delta, -1);
+    AddDelta(mRatings, team2, delta, -1);
+}
+
+bool RatingEngine::Apply(std::unordered_map<int, Rating> &ratings, const Game &game, const Team &team1, const Team &team2, double &delta)
+{
+    if (!game.IsPlayed() || game.HasBye())
+    {
+        return false;
+    }
+
+    double expected = 1.0 / (1.0 + std::pow(10.0, (TeamRating(ratings, team2) - TeamRating(ratings, team1)) / 400.0));
+    double score = 0.5;
+    if (game.team1Score > game.team2Score)
+    {
+        score = 1.0;
+    }
+    else if (game.team1Score < game.team2Score)
+    {
+        score = 0.0;
+    }
+
+    delta = cKFactor * (score - expected);
+    AddDelta(ratings, team1, delta, 1);
+    AddDelta(ratings, team2, -delta, 1);
+    return true;
+}
+
+/**
+ * @brief Events of one chronology, in date order, then the games by turn
+ */
+void RatingEngine::Replay(const std::vector<RatedEvent *> &chronology, std::unordered_map<int, Rating> &ratings, std::deque<RatingDelta> &deltas)
+{
+    for (auto e : chronology)
+    {
+        IdIndex<Team> teamIds;
+        teamIds.Build(e->teams);
+
+        std::stable_sort(e->games.begin(), e->games.end(), [](const Game &a, const Game &b) {
+            return (a.turn < b.turn) || ((a.turn == b.turn) && (a.id < b.id));
+        });
+
+        for (auto const &game : e->games)
+        {
+            const Team *team1 = teamIds.Find(game.team1Id);
+            const Team *team2 = teamIds.Find(game.team2Id);
+            RatingDelta d;
+            d.gameId = game.id;
+
+            if ((team1 != nullptr) && (team2 != nullptr) && Apply(ratings, game, *team1, *team2, d.delta))
+            {
+                deltas.push_back(d);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Full replay of the history
+ *
+ * The events are grouped by players in common (union-find): the groups have
+ * distinct players so they are replayed concurrently, each one in its own
+ * chronological order.
+ */
+void RatingEngine::Recompute(std::vector<RatedEvent> &events, std::deque<RatingDelta> &deltas)
+{
+    TRACE_SCOPE("ratings.Recompute");
+    mRatings.clear();
+    deltas.clear();
+
+    std::sort(events.begin(), events.end(), [](const RatedEvent &a, const RatedEvent &b) {
+        return (a.event.date < b.event.date) || ((a.event.date == b.event.date) && (a.event.id < b.event.id));
+    });
+
+    std::vector<std::uint32_t> parent(events.size());
+    std::unordered_map<int, std::uint32_t> playerEvent; // player id -> one of its events
+    for (std::uint32_t i = 0U; i < events.size(); i++)
+    {
+        parent[i] = i;
+        for (auto const &team : events[i].teams)
+        {
+            int players[3];
+            std::uint32_t count = GetPlayers(team, players);
+            for (std::uint32_t p = 0U; p < count; p++)
+            {
+                auto it = playerEvent.find(players[p]);
+                if (it == playerEvent.end())
+                {
+                    playerEvent[players[p]] = i;
+                }
+                else
+                {
+                    parent[FindRoot(parent, i)] = FindRoot(parent, it->second);
+                }
+            }
+        }
+    }
+
+    // Chronologies, the events stay in date order
+    std::unordered_map<std::uint32_t, std::uint32_t> groupOfRoot;
+    std::vector<std::vector<RatedEvent *>> groups;
+    for (std::uint32_t i = 0U; i < events.size(); i++)
+    {
+        std::uint32_t root = FindRoot(parent, i);
+        auto it = groupOfRoot.find(root);
+        if (it == groupOfRoot.end())
+        {
+            it = groupOfRoot.emplace(root, static_cast<std::uint32_t>(groups.size())).first;
+            groups.emplace_back();
+        }
+        groups[it->second].push_back(&events[i]);
+    }
+
+    // Largest chronologies first, dealt to the workers
+    std::sort(groups.begin(), groups.end(), [](const std::vector<RatedEvent *> &a, const std::vector<RatedEvent *> &b) {
+        return a.size() > b.size();
+    });
+    std::uint32_t nbWorkers = std::max(1U, std::min(std::thread::hardware_concurrency(), static_cast<std::uint32_t>(groups.size())));
+
+    struct Result
+    {
+        std::unordered_map<int, Rating> ratings;
+        std::deque<RatingDelta> deltas;
+    };
+    std::vector<Result> results(nbWorkers);
+    std::vector<std::future<void>> tasks;
+
+    for (std::uint32_t w = 0U; w < nbWorkers; w++)
+    {
+        tasks.push_back(std::async(std::launch::async, [&groups, &results, w, nbWorkers]() {
+            for (std::uint32_t g = w; g < groups.size(); g += nbWorkers)
+            {
+                Replay(groups[g], results[w].ratings, results[w].deltas);
+            }
+        }));
+    }
+
+    for (std::uint32_t w = 0U; w < nbWorkers; w++)
+    {
+        tasks[w].get();
+        // Distinct players between the workers
+        mRatings.insert(results[w].ratings.begin(), results[w].ratings.end());
+        deltas.insert(deltas.end(), results[w].deltas.begin(), results[w].deltas.end());
+    }
+}
+
+//=============================================================================
+// End of file Ratings.cpp
+//=============================================================================
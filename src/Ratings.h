@@ -0,0 +1,115 @@
+/*=============================================================================
+ * Tanca - Ratings.h
+ *=============================================================================
+ * Elo ratings of the players, across the seasons
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef RATINGS_H
+#define RATINGS_H
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+#include "IDataBase.h"
+
+struct Rating
+{
+    int playerId;
+    double value;
+    int games;
+
+    Rating()
+        : playerId(-1)
+        , value(1500.0)
+        , games(0)
+    {
+
+    }
+};
+
+/**
+ * @brief Points won by the players of team 1 in a game (team 2 lost the same)
+ *
+ * Kept for each game, so that a corrected score can be taken back.
+ */
+struct RatingDelta
+{
+    int gameId;
+    double delta;
+};
+
+/**
+ * @brief Games of an event, for the full recompute
+ */
+struct RatedEvent
+{
+    Event event;
+    std::deque<Team> teams;
+    std::deque<Game> games;
+};
+
+/**
+ * @brief Elo rating of the players, the team rating is the mean of its players
+ *
+ * The rating is updated game after game: the winners take K x (1 - expected
+ * score) points to the losers. The full recompute replays the whole history;
+ * events that share no player (even through other events) are independent
+ * and are replayed at the same time.
+ */
+class RatingEngine
+{
+public:
+    static const int cKFactor = 32;
+
+    RatingEngine();
+
+    void Clear();
+    void SetRatings(const std::deque<Rating> &ratings);
+    std::deque<Rating> GetRatings() const;
+    Rating GetRating(int playerId) const;
+    double GetTeamRating(const Team &team) const;
+
+    // One committed game, returns false if it is not played (no delta)
+    bool Apply(const Game &game, const Team &team1, const Team &team2, double &delta);
+    // Take back the result of a game, before its score is changed
+    void Revert(const Team &team1, const Team &team2, double delta);
+
+    // Ratings of the players of the teams
+    std::deque<Rating> GetRatings(const Team &team1, const Team &team2) const;
+
+    // Replay all the games from the initial rating
+    void Recompute(std::vector<RatedEvent> &events, std::deque<RatingDelta> &deltas);
+
+private:
+    std::unordered_map<int, Rating> mRatings; // player id -> rating
+
+    static bool Apply(std::unordered_map<int, Rating> &ratings, const Game &game, const Team &team1, const Team &team2, double &delta);
+    static void Replay(const std::vector<RatedEvent *> &chronology, std::unordered_map<int, Rating> &ratings, std::deque<RatingDelta> &deltas);
+};
+
+#endif // RATINGS_H
+
+//=============================================================================
+// End of file Ratings.h
+//=============================================================================
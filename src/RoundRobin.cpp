@@ -0,0 +1,135 @@
+/*=============================================================================
+ * Tanca - RoundRobin.cpp
+ *=============================================================================
+ * Berger tables (circle method) computed on the fly
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <random>
+#include <algorithm>
+
+#include "RoundRobin.h"
+
+static const int cByeTeam = Team::cDummyTeam;
+
+RoundRobin::RoundRobin(std::uint32_t nbTeams)
+    : mTeams(nbTeams)
+    , mSlots(nbTeams + (nbTeams % 2U))
+{
+
+}
+
+/**
+ * @brief Teams of one game
+ *
+ * Circle method: the last slot is fixed, the others turn around it. In round
+ * r, game 0 opposes r to the fixed slot and game k opposes (r + k) to (r - k),
+ * modulo the number of turning slots.
+ *
+ * @param round: from 0, may be greater than a cycle (return legs)
+ * @param game: from 0 to GamesPerRound() - 1
+ */
+void RoundRobin::Pairing(std::uint32_t round, std::uint32_t game, std::uint32_t &home, std::uint32_t &away) const
+{
+    std::uint32_t turning = RoundsPerCycle();
+    std::uint32_t cycle = round / turning;
+    std::uint32_t r = round % turning;
+
+    if (game == 0U)
+    {
+        // The fixed slot alternates home and away
+        home = ((r % 2U) == 0U) ? r : (mSlots - 1U);
+        away = ((r % 2U) == 0U) ? (mSlots - 1U) : r;
+    }
+    else
+    {
+        std::uint32_t a = (r + game) % turning;
+        std::uint32_t b = (r + turning - game) % turning;
+
+        home = ((game % 2U) == 1U) ? a : b;
+        away = ((game % 2U) == 1U) ? b : a;
+    }
+
+    if ((cycle % 2U) == 1U)
+    {
+        std::swap(home, away);
+    }
+}
+
+/*****************************************************************************/
+RoundRobinStream::RoundRobinStream(const std::deque<Team> &teams, std::uint32_t firstRound, std::uint32_t nbRounds)
+    : mSchedule(static_cast<std::uint32_t>(teams.size()))
+    , mEventId((teams.size() > 0) ? teams.front().eventId : -1)
+    , mRound(firstRound)
+    , mEnd(firstRound + nbRounds)
+    , mIndex(0U)
+{
+    mIds.reserve(mSchedule.GetSlots());
+    for (auto const &t : teams)
+    {
+        mIds.push_back(t.id);
+    }
+
+    // Never start with the same team, but keep the same order for the whole
+    // event so that the rounds generated later continue the same schedule
+    std::mt19937 gen(static_cast<std::uint32_t>(mEventId));
+    std::shuffle(mIds.begin(), mIds.end(), gen);
+
+    if (mSchedule.GamesPerRound() == 0U)
+    {
+        mEnd = mRound; // Not enough teams, nothing to play
+    }
+}
+
+std::uint64_t RoundRobinStream::GetTotal() const
+{
+    return static_cast<std::uint64_t>(mEnd - mRound) * mSchedule.GamesPerRound();
+}
+
+Game *RoundRobinStream::Next()
+{
+    if (mRound >= mEnd)
+    {
+        return nullptr;
+    }
+
+    std::uint32_t home;
+    std::uint32_t away;
+    mSchedule.Pairing(mRound, mIndex, home, away);
+
+    mGame = Game();
+    mGame.eventId = mEventId;
+    mGame.turn = static_cast<int>(mRound);
+    mGame.team1Id = mSchedule.IsBye(home) ? cByeTeam : mIds[home];
+    mGame.team2Id = mSchedule.IsBye(away) ? cByeTeam : mIds[away];
+
+    mIndex++;
+    if (mIndex >= mSchedule.GamesPerRound())
+    {
+        mIndex = 0U;
+        mRound++;
+    }
+    return &mGame;
+}
+
+//=============================================================================
+// End of file RoundRobin.cpp
+//=============================================================================
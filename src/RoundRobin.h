@@ -0,0 +1,93 @@
+/*=============================================================================
+ * Tanca - RoundRobin.h
+ *=============================================================================
+ * Berger tables (circle method) computed on the fly
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef ROUND_ROBIN_H
+#define ROUND_ROBIN_H
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+
+#include "IDataBase.h"
+
+/**
+ * @brief Round-robin schedule of n teams, any game given by a formula
+ *
+ * Teams are numbered from 0 to n-1; an odd field gets an extra slot (index n)
+ * which means a bye. Each team meets all the others once per cycle of
+ * RoundsPerCycle() rounds. Home and away alternate as much as possible
+ * (each team is home at most once more than away). Rounds after the first
+ * cycle are return legs with home and away swapped.
+ */
+class RoundRobin
+{
+public:
+    explicit RoundRobin(std::uint32_t nbTeams);
+
+    std::uint32_t GetSlots() const { return mSlots; }
+    std::uint32_t RoundsPerCycle() const { return (mSlots > 1U) ? (mSlots - 1U) : 0U; }
+    std::uint32_t GamesPerRound() const { return mSlots / 2U; }
+
+    // True if the index is the bye slot of an odd field
+    bool IsBye(std::uint32_t team) const { return team >= mTeams; }
+
+    void Pairing(std::uint32_t round, std::uint32_t game, std::uint32_t &home, std::uint32_t &away) const;
+
+private:
+    std::uint32_t mTeams;
+    std::uint32_t mSlots; // even number of positions
+};
+
+/**
+ * @brief Produces the games of a round-robin schedule one by one
+ *
+ * Only one Game object is alive: it is reused for each call to Next(), so the
+ * games can be streamed into the database without building a list.
+ */
+class RoundRobinStream
+{
+public:
+    RoundRobinStream(const std::deque<Team> &teams, std::uint32_t firstRound, std::uint32_t nbRounds);
+
+    // Next game, or nullptr at the end of the requested rounds
+    Game *Next();
+
+    std::uint64_t GetTotal() const;
+
+private:
+    RoundRobin mSchedule;
+    std::vector<int> mIds; // Team ids in the schedule order
+    int mEventId;
+    std::uint32_t mRound;
+    std::uint32_t mEnd;
+    std::uint32_t mIndex;
+    Game mGame;
+};
+
+#endif // ROUND_ROBIN_H
+
+//=============================================================================
+// End of file RoundRobin.h
+//=============================================================================
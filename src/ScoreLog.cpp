@@ -0,0 +1,241 @@
+/*=============================================================================
+ * Tanca - ScoreLog.cpp
+ *=============================================================================
+ * Append-only log of the game changes, and the standings built from it
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+
+#include "ScoreLog.h"
+#include "Profiler.h"
+
+const int ScoreEntry::cAdded;
+const int ScoreEntry::cScored;
+const int ScoreEntry::cDeleted;
+
+/**
+ * @brief Walk back the log: undo entries hide the entry they took back
+ *
+ * Edits that do not change the score (teams of a bracket match) are skipped.
+ */
+bool ScoreEntry::FindUndo(const std::deque<ScoreEntry> &log, ScoreEntry &entry)
+{
+    std::unordered_set<std::int64_t> undone;
+    std::unordered_set<int> deleted;
+
+    for (auto it = log.rbegin(); it != log.rend(); ++it)
+    {
+        if (it->kind == cDeleted)
+        {
+            deleted.insert(it->gameId);
+        }
+        else if (it->undoOf > 0)
+        {
+            undone.insert(it->undoOf);
+        }
+        else if ((it->kind == cScored) && it->IsScoreChange() &&
+                 (undone.count(it->seq) == 0U) && (deleted.count(it->gameId) == 0U))
+        {
+            entry = *it;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*****************************************************************************/
+LiveStandings::LiveStandings()
+    : mCursor(0)
+    , mDirty(true)
+{
+
+}
+
+void LiveStandings::Reset(const std::deque<Team> &teams)
+{
+    mCursor = 0;
+    mTeams.clear();
+    for (auto const &team : teams)
+    {
+        mTeams.insert(team.id);
+    }
+    mGames.clear();
+    mCounted.clear();
+    mRanks.clear();
+    mRanking.clear();
+    mDirty = true;
+}
+
+void LiveStandings::Apply(const std::deque<ScoreEntry> &entries, std::int64_t lastSeq)
+{
+    TRACE_SCOPE("standings.Apply");
+    for (auto const &entry : entries)
+    {
+        if (entry.seq > lastSeq)
+        {
+            break;
+        }
+        Apply(entry);
+    }
+}
+
+void LiveStandings::Apply(const ScoreEntry &entry)
+{
+    if (entry.seq <= mCursor)
+    {
+        return; // Already applied
+    }
+    mCursor = entry.seq;
+
+    // Take back the previous result of the game
+    auto it = mCounted.find(entry.gameId);
+    if (it != mCounted.end())
+    {
+        Count(entry.gameId, it->second, -1);
+        mCounted.erase(it);
+    }
+
+    if (entry.kind == ScoreEntry::cDeleted)
+    {
+        mGames.erase(entry.gameId);
+    }
+    else
+    {
+        mGames.insert(entry.gameId);
+
+        Game game;
+        game.team1Id = entry.team1Id;
+        game.team2Id = entry.team2Id;
+        game.team1Score = entry.newScore1;
+        game.team2Score = entry.newScore2;
+
+        if (game.IsPlayed())
+        {
+            Counted counted = { entry.team1Id, entry.team2Id, entry.newScore1, entry.newScore2 };
+            Count(entry.gameId, counted, 1);
+            mCounted[entry.gameId] = counted;
+        }
+    }
+    mDirty = true;
+}
+
+// Same cases as Tournament::GenerateTeamRanking()
+void LiveStandings::Count(int gameId, const Counted &game, int sign)
+{
+    if ((game.team1Id == Team::cDummyTeam) || (game.team2Id == Team::cDummyTeam))
+    {
+        // The other team has a bye
+        if (game.team2Id == Team::cDummyTeam)
+        {
+            AddPoints(game.team1Id, gameId, game.score1, game.score2, sign);
+        }
+        else
+        {
+            AddPoints(game.team2Id, gameId, game.score2, game.score1, sign);
+        }
+    }
+    else
+    {
+        AddPoints(game.team1Id, gameId, game.score1, game.score2, sign);
+        AddPoints(game.team2Id, gameId, game.score2, game.score1, sign);
+    }
+}
+
+void LiveStandings::AddPoints(int teamId, int gameId, int score, int oppScore, int sign)
+{
+    if (mTeams.count(teamId) == 0U)
+    {
+        return;
+    }
+
+    if (sign > 0)
+    {
+        Rank &rank = mRanks[teamId];
+        rank.id = teamId;
+        rank.AddPoints(gameId, score, oppScore);
+        return;
+    }
+
+    auto it = mRanks.find(teamId);
+    if (it == mRanks.end())
+    {
+        return;
+    }
+
+    Rank &rank = it->second;
+    rank.pointsWon -= score;
+    rank.pointsLost -= oppScore;
+    if (oppScore > score)
+    {
+        rank.gamesLost--;
+    }
+    else if (score > oppScore)
+    {
+        rank.gamesWon--;
+    }
+    else
+    {
+        rank.gamesDraw--;
+    }
+
+    rank.mGames.erase(std::remove(rank.mGames.begin(), rank.mGames.end(), gameId), rank.mGames.end());
+    if (rank.mGames.empty())
+    {
+        // Not ranked without any game played, as in the full computation
+        mRanks.erase(it);
+    }
+}
+
+const std::deque<Rank> &LiveStandings::GetRanking()
+{
+    if (mDirty)
+    {
+        TRACE_SCOPE("standings.GetRanking");
+        std::unordered_map<int, int> buchholz;
+        for (auto const &c : mCounted)
+        {
+            const Counted &game = c.second;
+            auto rank1 = mRanks.find(game.team1Id);
+            auto rank2 = mRanks.find(game.team2Id);
+
+            if ((rank1 != mRanks.end()) && (rank2 != mRanks.end()))
+            {
+                buchholz[game.team1Id] += rank2->second.pointsWon;
+                buchholz[game.team2Id] += rank1->second.pointsWon;
+            }
+        }
+
+        mRanking.clear();
+        for (auto const &r : mRanks)
+        {
+            mRanking.push_back(r.second);
+            mRanking.back().pointsOpponents = buchholz[r.first];
+        }
+        std::sort(mRanking.begin(), mRanking.end(), RankHighFirst);
+        mDirty = false;
+    }
+    return mRanking;
+}
+
+//=============================================================================
+// End of file ScoreLog.cpp
+//=============================================================================
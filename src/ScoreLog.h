@@ -0,0 +1,147 @@
+/*=============================================================================
+ * Tanca - ScoreLog.h
+ *=============================================================================
+ * Append-only log of the game changes, and the standings built from it
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef SCORE_LOG_H
+#define SCORE_LOG_H
+
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "IDataBase.h"
+#include "Tournament.h"
+
+/**
+ * @brief One change of a game, as stored in the score log
+ *
+ * The entries are never modified: a correction or an undo is a new entry.
+ * The sequence number orders all the entries of the database.
+ *
+ * The standings (and their Buchholz points) are the consumers of the log.
+ * The ratings are not: an Elo change depends on the ratings of the moment,
+ * so taking back a score needs the delta applied then (rating_deltas), and a
+ * recompute follows the event dates, not the order of the entries. The
+ * network server does not either: it serves the current games of the event
+ * on request, not the changes.
+ */
+struct ScoreEntry
+{
+    static const int cAdded     = 0;   // Game created
+    static const int cScored    = 1;   // Game edited (the score most of the time)
+    static const int cDeleted   = 2;   // Game removed
+
+    std::int64_t seq;
+    int eventId;
+    int gameId;
+    int kind;
+    int turn;
+    int team1Id;
+    int team2Id;
+    int oldScore1;      // before the change, -1 for a new game
+    int oldScore2;
+    int newScore1;      // after the change
+    int newScore2;
+    std::int64_t undoOf; // entry taken back by this one, 0 if none
+
+    ScoreEntry()
+        : seq(0)
+        , eventId(-1)
+        , gameId(-1)
+        , kind(cScored)
+        , turn(0)
+        , team1Id(-1)
+        , team2Id(-1)
+        , oldScore1(-1)
+        , oldScore2(-1)
+        , newScore1(-1)
+        , newScore2(-1)
+        , undoOf(0)
+    {
+
+    }
+
+    bool IsScoreChange() const
+    {
+        return (oldScore1 != newScore1) || (oldScore2 != newScore2);
+    }
+
+    // Last score change of the log that can be taken back (not undone yet, game still there)
+    static bool FindUndo(const std::deque<ScoreEntry> &log, ScoreEntry &entry);
+};
+
+/**
+ * @brief Team ranking of an event, updated entry after entry
+ *
+ * The consumer keeps the sequence number of the last entry applied (its
+ * cursor) and is only given the newer entries. A changed game first takes
+ * back the result it had, so the cost of a score entry does not depend on
+ * the number of games. The rules are those of
+ * Tournament::GenerateTeamRanking() over all the rounds; the Buchholz points
+ * and the order are computed when the ranking is read.
+ */
+class LiveStandings
+{
+public:
+    LiveStandings();
+
+    // Back to an empty event, the whole log must be applied again
+    void Reset(const std::deque<Team> &teams);
+
+    std::int64_t GetCursor() const { return mCursor; }
+    std::uint32_t GetGameCount() const { return static_cast<std::uint32_t>(mGames.size()); }
+
+    // Entries older than the cursor are ignored, and the ones after lastSeq (history replay)
+    void Apply(const std::deque<ScoreEntry> &entries, std::int64_t lastSeq = INT64_MAX);
+    void Apply(const ScoreEntry &entry);
+
+    const std::deque<Rank> &GetRanking();
+
+private:
+    struct Counted
+    {
+        int team1Id;
+        int team2Id;
+        int score1;
+        int score2;
+    };
+
+    std::int64_t mCursor;
+    std::unordered_set<int> mTeams;
+    std::unordered_set<int> mGames;                 // Games of the event
+    std::unordered_map<int, Counted> mCounted;      // Played games, as counted in the ranks
+    std::unordered_map<int, Rank> mRanks;           // team id -> rank
+    std::deque<Rank> mRanking;
+    bool mDirty;
+
+    void Count(int gameId, const Counted &game, int sign);
+    void AddPoints(int teamId, int gameId, int score, int oppScore, int sign);
+};
+
+#endif // SCORE_LOG_H
+
+//=============================================================================
+// End of file ScoreLog.h
+//=============================================================================
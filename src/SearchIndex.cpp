@@ -0,0 +1,387 @@
+/*=============================================================================
+ * Tanca - SearchIndex.cpp
+ *=============================================================================
+ * Incremental trigram index used to filter players and teams as the user types
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include "SearchIndex.h"
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+// Folded form of the Latin-1 supplement block (U+00C0 to U+00FF)
+static const char *gLatin1Fold[64] = {
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", "x", "o", "u", "u", "u", "u", "y", "th", "ss",
+    "a", "a", "a", "a", "a", "a", "ae", "c", "e", "e", "e", "e", "i", "i", "i", "i",
+    "d", "n", "o", "o", "o", "o", "o", "", "o", "u", "u", "u", "u", "y", "th", "y"
+};
+
+static inline std::uint32_t Trigram(const char *text, std::size_t pos)
+{
+    return (static_cast<std::uint8_t>(text[pos]) << 16) |
+           (static_cast<std::uint8_t>(text[pos + 1]) << 8) |
+            static_cast<std::uint8_t>(text[pos + 2]);
+}
+
+SearchIndex::SearchIndex()
+{
+
+}
+
+void SearchIndex::Clear()
+{
+    mEntries.clear();
+    mText.clear();
+    mTrigrams.clear();
+    mIds.clear();
+    mLastQuery.clear();
+    mLastMatches.clear();
+    mResult.clear();
+}
+
+/**
+ * @brief Lower case the text and remove the accents of UTF-8 latin characters
+ */
+std::string SearchIndex::Fold(const std::string &text)
+{
+    // The folded form is never longer than the UTF-8 text
+    std::string folded(text.size(), '\0');
+    folded.resize(Fold(text, &folded[0], folded.size()));
+    return folded;
+}
+
+/**
+ * @brief Same folding into a buffer, without allocation
+ * @return the length of the folded text, truncated to the size of the buffer
+ */
+std::size_t SearchIndex::Fold(const std::string &text, char *buffer, std::size_t size)
+{
+    std::size_t length = 0U;
+
+    for (std::size_t i = 0; (i < text.size()) && (length < size); i++)
+    {
+        std::uint8_t c = static_cast<std::uint8_t>(text[i]);
+        const char *replacement = nullptr;
+
+        if (c < 0x80U)
+        {
+            buffer[length++] = static_cast<char>(std::tolower(c));
+        }
+        else if ((c == 0xC3U) && ((i + 1) < text.size()) &&
+                 (static_cast<std::uint8_t>(text[i + 1]) >= 0x80U) && (static_cast<std::uint8_t>(text[i + 1]) <= 0xBFU))
+        {
+            replacement = gLatin1Fold[static_cast<std::uint8_t>(text[i + 1]) - 0x80U];
+            i++;
+        }
+        else if ((c == 0xC5U) && ((i + 1) < text.size()) &&
+                 ((static_cast<std::uint8_t>(text[i + 1]) == 0x92U) || (static_cast<std::uint8_t>(text[i + 1]) == 0x93U)))
+        {
+            // Œ and œ ligatures
+            replacement = "oe";
+            i++;
+        }
+        else
+        {
+            buffer[length++] = text[i];
+        }
+
+        for (; (replacement != nullptr) && (*replacement != '\0') && (length < size); replacement++)
+        {
+            buffer[length++] = *replacement;
+        }
+    }
+    return length;
+}
+
+void SearchIndex::Append(Postings &list, std::uint32_t entry)
+{
+    if ((list.count > 0U) && (entry == list.last))
+    {
+        // Several fields of the entry have this trigram
+        return;
+    }
+    if ((list.count > 0U) && (entry < list.last))
+    {
+        // Entries are mostly added in order, otherwise the list is encoded again
+        std::vector<std::uint32_t> entries;
+        Decode(list, entries);
+        std::vector<std::uint32_t>::iterator it = std::lower_bound(entries.begin(), entries.end(), entry);
+        if ((it != entries.end()) && (*it == entry))
+        {
+            return;
+        }
+        entries.insert(it, entry);
+
+        list.bytes.clear();
+        list.count = 0U;
+        list.last = 0U;
+        for (auto e : entries)
+        {
+            Append(list, e);
+        }
+        return;
+    }
+
+    std::uint32_t delta = entry - list.last;
+    while (delta >= 0x80U)
+    {
+        list.bytes.push_back(static_cast<std::uint8_t>(delta | 0x80U));
+        delta >>= 7;
+    }
+    list.bytes.push_back(static_cast<std::uint8_t>(delta));
+    list.count++;
+    list.last = entry;
+}
+
+void SearchIndex::Decode(const Postings &list, std::vector<std::uint32_t> &out)
+{
+    std::uint32_t entry = 0U;
+    std::uint32_t delta = 0U;
+    unsigned int shift = 0U;
+
+    out.clear();
+    out.reserve(list.count);
+    for (auto b : list.bytes)
+    {
+        delta |= static_cast<std::uint32_t>(b & 0x7FU) << shift;
+        if ((b & 0x80U) != 0U)
+        {
+            shift += 7U;
+        }
+        else
+        {
+            entry += delta;
+            out.push_back(entry);
+            delta = 0U;
+            shift = 0U;
+        }
+    }
+}
+
+void SearchIndex::Index(std::uint32_t entry, const char *folded, std::size_t size)
+{
+    for (std::size_t i = 0; (i + 3) <= size; i++)
+    {
+        Append(mTrigrams[Trigram(folded, i)], entry);
+    }
+}
+
+void SearchIndex::Add(int id, const std::string &text)
+{
+    std::string folded = Fold(text);
+
+    // Ids mostly come in order, so the insertion is at the end
+    std::vector<std::pair<int, std::uint32_t>>::iterator it = std::lower_bound(mIds.begin(), mIds.end(), std::make_pair(id, 0U));
+    std::uint32_t entry;
+
+    if ((it == mIds.end()) || (it->first != id))
+    {
+        entry = static_cast<std::uint32_t>(mEntries.size());
+        Entry e;
+        e.id = id;
+        e.offset = static_cast<std::uint32_t>(mText.size());
+        e.length = 0U;
+        mEntries.push_back(e);
+        mIds.insert(it, std::make_pair(id, entry));
+    }
+    else
+    {
+        entry = it->second;
+        Entry &e = mEntries[entry];
+
+        if ((e.offset + e.length) != mText.size())
+        {
+            // Another entry follows: move the text at the end, the old copy is lost until Clear()
+            std::vector<char> previous(mText.begin() + e.offset, mText.begin() + e.offset + e.length);
+            e.offset = static_cast<std::uint32_t>(mText.size());
+            mText.insert(mText.end(), previous.begin(), previous.end());
+        }
+
+        // Fields are separated so that a trigram never spans two of them
+        mText.push_back('\n');
+        e.length++;
+    }
+
+    mText.insert(mText.end(), folded.begin(), folded.end());
+    mEntries[entry].length += static_cast<std::uint32_t>(folded.size());
+    Index(entry, folded.data(), folded.size());
+
+    // Any previous result is now obsolete
+    mLastQuery.clear();
+}
+
+void SearchIndex::Finish()
+{
+    mEntries.shrink_to_fit();
+    mText.shrink_to_fit();
+    mIds.shrink_to_fit();
+    for (auto &t : mTrigrams)
+    {
+        t.second.bytes.shrink_to_fit();
+    }
+}
+
+std::size_t SearchIndex::MemoryUsage() const
+{
+    std::size_t size = (mEntries.capacity() * sizeof(Entry)) + mText.capacity() +
+                       (mIds.capacity() * sizeof(std::pair<int, std::uint32_t>)) +
+                       (mTrigrams.bucket_count() * sizeof(void *));
+
+    for (auto const &t : mTrigrams)
+    {
+        size += sizeof(t) + sizeof(void *) + t.second.bytes.capacity();
+    }
+    return size;
+}
+
+void SearchIndex::Build(const std::deque<Player> &players)
+{
+    Clear();
+
+    for (auto const &p : players)
+    {
+        Add(p);
+    }
+    Finish();
+}
+
+void SearchIndex::Add(const Player &p)
+{
+    // The visible columns of the table, except the UUID, the dates, the state and the document
+    Add(p.id, std::to_string(p.id));
+    Add(p.id, p.name);
+    Add(p.id, p.lastName);
+    Add(p.id, p.nickName);
+    Add(p.id, p.email);
+    Add(p.id, p.road);
+    if (p.postCode >= 0)
+    {
+        Add(p.id, std::to_string(p.postCode));
+    }
+    Add(p.id, p.city);
+    Add(p.id, p.membership);
+    Add(p.id, p.comments);
+
+    // Phones are also indexed without separators (06 12 34 ... / 06.12.34...)
+    for (auto const &phone : { p.mobilePhone, p.homePhone })
+    {
+        std::string digits;
+        for (auto c : phone)
+        {
+            if (std::isdigit(static_cast<unsigned char>(c)))
+            {
+                digits.push_back(c);
+            }
+        }
+        Add(p.id, phone);
+        if (digits != phone)
+        {
+            Add(p.id, digits);
+        }
+    }
+}
+
+void SearchIndex::Candidates(const std::string &query, std::vector<std::uint32_t> &out) const
+{
+    out.clear();
+
+    if (query.size() < 3)
+    {
+        // Too short to use the trigrams, every entry is a candidate
+        for (std::uint32_t i = 0; i < mEntries.size(); i++)
+        {
+            out.push_back(i);
+        }
+        return;
+    }
+
+    // Collect the posting lists of the query, smallest first
+    std::vector<const Postings *> lists;
+    for (std::size_t i = 0; (i + 3) <= query.size(); i++)
+    {
+        auto it = mTrigrams.find(Trigram(query.data(), i));
+        if (it == mTrigrams.end())
+        {
+            // This trigram does not exist anywhere: no match at all
+            return;
+        }
+        lists.push_back(&it->second);
+    }
+
+    std::sort(lists.begin(), lists.end(), [](const Postings *a, const Postings *b) {
+        return a->count < b->count;
+    });
+
+    Decode(*lists[0], out);
+    std::vector<std::uint32_t> list;
+    for (std::size_t i = 1; (i < lists.size()) && (out.size() > 0); i++)
+    {
+        std::vector<std::uint32_t> inter;
+        Decode(*lists[i], list);
+        std::set_intersection(out.begin(), out.end(), list.begin(), list.end(), std::back_inserter(inter));
+        out.swap(inter);
+    }
+}
+
+/**
+ * @brief Find all the entries containing the query
+ * @param query
+ * @return the set of matching ids
+ */
+const std::unordered_set<int> &SearchIndex::Find(const std::string &query)
+{
+    std::string folded = Fold(query);
+    std::vector<std::uint32_t> candidates;
+
+    if ((mLastQuery.size() > 0) && (folded.find(mLastQuery) != std::string::npos))
+    {
+        // The query extends the previous one, only the previous matches may still match
+        candidates.swap(mLastMatches);
+    }
+    else
+    {
+        Candidates(folded, candidates);
+    }
+
+    mLastMatches.clear();
+    mResult.clear();
+
+    for (auto entry : candidates)
+    {
+        const Entry &e = mEntries[entry];
+        const char *begin = mText.data() + e.offset;
+        const char *end = begin + e.length;
+        if (folded.empty() || (std::search(begin, end, folded.begin(), folded.end()) != end))
+        {
+            mLastMatches.push_back(entry);
+            mResult.insert(e.id);
+        }
+    }
+
+    mLastQuery = folded;
+    return mResult;
+}
+
+//=============================================================================
+// End of file SearchIndex.cpp
+//=============================================================================
@@ -0,0 +1,113 @@
+/*=============================================================================
+ * Tanca - SearchIndex.h
+ *=============================================================================
+ * Incremental trigram index used to filter players and teams as the user types
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "IDataBase.h"
+
+/**
+ * @brief Case and accent insensitive substring search over a list of entries
+ *
+ * Each entry is an id associated with one or more text fields. All the texts
+ * are folded (lower case, no accents) and split in trigrams; a query is resolved
+ * by intersecting the trigram lists, then checked against the folded text.
+ *
+ * The folded texts are kept end to end in one buffer and the trigram lists are
+ * delta encoded (one byte per entry for the frequent trigrams), so the index of
+ * a large base stays a few hundred bytes per entry.
+ *
+ * When the new query extends the previous one (the user is typing), only the
+ * previous result set is filtered.
+ */
+class SearchIndex
+{
+public:
+    SearchIndex();
+
+    void Clear();
+    void Add(int id, const std::string &text);
+    void Add(const Player &player);
+    void Build(const std::deque<Player> &players);
+    // Release the spare capacity once the entries are added
+    void Finish();
+
+    const std::unordered_set<int> &Find(const std::string &query);
+    bool IsEmpty() const { return mEntries.size() == 0; }
+    std::size_t MemoryUsage() const;
+
+    static std::string Fold(const std::string &text);
+    static std::size_t Fold(const std::string &text, char *buffer, std::size_t size);
+
+private:
+    struct Entry
+    {
+        int id;
+        std::uint32_t offset; // folded text in mText
+        std::uint32_t length;
+    };
+
+    // Sorted entry indexes, as the differences to the previous one (LEB128)
+    struct Postings
+    {
+        std::vector<std::uint8_t> bytes;
+        std::uint32_t count;
+        std::uint32_t last;
+
+        Postings()
+            : count(0U)
+            , last(0U)
+        {
+        }
+    };
+
+    std::vector<Entry> mEntries;
+    std::vector<char> mText; // folded texts of the entries, fields separated by '\n'
+    std::unordered_map<std::uint32_t, Postings> mTrigrams; // trigram -> entry indexes
+    std::vector<std::pair<int, std::uint32_t>> mIds; // entry id -> entry index, sorted by id
+
+    // Last query context, reused when the query is extended
+    std::string mLastQuery;
+    std::vector<std::uint32_t> mLastMatches;
+    std::unordered_set<int> mResult;
+
+    void Index(std::uint32_t entry, const char *folded, std::size_t size);
+    void Candidates(const std::string &query, std::vector<std::uint32_t> &out) const;
+    static void Append(Postings &list, std::uint32_t entry);
+    static void Decode(const Postings &list, std::vector<std::uint32_t> &out);
+};
+
+#endif // SEARCH_INDEX_H
+
+//=============================================================================
+// End of file SearchIndex.h
+//=============================================================================
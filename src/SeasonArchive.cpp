@@ -0,0 +1,586 @@
+/*=============================================================================
+ * Tanca - SeasonArchive.cpp
+ *=============================================================================
+ * Read-only columnar file of a closed season
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+#include <QSaveFile>
+
+#include "SeasonArchive.h"
+#include "AsyncLog.h"
+#include "Profiler.h"
+
+static const char cMagic[4] = { 'T', 'C', 'A', 'R' };
+static const std::uint32_t cFormatVersion = 1U;
+static const std::uint32_t cByteOrder = 0x01020304U;
+
+struct SeasonArchive::Header
+{
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t byteOrder;
+    std::int32_t year;
+    std::uint32_t events;
+    std::uint32_t teams;
+    std::uint32_t games;
+    std::uint32_t strings;
+    std::uint64_t offsets[cColumnCount]; // from the beginning of the file, aligned on 8 bytes
+    std::uint64_t sizes[cColumnCount];   // in bytes
+};
+
+/**
+ * @brief Columns being written, and the string dictionary
+ */
+class ArchiveBuilder
+{
+public:
+    ArchiveBuilder()
+        : mColumns(SeasonArchive::cColumnCount)
+    {
+        AddString(""); // index 0
+    }
+
+    template <typename T>
+    void Add(SeasonArchive::Column column, T value)
+    {
+        std::vector<std::uint8_t> &data = mColumns[column];
+        std::size_t size = data.size();
+        data.resize(size + sizeof(T));
+        std::memcpy(&data[size], &value, sizeof(T));
+    }
+
+    void AddText(SeasonArchive::Column column, const std::string &text)
+    {
+        Add<std::uint32_t>(column, AddString(text));
+    }
+
+    std::uint32_t StringCount() const { return static_cast<std::uint32_t>(mStrings.size()); }
+    const std::vector<std::uint8_t> &GetColumn(std::uint32_t column) const { return mColumns[column]; }
+
+    void FinishStrings()
+    {
+        std::uint32_t offset = 0U;
+        for (auto const &s : mStrings)
+        {
+            Add<std::uint32_t>(SeasonArchive::cStringOffset, offset);
+            offset += static_cast<std::uint32_t>(s->size());
+            mColumns[SeasonArchive::cStringData].insert(mColumns[SeasonArchive::cStringData].end(), s->begin(), s->end());
+        }
+        Add<std::uint32_t>(SeasonArchive::cStringOffset, offset);
+    }
+
+private:
+    std::vector<std::vector<std::uint8_t>> mColumns;
+    std::unordered_map<std::string, std::uint32_t> mDictionary;
+    std::vector<const std::string *> mStrings; // keys of the dictionary, by index
+
+    std::uint32_t AddString(const std::string &text)
+    {
+        auto it = mDictionary.find(text);
+        if (it == mDictionary.end())
+        {
+            it = mDictionary.emplace(text, static_cast<std::uint32_t>(mStrings.size())).first;
+            mStrings.push_back(&it->first);
+        }
+        return it->second;
+    }
+};
+
+/*****************************************************************************/
+SeasonArchive::SeasonArchive()
+    : mBase(nullptr)
+    , mHeader(nullptr)
+{
+
+}
+
+SeasonArchive::~SeasonArchive()
+{
+    Close();
+}
+
+bool SeasonArchive::Write(const QString &fileName, int year, std::deque<Event> events, std::deque<Team> teams, std::deque<Game> games)
+{
+    TRACE_SCOPE("archive.Write");
+
+    std::sort(events.begin(), events.end(), [](const Event &a, const Event &b) {
+        return a.id < b.id;
+    });
+    std::sort(teams.begin(), teams.end(), [](const Team &a, const Team &b) {
+        return (a.eventId < b.eventId) || ((a.eventId == b.eventId) && (a.id < b.id));
+    });
+    std::sort(games.begin(), games.end(), [](const Game &a, const Game &b) {
+        return (a.eventId < b.eventId) ||
+               ((a.eventId == b.eventId) && ((a.turn < b.turn) || ((a.turn == b.turn) && (a.id < b.id))));
+    });
+
+    ArchiveBuilder builder;
+    std::unordered_map<int, std::uint32_t> teamRows;
+
+    for (auto const &e : events)
+    {
+        builder.Add<std::int32_t>(cEventId, e.id);
+        builder.Add<std::int64_t>(cEventDate, std::chrono::duration_cast<std::chrono::seconds>(e.date.time_since_epoch()).count());
+        builder.Add<std::int32_t>(cEventType, e.type);
+        builder.Add<std::int32_t>(cEventState, e.state);
+        builder.Add<std::int32_t>(cEventOption, e.option);
+        builder.AddText(cEventTitle, e.title);
+        builder.AddText(cEventDocument, e.document);
+    }
+
+    for (auto const &t : teams)
+    {
+        teamRows[t.id] = static_cast<std::uint32_t>(teamRows.size());
+        builder.Add<std::int32_t>(cTeamId, t.id);
+        builder.Add<std::int32_t>(cTeamEvent, t.eventId);
+        builder.Add<std::int32_t>(cTeamNumber, t.number);
+        builder.Add<std::int32_t>(cTeamPlayer1, t.player1Id);
+        builder.Add<std::int32_t>(cTeamPlayer2, t.player2Id);
+        builder.Add<std::int32_t>(cTeamPlayer3, t.player3Id);
+        builder.Add<std::int32_t>(cTeamState, t.state);
+        builder.AddText(cTeamName, t.teamName);
+        builder.AddText(cTeamDocument, t.document);
+    }
+
+    for (auto const &g : games)
+    {
+        std::uint32_t team[2];
+        int ids[2] = { g.team1Id, g.team2Id };
+        for (std::uint32_t i = 0U; i < 2U; i++)
+        {
+            auto it = teamRows.find(ids[i]);
+            if (ids[i] == Team::cDummyTeam)
+            {
+                team[i] = EventSnapshot::cDummy;
+            }
+            else
+            {
+                team[i] = (it != teamRows.end()) ? it->second : EventSnapshot::cNone;
+            }
+        }
+
+        builder.Add<std::int32_t>(cGameId, g.id);
+        builder.Add<std::int32_t>(cGameEvent, g.eventId);
+        builder.Add<std::int32_t>(cGameTurn, g.turn);
+        builder.Add<std::uint32_t>(cGameTeam1, team[0]);
+        builder.Add<std::uint32_t>(cGameTeam2, team[1]);
+        builder.Add<std::int32_t>(cGameScore1, g.team1Score);
+        builder.Add<std::int32_t>(cGameScore2, g.team2Score);
+        builder.Add<std::int32_t>(cGameState, g.state);
+        builder.AddText(cGameDocument, g.document);
+    }
+    builder.FinishStrings();
+
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, cMagic, sizeof(cMagic));
+    header.version = cFormatVersion;
+    header.byteOrder = cByteOrder;
+    header.year = year;
+    header.events = static_cast<std::uint32_t>(events.size());
+    header.teams = static_cast<std::uint32_t>(teams.size());
+    header.games = static_cast<std::uint32_t>(games.size());
+    header.strings = builder.StringCount();
+
+    std::uint64_t offset = sizeof(Header);
+    for (std::uint32_t c = 0U; c < cColumnCount; c++)
+    {
+        offset = (offset + 7U) & ~static_cast<std::uint64_t>(7U);
+        header.offsets[c] = offset;
+        header.sizes[c] = builder.GetColumn(c).size();
+        offset += header.sizes[c];
+    }
+
+    // Written aside then renamed: an archive is complete or absent
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        ALogError("Cannot create archive " << fileName.toStdString());
+        return false;
+    }
+
+    static const char cPadding[8] = { 0 };
+    std::uint64_t position = sizeof(Header);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+    for (std::uint32_t c = 0U; c < cColumnCount; c++)
+    {
+        file.write(cPadding, static_cast<qint64>(header.offsets[c] - position));
+        const std::vector<std::uint8_t> &data = builder.GetColumn(c);
+        if (data.size() > 0U)
+        {
+            file.write(reinterpret_cast<const char *>(data.data()), static_cast<qint64>(data.size()));
+        }
+        position = header.offsets[c] + header.sizes[c];
+    }
+    return file.commit();
+}
+
+bool SeasonArchive::Open(const QString &fileName)
+{
+    TRACE_SCOPE("archive.Open");
+    Close();
+
+    mFile.setFileName(fileName);
+    if (!mFile.open(QIODevice::ReadOnly) || (mFile.size() < static_cast<qint64>(sizeof(Header))))
+    {
+        ALogError("Cannot open archive " << fileName.toStdString());
+        Close();
+        return false;
+    }
+
+    std::uint64_t fileSize = static_cast<std::uint64_t>(mFile.size());
+    const std::uint8_t *base = mFile.map(0, mFile.size());
+    const Header *header = reinterpret_cast<const Header *>(base);
+    bool valid = (base != nullptr) &&
+                 (std::memcmp(header->magic, cMagic, sizeof(cMagic)) == 0) &&
+                 (header->version == cFormatVersion) &&
+                 (header->byteOrder == cByteOrder);
+
+    // Every column must fit in the file, with the size given by its number of rows
+    // (computed on 64 bits: the counts come from the file)
+    for (std::uint32_t c = 0U; valid && (c < cColumnCount); c++)
+    {
+        std::uint64_t expected = header->sizes[c];
+        if (c <= cEventDocument)
+        {
+            expected = static_cast<std::uint64_t>(header->events) * ((c == cEventDate) ? 8U : 4U);
+        }
+        else if (c <= cTeamDocument)
+        {
+            expected = static_cast<std::uint64_t>(header->teams) * 4U;
+        }
+        else if (c <= cGameDocument)
+        {
+            expected = static_cast<std::uint64_t>(header->games) * 4U;
+        }
+        else if (c == cStringOffset)
+        {
+            expected = (static_cast<std::uint64_t>(header->strings) + 1U) * 4U;
+        }
+
+        valid = (header->sizes[c] == expected) && ((header->offsets[c] % 8U) == 0U) &&
+                (header->offsets[c] <= fileSize) && (header->sizes[c] <= (fileSize - header->offsets[c]));
+    }
+
+    // Once when opened, the reads then trust the file: strings in the data block,
+    // and games referring to the teams of the archive
+    if (valid)
+    {
+        const std::uint32_t *offsets = reinterpret_cast<const std::uint32_t *>(base + header->offsets[cStringOffset]);
+        valid = (offsets[header->strings] == header->sizes[cStringData]);
+        for (std::uint32_t i = 0U; valid && (i < header->strings); i++)
+        {
+            valid = (offsets[i] <= offsets[i + 1U]);
+        }
+
+        for (Column c : { cGameTeam1, cGameTeam2 })
+        {
+            const std::uint32_t *teams = reinterpret_cast<const std::uint32_t *>(base + header->offsets[c]);
+            for (std::uint32_t i = 0U; valid && (i < header->games); i++)
+            {
+                valid = (teams[i] < header->teams) || (teams[i] == EventSnapshot::cDummy) || (teams[i] == EventSnapshot::cNone);
+            }
+        }
+    }
+
+    if (!valid)
+    {
+        ALogError("Invalid archive " << fileName.toStdString());
+        Close();
+        return false;
+    }
+
+    mBase = base;
+    mHeader = header;
+    return true;
+}
+
+void SeasonArchive::Close()
+{
+    if (mFile.isOpen())
+    {
+        mFile.close(); // also unmaps
+    }
+    mBase = nullptr;
+    mHeader = nullptr;
+}
+
+int SeasonArchive::GetYear() const
+{
+    return mHeader->year;
+}
+
+std::uint32_t SeasonArchive::EventCount() const
+{
+    return mHeader->events;
+}
+
+std::uint32_t SeasonArchive::TeamCount() const
+{
+    return mHeader->teams;
+}
+
+std::uint32_t SeasonArchive::GameCount() const
+{
+    return mHeader->games;
+}
+
+const std::int32_t *SeasonArchive::Int(Column column) const
+{
+    return reinterpret_cast<const std::int32_t *>(mBase + mHeader->offsets[column]);
+}
+
+const std::int64_t *SeasonArchive::Dates() const
+{
+    return reinterpret_cast<const std::int64_t *>(mBase + mHeader->offsets[cEventDate]);
+}
+
+std::string SeasonArchive::GetString(std::uint32_t index) const
+{
+    std::string text;
+    if (index < mHeader->strings)
+    {
+        const std::uint32_t *offsets = reinterpret_cast<const std::uint32_t *>(Int(cStringOffset));
+        const char *data = reinterpret_cast<const char *>(mBase + mHeader->offsets[cStringData]);
+        if (offsets[index] <= offsets[index + 1U])
+        {
+            text.assign(data + offsets[index], offsets[index + 1U] - offsets[index]);
+        }
+    }
+    return text;
+}
+
+/**
+ * @brief Rows [first, last[ where a sorted column is equal to the value
+ */
+void SeasonArchive::FindRange(Column column, std::uint32_t count, int value, std::uint32_t &first, std::uint32_t &last) const
+{
+    const std::int32_t *begin = Int(column);
+    auto range = std::equal_range(begin, begin + count, value);
+    first = static_cast<std::uint32_t>(range.first - begin);
+    last = static_cast<std::uint32_t>(range.second - begin);
+}
+
+Event SeasonArchive::MakeEvent(std::uint32_t row) const
+{
+    Event event;
+    event.id = Int(cEventId)[row];
+    event.year = mHeader->year;
+    event.date = std::chrono::system_clock::time_point(std::chrono::seconds(Dates()[row]));
+    event.type = Int(cEventType)[row];
+    event.state = Int(cEventState)[row];
+    event.option = Int(cEventOption)[row];
+    event.title = GetString(static_cast<std::uint32_t>(Int(cEventTitle)[row]));
+    event.document = GetString(static_cast<std::uint32_t>(Int(cEventDocument)[row]));
+    return event;
+}
+
+Team SeasonArchive::MakeTeam(std::uint32_t row) const
+{
+    Team team;
+    team.id = Int(cTeamId)[row];
+    team.eventId = Int(cTeamEvent)[row];
+    team.number = Int(cTeamNumber)[row];
+    team.player1Id = Int(cTeamPlayer1)[row];
+    team.player2Id = Int(cTeamPlayer2)[row];
+    team.player3Id = Int(cTeamPlayer3)[row];
+    team.state = Int(cTeamState)[row];
+    team.teamName = GetString(static_cast<std::uint32_t>(Int(cTeamName)[row]));
+    team.document = GetString(static_cast<std::uint32_t>(Int(cTeamDocument)[row]));
+    return team;
+}
+
+Game SeasonArchive::MakeGame(std::uint32_t row) const
+{
+    const std::uint32_t *team1 = reinterpret_cast<const std::uint32_t *>(Int(cGameTeam1));
+    const std::uint32_t *team2 = reinterpret_cast<const std::uint32_t *>(Int(cGameTeam2));
+    const std::int32_t *teamIds = Int(cTeamId);
+
+    auto toId = [teamIds](std::uint32_t index) {
+        if (index == EventSnapshot::cDummy)
+        {
+            return Team::cDummyTeam;
+        }
+        return EventSnapshot::IsTeam(index) ? teamIds[index] : -1;
+    };
+
+    Game game;
+    game.id = Int(cGameId)[row];
+    game.eventId = Int(cGameEvent)[row];
+    game.turn = Int(cGameTurn)[row];
+    game.team1Id = toId(team1[row]);
+    game.team2Id = toId(team2[row]);
+    game.team1Score = Int(cGameScore1)[row];
+    game.team2Score = Int(cGameScore2)[row];
+    game.state = Int(cGameState)[row];
+    game.document = GetString(static_cast<std::uint32_t>(Int(cGameDocument)[row]));
+    return game;
+}
+
+bool SeasonArchive::HasEvent(int eventId) const
+{
+    std::uint32_t first;
+    std::uint32_t last;
+    FindRange(cEventId, mHeader->events, eventId, first, last);
+    return first < last;
+}
+
+std::deque<Event> SeasonArchive::GetEvents() const
+{
+    std::deque<Event> events;
+    for (std::uint32_t i = 0U; i < mHeader->events; i++)
+    {
+        events.push_back(MakeEvent(i));
+    }
+    return events;
+}
+
+Event SeasonArchive::GetEvent(int eventId) const
+{
+    std::uint32_t first;
+    std::uint32_t last;
+    FindRange(cEventId, mHeader->events, eventId, first, last);
+    return (first < last) ? MakeEvent(first) : Event();
+}
+
+std::deque<Team> SeasonArchive::GetTeams(int eventId) const
+{
+    std::deque<Team> teams;
+    std::uint32_t first;
+    std::uint32_t last;
+    FindRange(cTeamEvent, mHeader->teams, eventId, first, last);
+    for (std::uint32_t i = first; i < last; i++)
+    {
+        teams.push_back(MakeTeam(i));
+    }
+    return teams;
+}
+
+std::deque<Game> SeasonArchive::GetGames(int eventId) const
+{
+    std::deque<Game> games;
+    std::uint32_t first;
+    std::uint32_t last;
+    FindRange(cGameEvent, mHeader->games, eventId, first, last);
+    for (std::uint32_t i = first; i < last; i++)
+    {
+        games.push_back(MakeGame(i));
+    }
+    return games;
+}
+
+std::deque<Team> SeasonArchive::GetTeamsByPlayerId(int playerId) const
+{
+    std::deque<Team> teams;
+    const std::int32_t *player1 = Int(cTeamPlayer1);
+    const std::int32_t *player2 = Int(cTeamPlayer2);
+    const std::int32_t *player3 = Int(cTeamPlayer3);
+
+    for (std::uint32_t i = 0U; i < mHeader->teams; i++)
+    {
+        if ((player1[i] == playerId) || (player2[i] == playerId) || (player3[i] == playerId))
+        {
+            teams.push_back(MakeTeam(i));
+        }
+    }
+    return teams;
+}
+
+std::deque<Game> SeasonArchive::GetGamesByTeamId(int teamId) const
+{
+    std::deque<Game> games;
+    const std::int32_t *teamIds = Int(cTeamId);
+    const std::uint32_t *team1 = reinterpret_cast<const std::uint32_t *>(Int(cGameTeam1));
+    const std::uint32_t *team2 = reinterpret_cast<const std::uint32_t *>(Int(cGameTeam2));
+
+    // Teams are sorted by event only, find the row of the team first
+    std::uint32_t row = EventSnapshot::cNone;
+    for (std::uint32_t i = 0U; i < mHeader->teams; i++)
+    {
+        if (teamIds[i] == teamId)
+        {
+            row = i;
+            break;
+        }
+    }
+
+    if (row != EventSnapshot::cNone)
+    {
+        for (std::uint32_t i = 0U; i < mHeader->games; i++)
+        {
+            if ((team1[i] == row) || (team2[i] == row))
+            {
+                games.push_back(MakeGame(i));
+            }
+        }
+    }
+    return games;
+}
+
+bool SeasonArchive::GetGame(int gameId, Game &game) const
+{
+    const std::int32_t *ids = Int(cGameId);
+    for (std::uint32_t i = 0U; i < mHeader->games; i++)
+    {
+        if (ids[i] == gameId)
+        {
+            game = MakeGame(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief The columns are copied as they are, no row is decoded
+ */
+void SeasonArchive::GetSnapshot(EventSnapshot &snapshot) const
+{
+    TRACE_SCOPE("archive.GetSnapshot");
+    std::uint32_t nbTeams = mHeader->teams;
+    std::uint32_t nbGames = mHeader->games;
+    const std::uint32_t *team1 = reinterpret_cast<const std::uint32_t *>(Int(cGameTeam1));
+    const std::uint32_t *team2 = reinterpret_cast<const std::uint32_t *>(Int(cGameTeam2));
+
+    snapshot.teamIds.assign(Int(cTeamId), Int(cTeamId) + nbTeams);
+    snapshot.player1Ids.assign(Int(cTeamPlayer1), Int(cTeamPlayer1) + nbTeams);
+    snapshot.player2Ids.assign(Int(cTeamPlayer2), Int(cTeamPlayer2) + nbTeams);
+
+    snapshot.gameIds.assign(Int(cGameId), Int(cGameId) + nbGames);
+    snapshot.eventIds.assign(Int(cGameEvent), Int(cGameEvent) + nbGames);
+    snapshot.turns.assign(Int(cGameTurn), Int(cGameTurn) + nbGames);
+    snapshot.team1.assign(team1, team1 + nbGames);
+    snapshot.team2.assign(team2, team2 + nbGames);
+    snapshot.score1.assign(Int(cGameScore1), Int(cGameScore1) + nbGames);
+    snapshot.score2.assign(Int(cGameScore2), Int(cGameScore2) + nbGames);
+
+    snapshot.BuildIndex();
+}
+
+//=============================================================================
+// End of file SeasonArchive.cpp
+//=============================================================================
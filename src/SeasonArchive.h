@@ -0,0 +1,110 @@
+/*=============================================================================
+ * Tanca - SeasonArchive.h
+ *=============================================================================
+ * Read-only columnar file of a closed season
+ *=============================================================================
+ * Tanca ( https://github.com/belegar/tanca ) - This file is part of Tanca
+ * Copyright (C) 2003-2999 - Anthony Rabine
+ * anthony.rabine@tarotclub.fr
+ *
+ * Tanca is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Tanca is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Tanca.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *=============================================================================
+ */
+
+#ifndef SEASON_ARCHIVE_H
+#define SEASON_ARCHIVE_H
+
+#include <cstdint>
+#include <string>
+#include <deque>
+#include <QFile>
+
+#include "IDataBase.h"
+#include "EventSnapshot.h"
+
+/**
+ * @brief Events, teams and games of one season, memory mapped
+ *
+ * The file is a header followed by one array per column, in the byte order of
+ * the machine that wrote it (checked when opened). Teams are sorted by event,
+ * games by event and turn, so that the rows of an event are found by binary
+ * search. The games store the index of their teams in the team columns, like
+ * EventSnapshot. All the strings (names, titles, documents) are stored once
+ * in a dictionary and referenced by their index.
+ *
+ * Nothing is decoded when the file is opened: the columns are read in place.
+ */
+class SeasonArchive
+{
+public:
+    enum Column
+    {
+        cEventId, cEventDate, cEventType, cEventState, cEventOption, cEventTitle, cEventDocument,
+        cTeamId, cTeamEvent, cTeamNumber, cTeamPlayer1, cTeamPlayer2, cTeamPlayer3, cTeamState, cTeamName, cTeamDocument,
+        cGameId, cGameEvent, cGameTurn, cGameTeam1, cGameTeam2, cGameScore1, cGameScore2, cGameState, cGameDocument,
+        cStringOffset, cStringData,
+        cColumnCount
+    };
+
+    SeasonArchive();
+    ~SeasonArchive();
+
+    static bool Write(const QString &fileName, int year, std::deque<Event> events, std::deque<Team> teams, std::deque<Game> games);
+
+    bool Open(const QString &fileName);
+    void Close();
+    bool IsOpen() const { return mBase != nullptr; }
+
+    int GetYear() const;
+    std::uint32_t EventCount() const;
+    std::uint32_t TeamCount() const;
+    std::uint32_t GameCount() const;
+
+    // Raw columns, 32 bits integers (the event date is 64 bits, seconds)
+    const std::int32_t *Int(Column column) const;
+    const std::int64_t *Dates() const;
+    std::string GetString(std::uint32_t index) const;
+
+    // Rows as entities, for the views and the exports
+    bool HasEvent(int eventId) const;
+    std::deque<Event> GetEvents() const;
+    Event GetEvent(int eventId) const;
+    std::deque<Team> GetTeams(int eventId) const;
+    std::deque<Game> GetGames(int eventId) const;
+    std::deque<Team> GetTeamsByPlayerId(int playerId) const;
+    std::deque<Game> GetGamesByTeamId(int teamId) const;
+    bool GetGame(int gameId, Game &game) const;
+
+    // All the games of the season, for the rankings
+    void GetSnapshot(EventSnapshot &snapshot) const;
+
+private:
+    struct Header;
+
+    QFile mFile;
+    const std::uint8_t *mBase;
+    const Header *mHeader;
+
+    Event MakeEvent(std::uint32_t row) const;
+    Team MakeTeam(std::uint32_t row) const;
+    Game MakeGame(std::uint32_t row) const;
+    void FindRange(Column column, std::uint32_t count, int value, std::uint32_t &first, std::uint32_t &last) const;
+};
+
+#endif // SEASON_ARCHIVE_H
+
+//=============================================================================
+// End of file SeasonArchive.h
+//=============================================================================
@@ -1,8 +1,10 @@
 #include "Server.h"
+#include "Profiler.h"
 
 
 Server::Server()
-    : mServer(*this)
+    : Observer<Change>(Change::cGames | Change::cTeams | Change::cPlayers)
+    , mServer(*this)
 {
 
 }
@@ -23,9 +25,31 @@ void Server::NewConnection(const tcp::Conn &conn)
     (void) conn;
 }
 
+void Server::Update(const Change &info)
+{
+    TRACE_SCOPE("server.Update");
+    (void) info;
+    if (mGamesProvider)
+    {
+        SetGames(mGamesProvider());
+    }
+}
+
+void Server::SetGames(const std::string &games)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCurrentGames = games;
+}
+
 void Server::ReadData(const tcp::Conn &conn)
 {
-    tcp::TcpSocket::Send(mCurrentGames, conn.peer);
+    TRACE_SCOPE("server.Send");
+    std::string games;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        games = mCurrentGames;
+    }
+    tcp::TcpSocket::Send(games, conn.peer);
 
 //    tcp::TcpSocket::Send("coucou", conn.peer);
 }
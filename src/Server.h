@@ -1,10 +1,14 @@
 #ifndef SERVER_H
 #define SERVER_H
 
+#include <mutex>
+#include <functional>
+
 #include "TcpServer.h"
 #include "DbManager.h"
+#include "ChangeBus.h"
 
-class Server : public tcp::TcpServer::IEvent
+class Server : public tcp::TcpServer::IEvent, public Observer<Change>
 {
 public:
     Server();
@@ -18,14 +22,20 @@ public:
     virtual void ClientClosed(const tcp::Conn &conn);
     virtual void ServerTerminated(tcp::TcpServer::IEvent::CloseType type);
 
-    void SetGames(const std::string &games) {
-        mCurrentGames = games;
+    // From Observer<Change>: only games and teams are served
+    virtual void Update(const Change &info);
+
+    void SetGames(const std::string &games);
+    void SetGamesProvider(std::function<std::string ()> provider) {
+        mGamesProvider = provider;
     }
 
 private:
     tcp::TcpServer mServer;
 
+    std::mutex mMutex; // mCurrentGames is read from the network thread
     std::string mCurrentGames;
+    std::function<std::string ()> mGamesProvider;
 };
 
 #endif // SERVER_H
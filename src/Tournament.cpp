@@ -25,11 +25,14 @@
 
 #include "Tournament.h"
 #include "Log.h"
+#include "AsyncLog.h"
+#include "Profiler.h"
+#include "RoundRobin.h"
 
-#include <iostream>
 #include <algorithm>
 #include <sstream>
 #include <random>
+#include <unordered_set>
 
 bool RankHighFirst (Rank &i, Rank &j)
 {
@@ -103,8 +106,9 @@ Tournament::~Tournament()
 
 }
 
-static std::random_device rd;
-static std::mt19937_64 gen(rd());
+// One generator per thread: several tournaments may run at the same time
+static thread_local std::random_device rd;
+static thread_local std::mt19937_64 gen(rd());
 
 
 int Tournament::Generate(int min, int max)
@@ -178,183 +182,184 @@ std::string Tournament::ToJsonString(const std::deque<Game> &games, const std::d
 
 void Tournament::Add(int id, int gameId, int score, int opponent)
 {
-    if (!Contains(id))
+    int index = FindRankIndex(id);
+
+    if (index < 0)
     {
         // Create entry
         Rank rank;
         rank.id = id;
+        index = static_cast<int>(mRanking.size());
+        mRankIndex[id] = index;
         mRanking.push_back(rank);
     }
 
-    int index = FindRankIndex(id);
-
-    if (index >= 0)
-    {
-        mRanking[index].AddPoints(gameId, score, opponent);
-    }
+    mRanking[index].AddPoints(gameId, score, opponent);
 }
 
-int Tournament::FindRankIndex(int id)
+int Tournament::FindRankIndex(int id) const
 {
-    int index = -1;
-    for (unsigned int i = 0; i < mRanking.size(); i++)
-    {
-        if (mRanking[i].id == id)
-        {
-            index = (int)i;
-            break;
-        }
-    }
-    return index;
+    auto it = mRankIndex.find(id);
+    return (it == mRankIndex.end()) ? -1 : it->second;
 }
-bool Tournament::Contains(int id)
+
+void Tournament::ClearRanking()
 {
-    return (FindRankIndex(id) >= 0);
+    mRanking.clear();
+    mRankIndex.clear();
 }
 
-// Find all the matches played by each opponent
-// Sum the points won, this is the Buchholz points
-void Tournament::ComputeBuchholz(const std::deque<Game> &games)
+// The ranking has been sorted, update the indexes
+void Tournament::SortRanking()
 {
-    // Loop on each team
-    for (auto &rank : mRanking)
-    {
-        // 1. Loop through all the games played
-        for (auto gameId :  rank.mGames)
-        {
-            // 2. Get the game
-            Game game;
-
-            if (Game::Find(games, gameId, game))
-            {
-                // 3. Find the opponent for this game
-                int oppTeam = (game.team1Id == rank.id) ? game.team2Id : game.team1Id;
+    std::sort(mRanking.begin(), mRanking.end(), RankHighFirst);
 
-                // 4. Add the opponent points, search for it in the list
-                for (auto &rank2 : mRanking)
-                {
-                    if (rank2.id == oppTeam)
-                    {
-                        rank.pointsOpponents += rank2.pointsWon;
-                    }
-                }
-            }
-            else
-            {
-                TLogError("Internal Buchholz algorithm problem");
-            }
-        }
+    mRankIndex.clear();
+    for (std::uint32_t i = 0; i < mRanking.size(); i++)
+    {
+        mRankIndex[mRanking[i].id] = static_cast<int>(i);
     }
 }
 
-
 void Tournament::GeneratePlayerRanking(const std::deque<Game> &gameList, const std::deque<Team> &teamList, const std::deque<Event> &events)
 {
-    mRanking.clear();
+    TRACE_SCOPE("tournament.GeneratePlayerRanking");
+    EventSnapshot snapshot;
+    snapshot.Build(gameList, teamList);
+    GeneratePlayerRanking(snapshot, events);
+}
 
+void Tournament::GeneratePlayerRanking(const EventSnapshot &snapshot, const std::deque<Event> &events)
+{
+    ClearRanking();
     mIsTeam = false;
 
+    // Events counting for the season
+    std::unordered_set<int> eventIds;
     for (auto const &event : events)
     {
         if ((event.state != Event::cCanceled) && event.HasOption(Event::cOptionSeasonRanking))
         {
-            bool ok = true;
-            if (ok)
-            {
-                // Search for every game played for this event
-                std::deque<Game> games = Game::FindByEventId(gameList, event.id);
-                std::deque<Team> teams = Team::FindByEventId(teamList, event.id);
+            eventIds.insert(event.id);
+        }
+    }
 
-                for (auto const &game : games)
-                {
-                    if (game.IsPlayed())
-                    {
-                        Team team;
+    for (std::uint32_t g = 0; g < snapshot.GameCount(); g++)
+    {
+        if ((eventIds.count(snapshot.eventIds[g]) > 0) && snapshot.IsPlayed(g))
+        {
+            std::uint32_t t1 = snapshot.team1[g];
+            std::uint32_t t2 = snapshot.team2[g];
+            int gameId = snapshot.gameIds[g];
 
-                        if (Team::Find(teams, game.team1Id, team))
-                        {
-                            Add(team.player1Id, game.id, game.team1Score, game.team2Score);
-                            Add(team.player2Id, game.id, game.team1Score, game.team2Score);
-                        }
+            if (EventSnapshot::IsTeam(t1))
+            {
+                Add(snapshot.player1Ids[t1], gameId, snapshot.score1[g], snapshot.score2[g]);
+                Add(snapshot.player2Ids[t1], gameId, snapshot.score1[g], snapshot.score2[g]);
+            }
 
-                        if (Team::Find(teams, game.team2Id, team))
-                        {
-                            Add(team.player1Id, game.id, game.team2Score, game.team1Score);
-                            Add(team.player2Id, game.id, game.team2Score, game.team1Score);
-                        }
-                    }
-                }
+            if (EventSnapshot::IsTeam(t2))
+            {
+                Add(snapshot.player1Ids[t2], gameId, snapshot.score2[g], snapshot.score1[g]);
+                Add(snapshot.player2Ids[t2], gameId, snapshot.score2[g], snapshot.score1[g]);
             }
         }
     }
 
-    std::sort(mRanking.begin(), mRanking.end(), RankHighFirst);
+    SortRanking();
 }
 
-bool Tournament::GetTeamRank(int id, Rank &outRank)
+const Rank *Tournament::GetTeamRank(int id) const
 {
-    bool ret = false;
-    for (auto &rank : mRanking)
-    {
-        if (rank.id == id)
-        {
-            outRank = rank;
-            ret = true;
-            break;
-        }
-    }
-    return ret;
+    int index = FindRankIndex(id);
+    return (index >= 0) ? &mRanking[index] : nullptr;
 }
 
 void Tournament::GenerateTeamRanking(const std::deque<Game> &games, const std::deque<Team> &teams, int maxTurn)
 {
-    mRanking.clear();
+    EventSnapshot snapshot;
+    snapshot.Build(games, teams);
+    GenerateTeamRanking(snapshot, maxTurn);
+}
+
+void Tournament::GenerateTeamRanking(const EventSnapshot &snapshot, int maxTurn)
+{
+    TRACE_SCOPE("tournament.GenerateTeamRanking");
+    ClearRanking();
     mByeTeamIds.clear();
     mIsTeam = true;
 
-    for (auto const &game : games)
+    // Opponents met by each team, by index, for the Buchholz points
+    std::vector<std::vector<std::uint32_t>> opponents(snapshot.TeamCount());
+
+    for (std::uint32_t g = 0; g < snapshot.GameCount(); g++)
     {
-        if (game.IsPlayed() && (game.turn < maxTurn))
+        if (snapshot.IsPlayed(g) && (snapshot.turns[g] < maxTurn))
         {
-            Team team;
+            std::uint32_t t1 = snapshot.team1[g];
+            std::uint32_t t2 = snapshot.team2[g];
+            int gameId = snapshot.gameIds[g];
 
             // Special case of a dummy team: means that the other team has a bye
-            if (game.HasBye())
+            if (snapshot.HasBye(g))
             {
-                int bye = game.GetByeTeam();
-                if (Team::Find(teams, bye, team))
+                bool byeIsTeam1 = (t2 == EventSnapshot::cDummy);
+                std::uint32_t bye = byeIsTeam1 ? t1 : t2;
+                if (EventSnapshot::IsTeam(bye))
                 {
-                    int byeScore = (bye == game.team1Id) ? game.team1Score : game.team2Score;
-                    int dummyScore = (bye == game.team2Id) ? game.team1Score : game.team2Score;
+                    int byeScore = byeIsTeam1 ? snapshot.score1[g] : snapshot.score2[g];
+                    int dummyScore = byeIsTeam1 ? snapshot.score2[g] : snapshot.score1[g];
 
-                    Add(team.id, game.id, byeScore, dummyScore);
-                    mByeTeamIds.push_back(team.id);
+                    Add(snapshot.teamIds[bye], gameId, byeScore, dummyScore);
+                    mByeTeamIds.push_back(snapshot.teamIds[bye]);
                 }
             }
             else
             {
-                if (Team::Find(teams, game.team1Id, team))
+                if (EventSnapshot::IsTeam(t1))
                 {
-                    Add(team.id, game.id, game.team1Score, game.team2Score);
+                    Add(snapshot.teamIds[t1], gameId, snapshot.score1[g], snapshot.score2[g]);
+                    opponents[t1].push_back(t2);
                 }
 
-                if (Team::Find(teams, game.team2Id, team))
+                if (EventSnapshot::IsTeam(t2))
                 {
-                    Add(team.id, game.id, game.team2Score, game.team1Score);
+                    Add(snapshot.teamIds[t2], gameId, snapshot.score2[g], snapshot.score1[g]);
+                    opponents[t2].push_back(t1);
                 }
             }
         }
     }
 
-
     // Compute Buchholtz points for all players to avoid equalities
-    ComputeBuchholz(games);
+    ComputeBuchholz(snapshot, opponents);
 
     //create a list of sorted players
-    std::sort(mRanking.begin(), mRanking.end(), RankHighFirst);
+    SortRanking();
 }
 
-std::deque<Rank> Tournament::GetRanking()
+// Sum the points won by all the opponents met, this is the Buchholz points
+void Tournament::ComputeBuchholz(const EventSnapshot &snapshot, const std::vector<std::vector<std::uint32_t>> &opponents)
+{
+    for (auto &rank : mRanking)
+    {
+        std::uint32_t team = snapshot.FindTeam(rank.id);
+
+        if (EventSnapshot::IsTeam(team))
+        {
+            for (auto opp : opponents[team])
+            {
+                int index = EventSnapshot::IsTeam(opp) ? FindRankIndex(snapshot.teamIds[opp]) : -1;
+                if (index >= 0)
+                {
+                    rank.pointsOpponents += mRanking[index].pointsWon;
+                }
+            }
+        }
+    }
+}
+
+const std::deque<Rank> &Tournament::GetRanking() const
 {
     return mRanking;
 }
@@ -362,52 +367,15 @@ std::deque<Rank> Tournament::GetRanking()
 /*****************************************************************************/
 std::string Tournament::BuildRoundRobinRounds(const std::deque<Team> &tlist, std::uint32_t nbRounds, std::deque<Game> &games)
 {
+    TRACE_SCOPE("tournament.BuildRoundRobinRounds");
     std::string error;
-    std::deque<Team> teams = tlist; // Local copy to manipulate the list
-
-    if (teams.size()%2)
-    {
-        // odd numeber of team, add dummy one
-        Team dummy;
-        teams.push_back(dummy);
-    }
 
-    int max_games = teams.size() / 2;
-
-    // Create fuzzy, never start with the same team
-    std::random_shuffle(teams.begin(), teams.end());
-
-    // Check if there is enough teams for the desired number of rounds
-    // Round-robin tournament algorithm
-    if (teams.size() > nbRounds)
+    if (tlist.size() >= 2)
     {
-        for (uint32_t i = 0; i < nbRounds; i++)
+        RoundRobinStream stream(tlist, 0U, nbRounds);
+        for (Game *game = stream.Next(); game != nullptr; game = stream.Next())
         {
-            // Create matches for this turn
-            for (int j = 0; j < max_games; j++)
-            {
-                const Team &team = teams[j];
-                const Team &opp = teams[teams.size() - j - 1];
-
-                Game game;
-
-                game.eventId = opp.eventId;
-                game.turn = i;
-                game.team1Id = team.id;
-                game.team2Id = opp.id;
-
-                games.push_back(game);
-            }
-
-            // Then rotate, keep first player always at the first place
-            Team first = teams.front();
-            Team last = teams.back();
-
-            teams.pop_front();
-            teams.pop_back();
-
-            teams.push_front(last);
-            teams.push_front(first);
+            games.push_back(*game);
         }
     }
     else
@@ -417,100 +385,101 @@ std::string Tournament::BuildRoundRobinRounds(const std::deque<Team> &tlist, std
     return error;
 }
 
-/*****************************************************************************/
-template <typename T>
-inline bool IsMultipleOf(const T i_value, const T i_multiple)
+/**
+ * @brief First round by strength: the first of the top half meets the first of the bottom half
+ *
+ * The strongest teams cannot meet in the first round, and the score groups of
+ * the second round are balanced. Teams of the same strength are shuffled.
+ * With an odd number of teams, the weakest one has the bye.
+ */
+std::string Tournament::BuildSeededRound(const std::deque<Team> &teams, std::deque<Game> &games)
 {
-    return (i_multiple != static_cast<T>(0))
-           ? (i_value % i_multiple) == static_cast<T>(0)
-           : false;
-}
+    TRACE_SCOPE("tournament.BuildSeededRound");
+    std::string error;
 
-bool Tournament::HasPlayed(const std::deque<Game> &games, const Rank &rank, int oppId)
-{
-    bool hasPlayed = false;
-    // 1. Loop through all the games played
-    for (auto gameId :  rank.mGames)
+    if (teams.size() >= 2)
     {
-        // 2. Get the game
-        Game game;
-
-        if (Game::Find(games, gameId, game))
+        std::vector<std::pair<double, int>> order; // strength, team id
+        for (auto const &team : teams)
         {
-            // 3. Find the opponent for this game
-            int oppTeam = (game.team1Id == rank.id) ? game.team2Id : game.team1Id;
-            if (oppTeam == oppId)
-            {
-                hasPlayed = true;
-            }
+            auto it = mStrength.find(team.id);
+            order.push_back(std::make_pair((it != mStrength.end()) ? it->second : 0.0, team.id));
         }
-    }
 
-    return hasPlayed;
-}
+        std::shuffle(order.begin(), order.end(), gen);
+        std::stable_sort(order.begin(), order.end(), [](const std::pair<double, int> &a, const std::pair<double, int> &b) {
+            return a.first > b.first;
+        });
 
-// Take the first player in the list
-// Find the opponent, never played with it, with the nearest level
-int Tournament::FindtUnplayedIndex(const std::deque<Game> &games, const std::deque<int> &ranking)
-{
-    int index = -1;
-    if (ranking.size() >= 2)
-    {
-        // Get the rank for the first team
-        int rankIndex = FindRankIndex(ranking[0]);
+        Game game;
+        game.eventId = teams.at(0).eventId;
+        game.turn = 0;
 
-        if (rankIndex >= 0)
+        if ((order.size() % 2U) != 0U)
         {
-            unsigned int i = 1;
-            do
-            {
-                // look for all the games played
-                if (!HasPlayed(games, mRanking[rankIndex], ranking[i]))
-                {
-                    index = (int)i;
-                }
-                i++;
-            } while ((index < 0) && (i < ranking.size()));
+            game.team1Id = order.back().second;
+            game.team2Id = Team::cDummyTeam;
+            games.push_back(game);
+            order.pop_back();
         }
-        else
+
+        std::size_t half = order.size() / 2;
+        for (std::size_t i = 0; i < half; i++)
         {
-            TLogError("Internal rank index finder problem");
+            game.team1Id = order[i].second;
+            game.team2Id = order[i + half].second;
+            games.push_back(game);
         }
     }
     else
     {
-        TLogError("Not enough teams to create game");
+        error = "pas assez de joueurs pour joueur les tours demandés";
     }
-
-    return index;
+    return error;
 }
 
-bool Tournament::AlreadyPlayed(const std::deque<Game> &games, int p1Id, int p2Id)
+/**
+ * @brief Number of rounds already generated (turns start at 0)
+ */
+std::uint32_t Tournament::CountRounds(const std::deque<Game> &games)
 {
-    // Get the rank for the first team
-    int rankIndex = FindRankIndex(p1Id);
-    return HasPlayed(games, mRanking[rankIndex], p2Id);
+    int rounds = 0;
+    for (auto const &g : games)
+    {
+        rounds = std::max(rounds, g.turn + 1);
+    }
+    return static_cast<std::uint32_t>(rounds);
 }
 
+/*****************************************************************************/
+template <typename T>
+inline bool IsMultipleOf(const T i_value, const T i_multiple)
+{
+    return (i_multiple != static_cast<T>(0))
+           ? (i_value % i_multiple) == static_cast<T>(0)
+           : false;
+}
 
-void PrintMatrix(const std::deque<int> &row, const std::deque<std::deque<int>> &matrix)
+std::string MatrixToString(const std::deque<int> &row, const std::deque<std::deque<int>> &matrix)
 {
+    std::stringstream ss;
+
     // Print header
     for (unsigned int i = 0; i < row.size(); i++)
     {
-        std::cout << "\t" << row[i];
+        ss << "\t" << row[i];
     }
 
     for (unsigned int i = 0; i < row.size(); i++)
     {
-        std::cout << "\n" << row[i] << " [ ";
+        ss << "\n" << row[i] << " [ ";
         for (unsigned int j = 0; j < row.size(); j++)
         {
-            std::cout << "\t" << matrix[i][j];
+            ss << "\t" << matrix[i][j];
         }
-        std::cout << " ] ";
+        ss << " ] ";
     }
-    std::cout << std::endl;
+    return ss.str();
 }
 
 
@@ -593,7 +562,7 @@ void FindSolution(std::deque<Solution> &list, Solution &s, const std::deque<int>
                     {
                         if (s2.totalCost < Rank::cHighCost)
                         {
-                            std::cout << "Found one solution!" << std::endl;
+                            ALogDebug("Found one solution, cost: " << s2.totalCost);
                             list.push_back(s2);
                         }
                         else
@@ -617,6 +586,7 @@ bool Tournament::BuildPairing(const std::deque<int> &ranking,
                               const std::deque<std::deque<int>> &cost,
                               std::deque<Game> &newRounds)
 {
+    TRACE_SCOPE("tournament.BuildPairing");
     std::uint32_t size = cost[0].size();
     std::deque<Solution> solutions;
     std::deque<std::deque<int>> pairing(size);
@@ -633,9 +603,12 @@ bool Tournament::BuildPairing(const std::deque<int> &ranking,
     std::uint32_t col = 1;
 
     Solution s(size);
-    FindSolution(solutions, s, ranking, cost, col, row);
+    {
+        TRACE_SCOPE("tournament.FindSolution");
+        FindSolution(solutions, s, ranking, cost, col, row);
+    }
 
-    std::cout << "Found " << solutions.size() << " solutions" << std::endl;
+    ALogDebug("Found " << solutions.size() << " solutions");
 
     int i = 1;
 
@@ -676,19 +649,28 @@ bool Tournament::BuildPairing(const std::deque<int> &ranking,
         newRounds.push_back(game);
     }
 
-    std::cout << "======>  COST MATRIX " << std::endl;
-    PrintMatrix(ranking, cost);
-    std::cout << "======>  PAIRING MATRIX" << std::endl;
-    PrintMatrix(ranking, pairing);
+    // The matrices are only formatted in debug builds
+    ALogDebug("======>  COST MATRIX\n" << MatrixToString(ranking, cost));
+    ALogDebug("======>  PAIRING MATRIX\n" << MatrixToString(ranking, pairing));
 
     return (solutions.size() > 0);
 }
 
-void Tournament::BuildCost(const std::deque<Game> &games,
+void Tournament::BuildCost(const EventSnapshot &snapshot,
                            std::deque<int> &ranking,
                            std::deque<std::deque<int>> &cost_matrix)
 {
+    TRACE_SCOPE("tournament.BuildCost");
     int size = ranking.size();
+    std::vector<std::uint32_t> teams(size);
+    std::vector<int> forces(size);
+
+    for (int i = 0; i < size; i++)
+    {
+        int index = FindRankIndex(ranking[i]);
+        teams[i] = snapshot.FindTeam(ranking[i]);
+        forces[i] = (index >= 0) ? mRanking[index].ComputeForce() : 0;
+    }
 
     // Init matrix
     for (int i = 0; i < size; i++)
@@ -702,14 +684,14 @@ void Tournament::BuildCost(const std::deque<Game> &games,
                 // Same player
                 cost = Rank::cHighCost;
             }
-            else if (AlreadyPlayed(games, ranking[j], ranking[i]))
+            else if (EventSnapshot::IsTeam(teams[i]) && EventSnapshot::IsTeam(teams[j]) && snapshot.HasMet(teams[j], teams[i]))
             {
                 cost = Rank::cHighCost;
             }
             else
             {
                 // compute cost
-                cost = std::abs(mRanking[j].ComputeForce() - mRanking[i].ComputeForce());
+                cost = std::abs(forces[j] - forces[i]);
             }
 
             cost_matrix[i].push_back(cost);
@@ -725,6 +707,7 @@ bool IsOdd(int size)
 
 std::string Tournament::BuildSwissRounds(const std::deque<Game> &games, const std::deque<Team> &teams, std::deque<Game> &newRounds)
 {
+    TRACE_SCOPE("tournament.BuildSwissRounds");
     std::string error;
     int eventId;
 
@@ -735,11 +718,16 @@ std::string Tournament::BuildSwissRounds(const std::deque<Game> &games, const st
         size_t nbGames = teams.size() / 2;
 
         // 1. Check where we are
-        if (games.size() == 0)
+        if ((games.size() == 0) && (mStrength.size() > 0))
+        {
+            error = BuildSeededRound(teams, newRounds);
+            ALogDebug("First round, seeded");
+        }
+        else if (games.size() == 0)
         {
             // Firt round, compute random games
             error = BuildRoundRobinRounds(teams, 1, newRounds);
-            std::cout << "First round" << std::endl;
+            ALogDebug("First round");
         }
         else
         {
@@ -759,16 +747,16 @@ std::string Tournament::BuildSwissRounds(const std::deque<Game> &games, const st
                 int turn = (games.size() / nbGames);
 
                 // Create ranking
-                GenerateTeamRanking(games, teams, turn);
+                EventSnapshot snapshot;
+                snapshot.Build(games, teams);
+                GenerateTeamRanking(snapshot, turn);
 
                 // Create a local list of the ranking, keep only ids
                 std::deque<int> ranking;
 
                 for (auto &rank : mRanking)
                 {
-                    Team team;
-                    Team::Find(teams, rank.id, team);
-                    std::cout << rank.id << ". " << team.teamName << std::endl;
+                    ALogDebug(rank.id << ". " << teams[snapshot.FindTeam(rank.id)].teamName);
                     ranking.push_back(rank.id);
                 }
 
@@ -790,16 +778,16 @@ std::string Tournament::BuildSwissRounds(const std::deque<Game> &games, const st
                 std::deque<int> winners(ranking.begin(), ranking.begin() + rank_size);
                 std::deque<int> loosers(ranking.begin() + rank_size, ranking.end());
 
-                std::cout << "---------------  WINNERS -------------------" << std::endl;
+                ALogDebug("---------------  WINNERS -------------------");
                 // Create a matrix and fill it
                 std::deque<std::deque<int>> cost_matrix(rank_size);
-                BuildCost(games, winners, cost_matrix);
+                BuildCost(snapshot, winners, cost_matrix);
                 bool success = BuildPairing(winners, cost_matrix, newRounds);
 
-                std::cout << "---------------  LOOSERS -------------------" << std::endl;
+                ALogDebug("---------------  LOOSERS -------------------");
                 // Create a matrix and fill it
                 std::deque<std::deque<int>> cost_matrix2(loosers.size());
-                BuildCost(games, loosers, cost_matrix2);
+                BuildCost(snapshot, loosers, cost_matrix2);
                 success = success && BuildPairing(loosers, cost_matrix2, newRounds);
 
                 for (auto &game : newRounds)
@@ -27,7 +27,10 @@
 #define TOURNAMENT_H
 
 #include "IDataBase.h"
+#include "EventSnapshot.h"
 #include <list>
+#include <vector>
+#include <unordered_map>
 
 struct Rank
 {
@@ -71,6 +74,9 @@ public:
     void AddPoints(int gameId, int score, int oppScore);
 };
 
+// Ranking order, best first: games won, points won, difference, Buchholz
+bool RankHighFirst(Rank &i, Rank &j);
+
 
 class Tournament
 {
@@ -82,8 +88,12 @@ public:
     void GeneratePlayerRanking(const std::deque<Game> &gameList, const std::deque<Team> &teamList, const std::deque<Event> &events);
     void GenerateTeamRanking(const std::deque<Game> &games, const std::deque<Team> &teams, int maxTurn);
 
-    std::deque<Rank> GetRanking();
-    bool GetTeamRank(int id, Rank &outRank);
+    // Same computations, on a snapshot already built
+    void GeneratePlayerRanking(const EventSnapshot &snapshot, const std::deque<Event> &events);
+    void GenerateTeamRanking(const EventSnapshot &snapshot, int maxTurn);
+
+    const std::deque<Rank> &GetRanking() const;
+    const Rank *GetTeamRank(int id) const;
 
    // std::string ToJsonString(const std::deque<Game> &games, const std::deque<Team> &teams);
     std::string RankingToString();
@@ -91,24 +101,29 @@ public:
     std::string BuildRoundRobinRounds(const std::deque<Team> &tlist, uint32_t nbRounds, std::deque<Game> &games);
     std::string BuildSwissRounds(const std::deque<Game> &games, const std::deque<Team> &teams, std::deque<Game> &newRounds);
 
+    // Team strength (team id -> rating) for the first Swiss round, random if empty
+    void SetStrength(const std::unordered_map<int, double> &strength) { mStrength = strength; }
+    std::string BuildSeededRound(const std::deque<Team> &teams, std::deque<Game> &games);
+
     static int Generate(int min, int max);
+    static std::uint32_t CountRounds(const std::deque<Game> &games);
 private:
     bool mIsTeam;
 
     std::deque<Rank> mRanking;
+    std::unordered_map<int, int> mRankIndex; // id -> index in mRanking
     std::deque<int> mByeTeamIds; // list of teams that has a bye for that event
+    std::unordered_map<int, double> mStrength;
 
-    void ComputeBuchholz(const std::deque<Game> &games);
-    bool Contains(int id);
-    int FindRankIndex(int id);
+    void ComputeBuchholz(const EventSnapshot &snapshot, const std::vector<std::vector<std::uint32_t>> &opponents);
+    int FindRankIndex(int id) const;
+    void ClearRanking();
+    void SortRanking();
     void Add(int id, int gameId, int score, int opponent);
-    bool HasPlayed(const std::deque<Game> &games, const Rank &rank, int oppId);
-    int FindtUnplayedIndex(const std::deque<Game> &games, const std::deque<int> &ranking);
-    bool AlreadyPlayed(const std::deque<Game> &games, int p1Id, int p2Id);
     bool BuildPairing(const std::deque<int> &ranking,
                       const std::deque<std::deque<int> > &cost,
                       std::deque<Game> &newRounds);
-    void BuildCost(const std::deque<Game> &games,
+    void BuildCost(const EventSnapshot &snapshot,
                    std::deque<int> &ranking,
                    std::deque<std::deque<int> > &cost_matrix);
 };
@@ -18,6 +18,9 @@
 
 #include "MainWindow.h"
 #include <QApplication>
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstring>
 
 #include <iostream>
 #include <fstream>
@@ -28,6 +31,8 @@
 */
 #include "Tournament.h"
 #include "Log.h"
+#include "AsyncLog.h"
+#include "BatchRunner.h"
 
 //#define UNIT_TESTS
 
@@ -46,25 +51,100 @@ public:
 
     void Update(const Log::Infos &info)
     {
-        std::cout << info.message << std::endl;
+        // Never block the caller on the console
+        AsyncLog::Push(ToLevel(info.event), info.message);
+    }
+
+private:
+    static int ToLevel(std::uint8_t event)
+    {
+        int level = ALOG_LEVEL_INFO;
+        if (event == Log::Error)
+        {
+            level = ALOG_LEVEL_ERROR;
+        }
+        else if (event == Log::Warning)
+        {
+            level = ALOG_LEVEL_WARNING;
+        }
+        return level;
     }
 };
 
 extern void RunTests();
 
+/**
+ * @brief Headless mode: no display needed, the results go to stdout, the logs to stderr
+ */
+static int RunBatch(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    if (argc < 4)
+    {
+        BatchRunner::Usage();
+        return BatchRunner::cErrorUsage;
+    }
+
+    AsyncLog::Start(stderr);
+    Logger logger;
+    Log::RegisterListener(logger);
+
+    QStringList args = a.arguments().mid(3);
+    BatchRunner runner(a.arguments().at(2));
+    int ret = runner.Run(args);
+
+    AsyncLog::Stop();
+    return ret;
+}
+
 int main(int argc, char *argv[])
 {
+    if ((argc > 1) && (std::strcmp(argv[1], "--self-test") == 0))
+    {
+        // Algorithm tests, a failure aborts
+        RunTests();
+        std::puts("All tests passed");
+        return 0;
+    }
+
+    if (BatchRunner::IsBatch(argc, argv))
+    {
+        return RunBatch(argc, argv);
+    }
+
     QCoreApplication::setAttribute(Qt::AA_UseSoftwareOpenGL);
+    AsyncLog::Start();
     Logger logger;
     Log::RegisterListener(logger);
 
     QApplication a(argc, argv);
+    bool measure = a.arguments().contains("--startup-time");
+    QElapsedTimer timer;
+    timer.start();
 
     MainWindow w;
-    w.Initialize();
     w.show();
+    // First paint before the database is read
+    QApplication::processEvents();
+    qint64 shown = timer.elapsed();
+
+    w.Initialize();
+    QApplication::processEvents();
 
-    return a.exec();
+    int ret = 0;
+    if (measure)
+    {
+        // Startup benchmark: print the times and leave
+        std::printf("Window shown: %lld ms\nData displayed: %lld ms\n",
+                    static_cast<long long>(shown), static_cast<long long>(timer.elapsed()));
+    }
+    else
+    {
+        ret = a.exec();
+    }
+    AsyncLog::Stop();
+    return ret;
 
 }
 
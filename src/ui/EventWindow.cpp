@@ -25,6 +25,10 @@
 
 #include "EventWindow.h"
 #include "Util.h"
+#include "CourtAllocator.h"
+
+// Event type of each item of the combo box
+static const int cTypes[] = { Event::cRoundRobin, Event::cSwissRounds, Event::cSingleElimination, Event::cDoubleElimination };
 
 EventWindow::EventWindow(QWidget *parent)
     : QDialog(parent)
@@ -41,8 +45,14 @@ void EventWindow::GetEvent(Event &event)
     event.date = Util::FromISODateTime(ui.dateTimeEdit->dateTime().toString(Qt::ISODate).toStdString());
     event.state = ui.comboState->currentIndex();
     event.title = ui.lineTitle->text().toStdString();
-    event.type = ui.comboType->currentIndex();
+    int index = ui.comboType->currentIndex();
+    event.type = ((index >= 0) && (index < static_cast<int>(sizeof(cTypes) / sizeof(cTypes[0])))) ? cTypes[index] : Event::cRoundRobin;
     event.option = ui.checkBoxSeasonRanking->isChecked() ? Event::cOptionSeasonRanking : Event::cNoOption;
+    if (ui.checkBoxSeededRound->isChecked())
+    {
+        event.option |= Event::cOptionSeededFirstRound;
+    }
+    CourtAllocator::SetCourts(event, static_cast<std::uint32_t>(ui.spinCourts->value()));
 }
 
 void EventWindow::SetEvent(const Event &event)
@@ -50,7 +60,16 @@ void EventWindow::SetEvent(const Event &event)
     ui.dateTimeEdit->setDateTime(QDateTime::fromString(Util::ToISODateTime(event.date).c_str(), Qt::ISODate));
     ui.comboState->setCurrentIndex(event.state);
     ui.lineTitle->setText(event.title.c_str());
-    ui.comboType->setCurrentIndex(event.type);
+    int index = 1; // the old type 1 was also a Swiss tournament
+    for (int i = 0; i < static_cast<int>(sizeof(cTypes) / sizeof(cTypes[0])); i++)
+    {
+        if (cTypes[i] == event.type)
+        {
+            index = i;
+        }
+    }
+    ui.comboType->setCurrentIndex(index);
+    ui.spinCourts->setValue(static_cast<int>(CourtAllocator::GetCourts(event)));
 
     if (event.HasOption(Event::cOptionSeasonRanking))
     {
@@ -60,6 +79,7 @@ void EventWindow::SetEvent(const Event &event)
     {
         ui.checkBoxSeasonRanking->setChecked(false);
     }
+    ui.checkBoxSeededRound->setChecked(event.HasOption(Event::cOptionSeededFirstRound));
 }
 
 //=============================================================================
@@ -6,15 +6,21 @@
 
 PlayerWindow::PlayerWindow(QWidget *parent)
     : QDialog(parent)
+    , mCities(nullptr)
 {
     ui.setupUi(this);
 
+    mCityCompleter = new QCompleter(&mCityModel, this);
+    mCityCompleter->setCaseSensitivity(Qt::CaseInsensitive);
+    ui.lineCity->setCompleter(mCityCompleter);
+
     datePickerWindow = new DatePickerWindow(this);
     datePickerWindow->hide();
 
     connect(ui.buttonAddLicence, &QPushButton::clicked, this, &PlayerWindow::slotAddLicence);
     connect(ui.buttonOk, &QPushButton::clicked, this, &PlayerWindow::slotAccept);
     connect(ui.buttonCancel, &QPushButton::clicked, this, &PlayerWindow::reject);
+    connect(ui.spinPostCode->findChild<QLineEdit *>(), &QLineEdit::textEdited, this, &PlayerWindow::slotPostCodeEdited);
 }
 
 
@@ -27,6 +33,38 @@ void PlayerWindow::slotAddLicence()
     }
 }
 
+/**
+ * @brief Cities of the postal codes starting with the digits typed so far
+ *
+ * The city is filled in when the code is complete and serves a single city.
+ */
+void PlayerWindow::slotPostCodeEdited(const QString &text)
+{
+    QStringList cities;
+    QString digits = text.trimmed();
+    bool ok = false;
+    int value = digits.toInt(&ok);
+    std::uint32_t first;
+    std::uint32_t last;
+
+    // A single digit matches thousands of cities
+    if (ok && (mCities != nullptr) && (digits.size() >= 2) &&
+        mCities->FindPrefix(value, digits.size(), first, last))
+    {
+        for (std::uint32_t i = first; (i < last) && (cities.size() < cMaxCompletions); i++)
+        {
+            cities << QString::fromUtf8(mCities->GetCity(i));
+        }
+        cities.removeDuplicates();
+    }
+    mCityModel.setStringList(cities);
+
+    if ((digits.size() == CityDirectory::cCodeLength) && (cities.size() == 1) && ui.lineCity->text().isEmpty())
+    {
+        ui.lineCity->setText(cities.first());
+    }
+}
+
 void PlayerWindow::slotAccept()
 {
     bool ok = true;
@@ -101,6 +139,35 @@ void PlayerWindow::SetPlayer(const Player &player)
     ui.lineMail->setText(player.email.c_str());
 }
 
+/**
+ * @brief Results, partners and head-to-head records of the player
+ */
+void PlayerWindow::ShowStats(DbManager &db, int playerId)
+{
+    const PlayerStats &stats = db.GetPlayerStats(playerId);
+
+    ui.labelStats->setText(tr("%1 parties jouées : %2 gagnées, %3 nulles, %4 perdues (%5 %), points %6 / %7")
+                           .arg(stats.GetPlayed()).arg(stats.won).arg(stats.draw).arg(stats.lost)
+                           .arg(stats.WinRate()).arg(stats.pointsWon).arg(stats.pointsLost));
+
+    TableHelper helper(ui.tableStats);
+    QStringList header;
+    header << tr("Id") << tr("Joueur") << tr("Relation") << tr("Parties") << tr("Gagnées") << tr("Perdues") << tr("Victoires (%)");
+    helper.Initialize(header, static_cast<int>(stats.partners.size() + stats.opponents.size()));
+
+    for (auto list : { &stats.partners, &stats.opponents })
+    {
+        std::string relation = (list == &stats.partners) ? "Partenaire" : "Adversaire";
+        for (auto const &r : *list)
+        {
+            std::string name = db.GetPlayers().Contains(r.playerId) ? db.GetPlayerName(r.playerId) : std::to_string(r.playerId);
+            helper.AppendLine({ r.playerId, name, relation, r.games, r.won, r.lost, r.WinRate() }, false);
+        }
+    }
+    helper.Finish();
+    ui.groupStats->show();
+}
+
 void PlayerWindow::GetPlayer(Player &player)
 {
     QString name = ui.lineName->text().toLower();
@@ -152,10 +219,17 @@ bool PlayerWindow::AddPlayer(DbManager &db)
     bool success = false;
     Player newPlayer;
 
+    mCities = &db.GetCityDirectory();
     SetPlayer(newPlayer);
+    ui.groupStats->hide();
     if (exec() == QDialog::Accepted)
     {
         GetPlayer(newPlayer);
+        if (!ConfirmDuplicates(db, newPlayer))
+        {
+            return false;
+        }
+
         if (db.AddPlayer(newPlayer))
         {
             success = true;
@@ -168,6 +242,31 @@ bool PlayerWindow::AddPlayer(DbManager &db)
     return success;
 }
 
+/**
+ * @brief Ask before adding a player that may already be a member
+ */
+bool PlayerWindow::ConfirmDuplicates(DbManager &db, const Player &player)
+{
+    std::vector<DuplicateMatch> matches = db.FindDuplicates(player);
+    if (matches.empty())
+    {
+        return true;
+    }
+
+    QString list;
+    for (std::uint32_t i = 0U; (i < matches.size()) && (i < 5U); i++)
+    {
+        if (db.GetPlayers().Contains(matches[i].playerId))
+        {
+            list += QString("\n - %1 (%2)").arg(db.GetPlayerName(matches[i].playerId).c_str()).arg(matches[i].ToString().c_str());
+        }
+    }
+
+    return QMessageBox::question(this, tr("Formulaire de joueur"),
+                                 tr("Ce joueur est peut-être déjà inscrit :%1\n\nL'ajouter quand même ?").arg(list),
+                                 QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
+}
+
 bool PlayerWindow::EditPlayer(DbManager &db, QTableWidget *widget)
 {
     bool success = false;
@@ -179,7 +278,9 @@ bool PlayerWindow::EditPlayer(DbManager &db, QTableWidget *widget)
         Player p;
         if (db.FindPlayer(id, p))
         {
+            mCities = &db.GetCityDirectory();
             SetPlayer(p);
+            ShowStats(db, id);
             if (exec() == QDialog::Accepted)
             {
                 GetPlayer(p);
@@ -274,6 +375,11 @@ bool PlayerWindow::ImportPlayerFile(DbManager &db)
         }
         else
         {
+            std::deque<Player> players;
+            std::deque<Player> similar; // near matches, imported only if the user confirms
+            QString list;
+            DuplicateDetector imported; // rows of the file already read
+
             while (!file.atEnd())
             {
                 QString line = file.readLine();
@@ -293,19 +399,54 @@ bool PlayerWindow::ImportPlayerFile(DbManager &db)
 
                     std::string fullname = p.name + " " + p.lastName;
 
-                    if (!db.PlayerExists(p) && db.IsValid(p))
+                    if (!db.IsValid(p))
                     {
-                        if (!db.AddPlayer(p))
-                        {
-                            TLogError("Import failed for player: " + fullname);
-                            importNoError = false;
-                        }
+                        TLogError("Player " + fullname + " is invalid, cannot import it");
+                        importNoError = false;
                     }
-                    else
+                    else if (db.PlayerExists(p))
                     {
-                        TLogError("Player " + fullname + " is invalid or already exists in the database, cannot import it");
+                        // Same first and last names: the same person
+                        TLogError("Player " + fullname + " already exists in the database, cannot import it");
                         importNoError = false;
                     }
+                    else if (imported.HasName(p))
+                    {
+                        TLogError("Player " + fullname + " is already in the file, cannot import it twice");
+                        importNoError = false;
+                    }
+                    else
+                    {
+                        // Only similar: the user decides, as when a player is created
+                        QString other;
+                        std::vector<DuplicateMatch> matches = db.FindDuplicates(p);
+                        if (!matches.empty())
+                        {
+                            other = QString("%1, %2").arg(db.GetPlayerName(matches.front().playerId).c_str()).arg(matches.front().ToString().c_str());
+                        }
+                        else
+                        {
+                            matches = imported.Find(p);
+                            if (!matches.empty())
+                            {
+                                other = tr("plus haut dans le fichier, %1").arg(matches.front().ToString().c_str());
+                            }
+                        }
+
+                        imported.Add(p);
+                        if (matches.empty())
+                        {
+                            players.push_back(p);
+                        }
+                        else
+                        {
+                            if (similar.size() < cMaxListed)
+                            {
+                                list += QString("\n - %1 (%2)").arg(fullname.c_str()).arg(other);
+                            }
+                            similar.push_back(p);
+                        }
+                    }
                 }
                 else
                 {
@@ -313,6 +454,27 @@ bool PlayerWindow::ImportPlayerFile(DbManager &db)
                     importNoError = false;
                 }
             }
+
+            if (!similar.empty())
+            {
+                if (similar.size() > cMaxListed)
+                {
+                    list += tr("\n... et %1 autres").arg(similar.size() - cMaxListed);
+                }
+
+                if (QMessageBox::question(this, tr("Import de joueurs"),
+                                          tr("%1 joueurs du fichier sont peut-être déjà inscrits :%2\n\nLes importer quand même ?").arg(similar.size()).arg(list),
+                                          QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
+                {
+                    players.insert(players.end(), similar.begin(), similar.end());
+                }
+            }
+
+            if (!db.AddPlayers(players))
+            {
+                TLogError("Import failed");
+                importNoError = false;
+            }
         }
     }
     else
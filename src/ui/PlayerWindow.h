@@ -6,6 +6,8 @@
 #include "DatePickerWindow.h"
 #include "DbManager.h"
 #include <QTableWidget>
+#include <QCompleter>
+#include <QStringListModel>
 
 class PlayerWindow : public QDialog
 {
@@ -21,11 +23,20 @@ public:
 private slots:
     void slotAddLicence();
     void slotAccept();
+    void slotPostCodeEdited(const QString &text);
 private:
+    static const int cMaxCompletions = 50;
+    static const std::size_t cMaxListed = 10; // similar players listed on import
+
     void GetPlayer(Player &player);
     void SetPlayer(const Player &player);
+    void ShowStats(DbManager &db, int playerId);
+    bool ConfirmDuplicates(DbManager &db, const Player &player);
 
     DatePickerWindow *datePickerWindow;
+    const CityDirectory *mCities; // of the database given to the last dialog
+    QStringListModel mCityModel;
+    QCompleter *mCityCompleter;
 
     Ui::PlayerWindow ui;
 };
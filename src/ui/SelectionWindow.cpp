@@ -26,6 +26,7 @@
 #include "SelectionWindow.h"
 #include "TableHelper.h"
 #include "Log.h"
+#include <iterator>
 
 SelectionWindow::SelectionWindow(QWidget *parent, const QString &title, int minSize, int maxSize)
     : QDialog(parent)
@@ -50,17 +51,16 @@ SelectionWindow::SelectionWindow(QWidget *parent, const QString &title, int minS
 void SelectionWindow::slotFilter()
 {
     QString filter = ui.lineEditFilter->text();
+    bool showAll = filter.isEmpty();
+    const std::unordered_set<int> &matches = mIndex.Find(filter.toStdString());
+
     for( int i = 0; i < ui.playersTable->rowCount(); ++i )
     {
-        bool match = false;
-        for( int j = 0; j < ui.playersTable->columnCount(); ++j )
+        bool match = showAll;
+        if (!match)
         {
-            QTableWidgetItem *item = ui.playersTable->item( i, j );
-            if( item->text().contains(filter, Qt::CaseInsensitive) )
-            {
-                match = true;
-                break;
-            }
+            QTableWidgetItem *item = ui.playersTable->item( i, 0 );
+            match = (matches.count(item->text().toInt()) > 0);
         }
         ui.playersTable->setRowHidden( i, !match );
     }
@@ -82,16 +82,36 @@ void SelectionWindow::StartUpdate(int size)
     ui.selectionList->clear();
 
     mHelper.Initialize(mTableHeader, size);
+    mIndex.Clear();
 }
 
 void SelectionWindow::FinishUpdate()
 {
     mHelper.Finish();
+    // Apply the current filter on the new table contents
+    slotFilter();
 }
 
 void SelectionWindow::AddLeftEntry(const std::list<Value> &rowData)
 {
     mHelper.AppendLine(rowData, false);
+
+    // The first column is the entry id, the other columns are searchable
+    if ((rowData.size() > 0) && (rowData.front().GetType() == Value::INTEGER))
+    {
+        int id = rowData.front().GetInteger();
+        for (auto it = std::next(rowData.begin()); it != rowData.end(); ++it)
+        {
+            if (it->GetType() == Value::INTEGER)
+            {
+                mIndex.Add(id, std::to_string(it->GetInteger()));
+            }
+            else
+            {
+                mIndex.Add(id, it->GetString());
+            }
+        }
+    }
 }
 
 void SelectionWindow::AddRightEntry(const QString &text)
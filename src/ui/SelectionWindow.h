@@ -29,6 +29,7 @@
 #include <QDialog>
 #include "ui_SelectionWindow.h"
 #include "TableHelper.h"
+#include "SearchIndex.h"
 
 class SelectionWindow : public QDialog
 {
@@ -66,6 +67,7 @@ protected:
     Ui::SelectionWindow ui;
 
     TableHelper mHelper;
+    SearchIndex mIndex; // Filter index over the left table entries
     size_t mMinSize;
     size_t mMaxSize;
     QStringList mTableHeader;
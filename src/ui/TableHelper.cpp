@@ -23,13 +23,15 @@
  *=============================================================================
  */
 
-#include <iostream>
 #include <QModelIndex>
 #include <QTableWidgetItem>
 #include <QHeaderView>
 
 #include "TableHelper.h"
+#include "Exporter.h"
 #include "Log.h"
+#include "AsyncLog.h"
+#include "Profiler.h"
 
 
 QStringList InitEventRanking()
@@ -76,7 +78,7 @@ bool TableHelper::GetFirstColumnValue(int &value)
         {
             value = data[0].toInt();
             ret = true;
-            std::cout << "Selected row value: " << value << std::endl;
+            ALogDebug("Selected row value: " << value);
         }
     }
 
@@ -115,6 +117,20 @@ void TableHelper::Finish()
 }
 
 void TableHelper::AppendLine(const std::list<Value> &list, bool selected)
+{
+    SetLine(mRow, list, selected);
+    mRow++;
+}
+
+/**
+ * @brief Disable the sorting while rows are patched, otherwise each cell change moves the row
+ */
+void TableHelper::BeginUpdate()
+{
+    mWidget->setSortingEnabled(false);
+}
+
+void TableHelper::SetLine(int row, const std::list<Value> &list, bool selected)
 {
     int column = 0;
 
@@ -134,74 +150,70 @@ void TableHelper::AppendLine(const std::list<Value> &list, bool selected)
         {
             cell->setBackgroundColor(mSelectedColor);
         }
-        mWidget->setItem(mRow, column, cell);
+        mWidget->setItem(row, column, cell);
         column++;
     }
-    mRow++;
 }
 
-#include <JsonWriter.h>
+int TableHelper::InsertLine(const std::list<Value> &list, bool selected)
+{
+    int row = mWidget->rowCount();
+    mWidget->insertRow(row);
+    SetLine(row, list, selected);
+    return row;
+}
 
-void TableHelper::Export(const QString &fileName)
+void TableHelper::RemoveLine(int row)
+{
+    mWidget->removeRow(row);
+}
+
+/**
+ * @brief Sort again the table (if a sort column has been chosen), without resizing the columns
+ */
+void TableHelper::EndUpdate()
 {
-    // FIXME: detect the output format thanks to the file extension
-    QString ext = QFileInfo(fileName).completeSuffix().toLower();
-    //bool saveInCSV = (ext == "csv");
-    bool saveInJson = (ext == "json");
+    mWidget->setSortingEnabled(true);
+}
 
-    QFile f( fileName );
+void TableHelper::Export(const QString &fileName)
+{
+    TRACE_SCOPE("table.Export");
+    // The output format is detected thanks to the file extension
+    Exporter exporter;
 
-    if (f.open(QFile::WriteOnly))
+    if (exporter.Open(fileName.toStdString(), "rows"))
     {
-        QTextStream data( &f );
-        QStringList strList;
-        QStringList titles;
-
-        JsonArray players;
+        std::vector<std::string> titles;
 
         // Export header title
         for( int c = 0; c < mWidget->columnCount(); ++c )
         {
-            QString title = mWidget->horizontalHeaderItem(c)->data(Qt::DisplayRole).toString();
-            title.replace(" ", "_");
-            title.replace("(", "");
-            title.replace(")", "");
-            title.replace("é", "e");
-            title = title.toLower();
-            titles << title;
+            titles.push_back(mWidget->horizontalHeaderItem(c)->data(Qt::DisplayRole).toString().toStdString());
         }
-
-        data << titles.join(";") << "\n";
+        exporter.SetHeader(titles);
 
         // Export table contents
         for( int r = 0; r < mWidget->rowCount(); ++r )
         {
-            strList.clear();
-            JsonObject player;
+            std::list<Value> row;
             for( int c = 0; c < mWidget->columnCount(); ++c )
             {
-                QString element = mWidget->item( r, c )->text();
-                player.AddValue( titles[c].toStdString(), element.toStdString());
-                strList << element;
+                row.push_back(mWidget->item( r, c )->text().toStdString());
             }
-            players.AddValue(player);
-            data << strList.join( ";" ) + "\n";
+            exporter.AddRow(row);
         }
 
-        JsonObject root;
-        root.AddValue("players", players);
-
-        f.close();
-
-        if (saveInJson)
+        if (!exporter.Close())
         {
-            JsonWriter::SaveToFile(root, fileName.toStdString());
+            TLogError("Export failed: " + fileName.toStdString());
         }
     }
 }
 
-void TableHelper::Show(const std::deque<Player> &players, const std::deque<Team> &teams, bool isSeason, const std::deque<Rank> &list)
+void TableHelper::Show(const PlayerStore &players, const std::deque<Team> &teams, bool isSeason, const std::deque<Rank> &list)
 {
+    TRACE_SCOPE("table.ShowRanking");
     SetSelectedColor(QColor(245,245,220));
     SetAlternateColors(true);
 
@@ -214,17 +226,23 @@ void TableHelper::Show(const std::deque<Player> &players, const std::deque<Team>
         Initialize(gEventRankingTableHeader, list.size());
     }
 
+    IdIndex<Team> teamIds;
+    if (!isSeason)
+    {
+        teamIds.Build(teams);
+    }
+
     int line = 1;
     for (auto &rank : list)
     {
         if (isSeason)
         {
             // Show the whole season ranking
-            Player player;
-            if (Player::Find(players, rank.id, player))
+            std::uint32_t row = players.IndexOf(rank.id);
+            if (row != PlayerStore::cNotFound)
             {
                 int nbGames = rank.gamesWon + rank.gamesLost + rank.gamesDraw;
-                std::list<Value> rowData = {player.id, line, player.FullName(), rank.gamesWon, rank.gamesDraw, rank.gamesLost, rank.pointsWon, rank.pointsLost, rank.Difference(), nbGames};
+                std::list<Value> rowData = {rank.id, line, players.FullName(row), rank.gamesWon, rank.gamesDraw, rank.gamesLost, rank.pointsWon, rank.pointsLost, rank.Difference(), nbGames};
                 AppendLine(rowData, false);
             }
             else
@@ -235,10 +253,10 @@ void TableHelper::Show(const std::deque<Player> &players, const std::deque<Team>
         else
         {
             // Show the event result
-            Team team;
-            if (Team::Find(teams, rank.id, team))
+            const Team *team = teamIds.Find(rank.id);
+            if (team != nullptr)
             {
-                std::list<Value> rowData = {team.id, line, team.number, team.teamName, rank.gamesWon, rank.gamesDraw, rank.gamesLost, rank.pointsWon, rank.pointsLost, rank.Difference(), rank.pointsOpponents};
+                std::list<Value> rowData = {team->id, line, team->number, team->teamName, rank.gamesWon, rank.gamesDraw, rank.gamesLost, rank.pointsWon, rank.pointsLost, rank.Difference(), rank.pointsOpponents};
                 AppendLine(rowData, false);
             }
             else
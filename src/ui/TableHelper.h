@@ -64,11 +64,18 @@ public:
     bool GetFirstColumnValue(int &value);
     void Initialize(const QStringList &header, int rows);
     void AppendLine(const std::list<Value> &list, bool selected);
+
+    // Row level updates on an already filled table
+    void BeginUpdate();
+    void SetLine(int row, const std::list<Value> &list, bool selected);
+    int InsertLine(const std::list<Value> &list, bool selected);
+    void RemoveLine(int row);
+    void EndUpdate();
     void Finish();
     void SetSelectedColor(const QColor &color);
     void SetAlternateColors(bool enable);
     void Export(const QString &fileName);
-    void Show(const std::deque<Player> &players, const std::deque<Team> &teams, bool isSeason, const std::deque<Rank> &list);
+    void Show(const PlayerStore &players, const std::deque<Team> &teams, bool isSeason, const std::deque<Rank> &list);
 
 private:
     QTableWidget *mWidget;
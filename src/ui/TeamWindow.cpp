@@ -33,6 +33,7 @@
 
 TeamWindow::TeamWindow(QWidget *parent)
     : SelectionWindow(parent, tr("Créer/modifier une équipe"), 1, 3)
+    , mPlayers(nullptr)
     , mTeamsId(0U, 2000000U)
     , mIsEdit(false)
 {
@@ -93,20 +94,26 @@ void TeamWindow::slotAccept()
 }
 
 
-void TeamWindow::SetTeam(const Player &p1, const Player &p2, const Team &team)
+void TeamWindow::SetTeam(const Team &team)
 {
     mSelection.clear();
-    mSelection.push_back(p1);
-    mSelection.push_back(p2);
+    for (int id : { team.player1Id, team.player2Id })
+    {
+        std::uint32_t row = mPlayers->IndexOf(id);
+        if (row != PlayerStore::cNotFound)
+        {
+            mSelection.push_back(row);
+        }
+    }
 
     SetName(team.teamName.c_str());
     SetNumber(team.number);
     Update();
 }
 
-std::string TeamWindow::GetMinifiedName(const Player &p)
+std::string TeamWindow::GetMinifiedName(std::uint32_t row)
 {
-    return p.name + " " + p.lastName.substr(0, 3);
+    return std::string(mPlayers->GetName(row)) + " " + std::string(mPlayers->GetLastName(row)).substr(0, 3);
 }
 
 void TeamWindow::GetTeam(Team &team)
@@ -115,9 +122,9 @@ void TeamWindow::GetTeam(Team &team)
 
     if (mSelection.size() == 3)
     {
-        team.player1Id = mSelection.at(0).id;
-        team.player2Id = mSelection.at(1).id;
-        team.player3Id = mSelection.at(2).id;
+        team.player1Id = mPlayers->GetId(mSelection.at(0));
+        team.player2Id = mPlayers->GetId(mSelection.at(1));
+        team.player3Id = mPlayers->GetId(mSelection.at(2));
 
         proposedTeamName = GetMinifiedName(mSelection.at(0)) + " " +
                     GetMinifiedName(mSelection.at(1)) + " " +
@@ -125,15 +132,15 @@ void TeamWindow::GetTeam(Team &team)
     }
     else if (mSelection.size() == 2)
     {
-        team.player1Id = mSelection.at(0).id;
-        team.player2Id = mSelection.at(1).id;
+        team.player1Id = mPlayers->GetId(mSelection.at(0));
+        team.player2Id = mPlayers->GetId(mSelection.at(1));
 
         proposedTeamName = GetMinifiedName(mSelection.at(0)) + " " +
                     GetMinifiedName(mSelection.at(1));
     }
     else if (mSelection.size() == 1)
     {
-        team.player1Id = mSelection.at(0).id;
+        team.player1Id = mPlayers->GetId(mSelection.at(0));
         team.player2Id = Player::cDummyPlayer;
 
         proposedTeamName = GetMinifiedName(mSelection.at(0));
@@ -157,17 +164,17 @@ void TeamWindow::GetTeam(Team &team)
     }
 }
 
-void TeamWindow::Initialize(const std::deque<Player> &players, const std::deque<int> &inTeams, bool isEdit)
+void TeamWindow::Initialize(const PlayerStore &players, const std::deque<int> &inTeams, bool isEdit)
 {
     // Create a list of players that are still alone
+    mPlayers = &players;
     mList.clear();
-    for (auto const & p : players)
+    for (std::uint32_t row = 0U; row < players.Size(); row++)
     {
         // This player has no team, add it to the list of available players
-        //if (!inTeams.contains(p.id))
-        if (std::find(inTeams.begin(), inTeams.end(), p.id) == inTeams.end())
+        if (std::find(inTeams.begin(), inTeams.end(), players.GetId(row)) == inTeams.end())
         {
-            mList.push_back(p);
+            mList.push_back(row);
         }
     }
 
@@ -188,9 +195,9 @@ void TeamWindow::Initialize(const std::deque<Player> &players, const std::deque<
 
 void TeamWindow::ClickedRight(int index)
 {
-    const Player &p = mSelection.at(index);
+    std::uint32_t row = mSelection.at(index);
     // transfer to the left
-    mList.push_back(p);
+    mList.push_back(row);
     mSelection.erase(mSelection.begin() + index);
 
     Update();
@@ -198,16 +205,12 @@ void TeamWindow::ClickedRight(int index)
 
 void TeamWindow::ClickedLeft(int id)
 {
-    Player p;
-    if (Player::Find(mList, id, p) && (mSelection.size() < GetMaxSize()))
+    auto it = std::find_if(mList.begin(), mList.end(), [this, id](std::uint32_t row) { return mPlayers->GetId(row) == id; });
+    if ((it != mList.end()) && (mSelection.size() < GetMaxSize()))
     {
         // transfer to the right and remove the player from the list
-        mSelection.push_back(p);
-        int index;
-        if (Player::Index(mList, id, index))
-        {
-            mList.erase(mList.begin() + index);
-        }
+        mSelection.push_back(*it);
+        mList.erase(it);
     }
 
     Update();
@@ -222,15 +225,15 @@ void TeamWindow::Update()
 {
     StartUpdate(mList.size());
 
-    foreach (Player p, mList)
+    for (auto row : mList)
     {
-        std::list<Value> rowData = {p.id, p.name, p.lastName, p.nickName};
+        std::list<Value> rowData = {mPlayers->GetId(row), std::string(mPlayers->GetName(row)), std::string(mPlayers->GetLastName(row)), std::string(mPlayers->GetNickName(row))};
         AddLeftEntry(rowData);
     }
 
-    foreach (Player p, mSelection)
+    for (auto row : mSelection)
     {
-        AddRightEntry(p.FullName().c_str());
+        AddRightEntry(mPlayers->FullName(row).c_str());
     }
 
     if (mSelection.size())
@@ -37,10 +37,10 @@ class TeamWindow : public SelectionWindow
 public:
     TeamWindow(QWidget *parent);
 
-    void SetTeam(const Player &p1, const Player &p2, const Team &team);
+    void SetTeam(const Team &team);
     void GetTeam(Team &team);
 
-    void Initialize(const std::deque<Player> &players, const std::deque<int> &inTeams, bool isEdit);
+    void Initialize(const PlayerStore &players, const std::deque<int> &inTeams, bool isEdit);
 
     void ClickedRight(int index);
     void ClickedLeft(int id);
@@ -53,13 +53,14 @@ private slots:
     void slotAccept();
 
 private:
-    std::deque<Player> mList;
-    std::deque<Player> mSelection;
+    const PlayerStore *mPlayers;
+    std::deque<std::uint32_t> mList;      // rows of the player store
+    std::deque<std::uint32_t> mSelection;
     UniqueId mTeamsId;
     bool mIsEdit;
 
     void Update();
-    std::string GetMinifiedName(const Player &p);
+    std::string GetMinifiedName(std::uint32_t row);
 };
 
 #endif // TEAM_WINDOW_H
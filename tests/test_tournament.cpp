@@ -1,20 +1,25 @@
-
 #include <iostream>
 #include <fstream>
 #include <algorithm>
 #include <sstream>
 #include <random>
-
-#include <QJsonObject>
-#include <QJsonValue>
-#include <QJsonDocument>
+#include <map>
+#include <cassert>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 
 #include "Tournament.h"
-#include "DbManager.h"
-#include "Log.h"
 #include "Brackets.h"
-
-void ReadFile(const std::string &filename, std::vector<std::string> &output)
+#include "LabelCache.h"
+#include "RoundRobin.h"
+#include "ScoreLog.h"
+#include "CourtAllocator.h"
+#include "DuplicateDetector.h"
+#include "SearchIndex.h"
+#include "SeasonArchive.h"
+
+static void ReadFile(const std::string &filename, std::vector<std::string> &output)
 {
     std::string line;
     std::ifstream ifs(filename);
@@ -25,15 +30,20 @@ void ReadFile(const std::string &filename, std::vector<std::string> &output)
 }
 
 
-std::string GenerateName(const std::vector<std::string> &first_names, const std::vector<std::string> &last_names)
+static std::string GenerateName(const std::vector<std::string> &first_names, const std::vector<std::string> &last_names)
 {
-    int first = Tournament::Generate(0, first_names.size());
-    int last = Tournament::Generate(0, last_names.size());
+    if (first_names.empty() || last_names.empty())
+    {
+        return "Team";
+    }
+
+    int first = Tournament::Generate(0, first_names.size() - 1);
+    int last = Tournament::Generate(0, last_names.size() - 1);
 
     return first_names[first] + " " + last_names[last];
 }
 
-void GenerateTeams(QList<Team> &t, int size, const std::vector<std::string> &first_names, const std::vector<std::string> &last_names)
+static void GenerateTeams(std::deque<Team> &t, int size, const std::vector<std::string> &first_names, const std::vector<std::string> &last_names)
 {
     static int teamIds = 0;
 
@@ -42,7 +52,7 @@ void GenerateTeams(QList<Team> &t, int size, const std::vector<std::string> &fir
         Team team;
         team.eventId = 0;
         team.id = teamIds;
-        team.teamName = QString(GenerateName(first_names, last_names).c_str());
+        team.teamName = GenerateName(first_names, last_names);
 
         t.push_back(team);
 
@@ -50,51 +60,51 @@ void GenerateTeams(QList<Team> &t, int size, const std::vector<std::string> &fir
     }
 }
 
-void DumpTeams(const QList<Team> &t)
+static void DumpTeams(const std::deque<Team> &t)
 {
-    for(int i = 0; i < t.size(); i++)
+    for (auto const &team : t)
     {
-        std::cout << "(" << t.at(i).id  << ") " << t.at(i).teamName.toStdString() << std::endl;
+        std::cout << "(" << team.id  << ") " << team.teamName << std::endl;
     }
 }
 
-void DumpGames(const QList<Game> &g, const QList<Team> &teams)
+static void DumpGames(const std::deque<Game> &g, const std::deque<Team> &teams)
 {
-    for(int i = 0; i < g.size(); i++)
+    for (auto const &game : g)
     {
         Team team1;
         Team team2;
 
-        Team::Find(teams, g.at(i).team1Id, team1);
-        Team::Find(teams, g.at(i).team2Id, team2);
-        std::cout << "Turn: " << g.at(i).turn  << ", Game (id: " << g.at(i).id << ") "
-                  << " (id: " << team1.id << ") " << team1.teamName.toStdString() << " (" << g.at(i).team1Score << ") <-> "
-                  << " (id: " << team2.id << ") " << team2.teamName.toStdString() << " (" << g.at(i).team2Score << ")" << std::endl;
+        Team::Find(teams, game.team1Id, team1);
+        Team::Find(teams, game.team2Id, team2);
+        std::cout << "Turn: " << game.turn  << ", Game (id: " << game.id << ") "
+                  << " (id: " << team1.id << ") " << team1.teamName << " (" << game.team1Score << ") <-> "
+                  << " (id: " << team2.id << ") " << team2.teamName << " (" << game.team2Score << ")" << std::endl;
     }
 }
 
-void PlayGames(QList<Game> &g)
+static void PlayGames(std::deque<Game> &g)
 {
     static int gameIds = 0;
 
-    for(int i = 0; i < g.size(); i++)
+    for (auto &game : g)
     {
         // FIXME: special score for bye team (won 13-7)
 
-        g[i].team1Score = Tournament::Generate(0, 12);
-        g[i].team2Score = 13;
-        g[i].id = gameIds;
+        game.team1Score = Tournament::Generate(0, 12);
+        game.team2Score = 13;
+        game.id = gameIds;
         gameIds++;
     }
 }
 
-void RandomMatches()
+static void RandomMatches()
 {
     std::vector<std::string> first_names;
     std::vector<std::string> last_names;
 
-    QList<Team> teams;
-    QList<Game> games;
+    std::deque<Team> teams;
+    std::deque<Game> games;
 
     ReadFile("../../tests/first_names.txt", first_names);
     ReadFile("../../tests/last_names.txt", last_names);
@@ -107,8 +117,8 @@ void RandomMatches()
     int turns = 0;
     while(1)
     {
-        QList<Game> newGames;
-        QString result = trn.BuildSwissRounds(games, teams, newGames);
+        std::deque<Game> newGames;
+        std::string result = trn.BuildSwissRounds(games, teams, newGames);
 
         // Print ranking for turns after the first one
         std::cout << "------------- RANKING -----------------" << std::endl;
@@ -119,19 +129,20 @@ void RandomMatches()
             break;
         }
 
-        std::cout << "SwissRound result: " << result.toStdString() << std::endl;
+        std::cout << "SwissRound result: " << result << std::endl;
+        assert(newGames.size() == 5U);
         PlayGames(newGames);
-        games.append(newGames);
+        games.insert(games.end(), newGames.begin(), newGames.end());
         DumpGames(games, teams);
         turns++;
     }
 }
 
 
-void PairingProblem()
+static void PairingProblem()
 {
-    QList<Team> teams;
-    QList<Game> games;
+    std::deque<Team> teams;
+    std::deque<Game> games;
 
     // Add the games of the first round
     Game gamesTurn0[5] = {
@@ -169,8 +180,8 @@ void PairingProblem()
 
     while(1)
     {
-        QList<Game> newGames;
-        QString result = trn.BuildSwissRounds(games, teams, newGames);
+        std::deque<Game> newGames;
+        std::string result = trn.BuildSwissRounds(games, teams, newGames);
 
         // Print ranking for turns after the first one
         std::cout << "------------- RANKING -----------------" << std::endl;
@@ -181,18 +192,669 @@ void PairingProblem()
             break;
         }
 
-        std::cout << "SwissRound result: " << result.toStdString() << std::endl;
+        std::cout << "SwissRound result: " << result << std::endl;
         PlayGames(newGames);
-        games.append(newGames);
+        games.insert(games.end(), newGames.begin(), newGames.end());
         DumpGames(games, teams);
         turns++;
     }
 
 }
 
+static void KnockoutBracket()
+{
+    // 512 teams seeded from a ranking, the best seed always wins
+    std::deque<Team> teams;
+    std::deque<Rank> ranking;
+    for (int i = 1; i <= 512; i++)
+    {
+        Team team;
+        team.id = i;
+        team.number = i;
+        teams.push_back(team);
+
+        Rank rank;
+        rank.id = i;
+        ranking.push_back(rank);
+    }
+
+    for (int doubleElimination = 0; doubleElimination < 2; doubleElimination++)
+    {
+        Bracket bracket;
+        bracket.Build(Bracket::Seeds(ranking, teams), doubleElimination == 1, 0);
+
+        int played = 0;
+        std::vector<std::uint32_t> matches = bracket.GetMatchesToPlay();
+        while (matches.size() > 0U)
+        {
+            for (auto match : matches)
+            {
+                const Bracket::Match &m = bracket.GetMatch(match);
+                std::vector<std::uint32_t> changed;
+                bracket.SetGameId(match, played++);
+                bracket.SetResult(match, std::min(m.team1, m.team2), changed);
+            }
+            matches = bracket.GetMatchesToPlay();
+        }
+
+        assert(bracket.GetChampion() == 1);
+        assert(played == ((doubleElimination == 1) ? 1022 : 511));
+    }
+}
+
+static void DummyTeamName()
+{
+    // A team of one: the second player is the dummy one, always known
+    Player player;
+    player.id = 12;
+    player.name = "Jean";
+    player.lastName = "Dupont";
+
+    PlayerStore players;
+    players.Add(player);
+    players.Finish();
+
+    Team team;
+    team.id = 3;
+    team.player1Id = player.id;
+
+    assert(players.Contains(team.player1Id) && players.Contains(team.player2Id));
+    assert(players.Size() == 1U);
+
+    LabelCache labels;
+    assert(labels.TeamName(players, team) == LabelCache::DefaultTeamName(player, Player::Dummy()));
+    assert(labels.PlayerName(players, Player::cDummyPlayer) == Player::Dummy().FullName());
+}
+
+static std::deque<Team> MakeTeams(int count, int eventId)
+{
+    std::deque<Team> teams;
+    for (int i = 0; i < count; i++)
+    {
+        Team team;
+        team.id = 100 + i;
+        team.eventId = eventId;
+        team.number = i + 1;
+        teams.push_back(team);
+    }
+    return teams;
+}
+
+static void RoundRobinPairs()
+{
+    for (int count : { 2, 3, 7, 8, 16, 17 })
+    {
+        std::deque<Team> teams = MakeTeams(count, 5);
+        RoundRobin schedule(static_cast<std::uint32_t>(count));
+        std::uint32_t rounds = schedule.RoundsPerCycle();
+
+        // First cycle: every pair meets exactly once, each team plays once per round
+        std::map<std::pair<int, int>, int> meetings;
+        std::map<std::pair<int, int>, int> homes;
+        std::map<int, int> byes;
+        std::map<int, std::vector<int>> played; // turn -> teams
+        std::uint64_t games = 0U;
+
+        RoundRobinStream stream(teams, 0U, rounds);
+        for (Game *game = stream.Next(); game != nullptr; game = stream.Next())
+        {
+            games++;
+            assert(game->eventId == 5);
+            if (game->HasBye())
+            {
+                byes[game->GetByeTeam()]++;
+            }
+            else
+            {
+                meetings[std::make_pair(std::min(game->team1Id, game->team2Id), std::max(game->team1Id, game->team2Id))]++;
+                homes[std::make_pair(game->team1Id, game->team2Id)]++;
+            }
+
+            for (int id : { game->team1Id, game->team2Id })
+            {
+                if (id != Team::cDummyTeam)
+                {
+                    std::vector<int> &round = played[game->turn];
+                    assert(std::find(round.begin(), round.end(), id) == round.end());
+                    round.push_back(id);
+                }
+            }
+        }
+
+        assert(games == RoundRobinStream(teams, 0U, rounds).GetTotal());
+        assert(meetings.size() == static_cast<std::size_t>(count * (count - 1) / 2));
+        for (auto const &m : meetings)
+        {
+            assert(m.second == 1);
+        }
+        assert(byes.size() == (((count % 2) == 1) ? static_cast<std::size_t>(count) : 0U));
+        for (auto const &b : byes)
+        {
+            assert(b.second == 1);
+        }
+
+        // Return legs: the same games, home and away swapped
+        RoundRobinStream returns(teams, rounds, rounds);
+        for (Game *game = returns.Next(); game != nullptr; game = returns.Next())
+        {
+            if (!game->HasBye())
+            {
+                assert(homes.count(std::make_pair(game->team2Id, game->team1Id)) == 1U);
+            }
+        }
+    }
+}
+
+static void CompareRankings(Tournament &tournament, LiveStandings &standings, const std::deque<Game> &games, const std::deque<Team> &teams)
+{
+    tournament.GenerateTeamRanking(games, teams, INT_MAX);
+    std::deque<Rank> full = tournament.GetRanking();
+    std::deque<Rank> live = standings.GetRanking();
+
+    assert(full.size() == live.size());
+    for (std::size_t i = 1U; i < live.size(); i++)
+    {
+        // Same order, up to the teams that cannot be told apart
+        assert(!RankHighFirst(live[i], live[i - 1U]));
+        assert(!RankHighFirst(full[i], full[i - 1U]));
+    }
+
+    auto byId = [](const Rank &a, const Rank &b) { return a.id < b.id; };
+    std::sort(full.begin(), full.end(), byId);
+    std::sort(live.begin(), live.end(), byId);
+    for (std::size_t i = 0U; i < live.size(); i++)
+    {
+        assert(full[i].id == live[i].id);
+        assert(full[i].gamesWon == live[i].gamesWon);
+        assert(full[i].gamesLost == live[i].gamesLost);
+        assert(full[i].gamesDraw == live[i].gamesDraw);
+        assert(full[i].pointsWon == live[i].pointsWon);
+        assert(full[i].pointsLost == live[i].pointsLost);
+        assert(full[i].pointsOpponents == live[i].pointsOpponents);
+    }
+}
+
+static void LiveStandingsReplay()
+{
+    // Odd field: some games are byes
+    std::deque<Team> teams = MakeTeams(9, 7);
+    std::deque<Game> games;
+    std::deque<ScoreEntry> log;
+    std::mt19937 gen(42U);
+    std::uniform_int_distribution<int> score(0, 13);
+    std::uniform_int_distribution<int> action(0, 9);
+
+    Tournament tournament;
+    LiveStandings standings;
+    standings.Reset(teams);
+
+    auto write = [&](const Game &before, const Game &after, int kind, std::int64_t undoOf) {
+        ScoreEntry entry;
+        entry.seq = static_cast<std::int64_t>(log.size()) + 1;
+        entry.eventId = after.eventId;
+        entry.gameId = after.id;
+        entry.kind = kind;
+        entry.turn = after.turn;
+        entry.team1Id = after.team1Id;
+        entry.team2Id = after.team2Id;
+        entry.oldScore1 = before.team1Score;
+        entry.oldScore2 = before.team2Score;
+        entry.newScore1 = after.team1Score;
+        entry.newScore2 = after.team2Score;
+        entry.undoOf = undoOf;
+        log.push_back(entry);
+        standings.Apply(entry);
+    };
+
+    int nextId = 1;
+    RoundRobinStream stream(teams, 0U, 9U);
+    for (Game *g = stream.Next(); g != nullptr; g = stream.Next())
+    {
+        Game game = *g;
+        game.id = nextId++;
+        game.team1Score = -1;
+        game.team2Score = -1;
+        write(game, game, ScoreEntry::cAdded, 0);
+        games.push_back(game);
+
+        Game scored = game;
+        scored.team1Score = score(gen);
+        scored.team2Score = score(gen);
+        write(game, scored, ScoreEntry::cScored, 0);
+        games.back() = scored;
+        CompareRankings(tournament, standings, games, teams);
+
+        int a = action(gen);
+        if (a < 2)
+        {
+            // Correction of a random game
+            Game &edited = games[std::uniform_int_distribution<std::size_t>(0U, games.size() - 1U)(gen)];
+            Game corrected = edited;
+            corrected.team1Score = score(gen);
+            corrected.team2Score = score(gen);
+            write(edited, corrected, ScoreEntry::cScored, 0);
+            edited = corrected;
+        }
+        else if (a < 4)
+        {
+            // Undo of the last score change still in effect
+            ScoreEntry last;
+            if (ScoreEntry::FindUndo(log, last))
+            {
+                auto it = std::find_if(games.begin(), games.end(), [&last](const Game &x) { return x.id == last.gameId; });
+                assert(it != games.end());
+                Game undone = *it;
+                undone.team1Score = last.oldScore1;
+                undone.team2Score = last.oldScore2;
+                write(*it, undone, ScoreEntry::cScored, last.seq);
+                *it = undone;
+            }
+        }
+        else if (a == 4)
+        {
+            // A game removed
+            std::size_t index = std::uniform_int_distribution<std::size_t>(0U, games.size() - 1U)(gen);
+            write(games[index], games[index], ScoreEntry::cDeleted, 0);
+            games.erase(games.begin() + static_cast<std::ptrdiff_t>(index));
+        }
+        CompareRankings(tournament, standings, games, teams);
+    }
+
+    // The whole log applied at once gives the same standings
+    LiveStandings replay;
+    replay.Reset(teams);
+    replay.Apply(log);
+    assert(replay.GetCursor() == static_cast<std::int64_t>(log.size()));
+    CompareRankings(tournament, replay, games, teams);
+}
+
+static int NaiveEditDistance(const std::string &a, const std::string &b)
+{
+    std::vector<int> row(b.size() + 1U);
+    for (std::size_t j = 0U; j <= b.size(); j++)
+    {
+        row[j] = static_cast<int>(j);
+    }
+
+    for (std::size_t i = 1U; i <= a.size(); i++)
+    {
+        int diagonal = row[0];
+        row[0] = static_cast<int>(i);
+        for (std::size_t j = 1U; j <= b.size(); j++)
+        {
+            int up = row[j];
+            row[j] = std::min({ row[j] + 1, row[j - 1U] + 1, diagonal + ((a[i - 1U] == b[j - 1U]) ? 0 : 1) });
+            diagonal = up;
+        }
+    }
+    return row[b.size()];
+}
+
+static void EditDistances()
+{
+    assert(DuplicateDetector::EditDistance("", "") == 0);
+    assert(DuplicateDetector::EditDistance("dupont", "") == 6);
+    assert(DuplicateDetector::EditDistance("dupont", "dupond") == 1);
+    assert(DuplicateDetector::EditDistance("martin", "matrin") == 2);
+    assert(DuplicateDetector::EditDistance("kitten", "sitting") == 3);
+
+    // Short strings (one machine word) and long ones, small alphabet for many matches
+    std::mt19937 gen(7U);
+    std::uniform_int_distribution<int> letter('a', 'c');
+    for (int i = 0; i < 2000; i++)
+    {
+        std::string a(std::uniform_int_distribution<std::size_t>(0U, (i < 1000) ? 20U : 100U)(gen), ' ');
+        std::string b(std::uniform_int_distribution<std::size_t>(0U, (i < 1000) ? 20U : 100U)(gen), ' ');
+        for (auto &c : a) { c = static_cast<char>(letter(gen)); }
+        for (auto &c : b) { c = static_cast<char>(letter(gen)); }
+
+        int expected = NaiveEditDistance(a, b);
+        assert(DuplicateDetector::EditDistance(a, b) == expected);
+        assert(DuplicateDetector::EditDistance(b, a) == expected);
+    }
+}
+
+static void PlayerSearch()
+{
+    // Four blocks per player: the first players are merged, the last one is not
+    const int count = static_cast<int>(DuplicateDetector::cMaxRecent) + 1;
+    SearchIndex index;
+    DuplicateDetector duplicates;
+
+    for (int i = 0; i < count; i++)
+    {
+        Player player;
+        player.id = i + 1;
+        player.name = "Jean";
+        player.lastName = "Martin" + std::to_string(i);
+        player.mobilePhone = "06 12 " + std::to_string(100000 + i);
+        index.Add(player);
+        duplicates.Add(player);
+    }
+
+    for (int i : { 0, count - 1 })
+    {
+        Player query;
+        query.name = "jean";
+        query.lastName = "MARTIN" + std::to_string(i);
+        assert(duplicates.HasName(query));
+
+        std::vector<DuplicateMatch> matches = duplicates.Find(query);
+        assert(!matches.empty() && (matches[0].playerId == (i + 1)) && (matches[0].reasons == DuplicateMatch::cSameName));
+
+        query.mobilePhone = "0612" + std::to_string(100000 + i);
+        matches = duplicates.Find(query);
+        assert(matches[0].reasons == (DuplicateMatch::cSameName | DuplicateMatch::cSamePhone));
+    }
+
+    assert(index.Find("martin409").size() == 8U); // 409, 4090 to 4096
+    assert((index.Find("Martin4096").size() == 1U) && (index.Find("0612104096").count(count) == 1U));
+
+    // A field added to an old entry, then an entry with a smaller id
+    index.Add(1, "Licence été");
+    assert((index.Find("ete").count(1) == 1U) && (index.Find("martin0").count(1) == 1U));
+    index.Add(-5, "Zoé");
+    index.Finish();
+    assert((index.Find("zoe").size() == 1U) && (index.Find("zoe").count(-5) == 1U));
+    assert(index.Find("licence").size() == 1U);
+}
+
+static void CourtRotation()
+{
+    // 10 teams, 5 games per round on 4 courts: two waves per round
+    const std::uint32_t courts = 4U;
+    std::deque<Team> teams = MakeTeams(10, 9);
+    RoundRobinStream games(teams, 0U, 9U);
+    CourtAllocator allocator(courts);
+    CourtStream stream(allocator, [&games]() { return games.Next(); });
+
+    std::map<int, std::vector<int>> history; // team id -> games on each court, previous rounds
+    std::vector<Game> round;
+
+    auto check = [&]() {
+        std::uint32_t waves = (static_cast<std::uint32_t>(round.size()) + courts - 1U) / courts;
+        std::vector<std::uint32_t> used(courts, 0U);
+        for (auto const &game : round)
+        {
+            used[CourtAllocator::GetCourt(game) - 1]++;
+        }
+
+        for (auto const &game : round)
+        {
+            auto cost = [&](int court) {
+                return history[game.team1Id][court] + history[game.team2Id][court];
+            };
+            int court = CourtAllocator::GetCourt(game) - 1;
+
+            // Never a court already used by the teams while a better one is free
+            for (std::uint32_t c = 0U; c < courts; c++)
+            {
+                assert(!((used[c] < waves) && (cost(static_cast<int>(c)) < cost(court))));
+            }
+        }
+
+        for (auto const &game : round)
+        {
+            history[game.team1Id][CourtAllocator::GetCourt(game) - 1]++;
+            history[game.team2Id][CourtAllocator::GetCourt(game) - 1]++;
+        }
+        round.clear();
+    };
+
+    for (auto const &team : teams)
+    {
+        history[team.id].assign(courts, 0);
+    }
+
+    for (Game *game = stream.Next(); game != nullptr; game = stream.Next())
+    {
+        int court = CourtAllocator::GetCourt(*game);
+        assert((court >= 1) && (court <= static_cast<int>(courts)));
+        if (!round.empty() && (round.front().turn != game->turn))
+        {
+            check();
+        }
+        round.push_back(*game);
+    }
+    check();
+
+    // Enough courts for the first rounds: no team plays twice on the same court
+    CourtAllocator wide(8U);
+    std::deque<Game> first;
+    RoundRobinStream four(teams, 0U, 4U);
+    for (Game *game = four.Next(); game != nullptr; game = four.Next())
+    {
+        first.push_back(*game);
+    }
+    wide.Assign(first);
+
+    std::map<int, std::vector<int>> courtsOf;
+    for (auto const &game : first)
+    {
+        for (int id : { game.team1Id, game.team2Id })
+        {
+            std::vector<int> &list = courtsOf[id];
+            assert(std::find(list.begin(), list.end(), CourtAllocator::GetCourt(game)) == list.end());
+            list.push_back(CourtAllocator::GetCourt(game));
+        }
+    }
+}
+
+static std::vector<char> ReadBytes(const char *fileName)
+{
+    std::ifstream file(fileName, std::ios::binary);
+    return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// Write the bytes as an archive and try to open it
+static bool OpenArchive(const std::vector<char> &bytes, std::size_t size)
+{
+    static const char *cFileName = "test_corrupted.tca";
+    {
+        std::ofstream file(cFileName, std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), static_cast<std::streamsize>(size));
+    }
+
+    SeasonArchive archive;
+    bool opened = archive.Open(cFileName);
+    if (opened)
+    {
+        // Everything can be read once opened
+        for (auto const &e : archive.GetEvents())
+        {
+            (void) archive.GetTeams(e.id);
+            (void) archive.GetGames(e.id);
+        }
+        (void) archive.GetGamesByTeamId(20);
+    }
+    archive.Close();
+    std::remove(cFileName);
+    return opened;
+}
+
+// Header: magic, version, byte order, year, 4 counts (32 bytes), then the offsets and the sizes of the columns
+static std::size_t ColumnOffset(const std::vector<char> &bytes, int column)
+{
+    std::uint64_t offset;
+    std::memcpy(&offset, &bytes[32U + (8U * static_cast<std::size_t>(column))], sizeof(offset));
+    return static_cast<std::size_t>(offset);
+}
+
+static void Patch(std::vector<char> &bytes, std::size_t position, std::uint32_t value)
+{
+    std::memcpy(&bytes[position], &value, sizeof(value));
+}
+
+static void ArchiveRoundTrip()
+{
+    static const char *cFileName = "test_archive.tca";
+
+    std::deque<Event> events;
+    for (int id : { 3, 1 })
+    {
+        Event event;
+        event.id = id;
+        event.date = std::chrono::system_clock::time_point(std::chrono::seconds(1700000000 + id));
+        event.title = "Concours de l'été " + std::to_string(id);
+        event.type = Event::cSwissRounds;
+        event.state = Event::cStarted;
+        event.document = (id == 1) ? "{\"courts\":4}" : "";
+        events.push_back(event);
+    }
+
+    std::deque<Team> teams;
+    for (int i = 0; i < 6; i++)
+    {
+        Team team;
+        team.id = 25 - i;
+        team.eventId = (i < 4) ? 1 : 3;
+        team.number = i + 1;
+        team.player1Id = 500 + i;
+        team.player2Id = (i == 2) ? Player::cDummyPlayer : 600 + i;
+        team.teamName = (i < 2) ? "Les boulistes" : "Équipe " + std::to_string(i);
+        teams.push_back(team);
+    }
+
+    std::deque<Game> games;
+    int ids[][3] = { { 25, 24, 1 }, { 23, 22, 1 }, { 25, 23, 2 }, { 24, Team::cDummyTeam, 2 }, { 21, 20, 1 }, { 20, 99, 2 } };
+    for (auto const &g : ids)
+    {
+        Game game = Game();
+        game.id = static_cast<int>(games.size()) + 40;
+        game.eventId = (g[0] >= 22) ? 1 : 3;
+        game.turn = g[2];
+        game.team1Id = g[0];
+        game.team2Id = g[1];
+        game.team1Score = 13;
+        game.team2Score = static_cast<int>(games.size());
+        games.push_back(game);
+    }
+
+    assert(SeasonArchive::Write(cFileName, 2023, events, teams, games));
+
+    {
+        SeasonArchive archive;
+        assert(archive.Open(cFileName));
+        assert(archive.GetYear() == 2023);
+        assert((archive.EventCount() == 2U) && (archive.TeamCount() == 6U) && (archive.GameCount() == 6U));
+
+        std::deque<Event> readEvents = archive.GetEvents();
+        assert((readEvents.size() == 2U) && (readEvents[0].id == 1) && (readEvents[1].id == 3));
+        for (auto const &e : readEvents)
+        {
+            const Event &written = (e.id == 1) ? events[1] : events[0];
+            assert(e.title == written.title);
+            assert(e.document == written.document);
+            assert((e.type == written.type) && (e.state == written.state) && (e.option == written.option));
+            assert(e.date == written.date);
+            assert(archive.HasEvent(e.id));
+        }
+        assert(!archive.HasEvent(2));
+
+        // Teams of an event, by id
+        std::deque<Team> readTeams = archive.GetTeams(1);
+        assert(readTeams.size() == 4U);
+        for (std::size_t i = 0U; i < readTeams.size(); i++)
+        {
+            const Team *written = Team::Find(teams, readTeams[i].id);
+            assert(written != nullptr);
+            assert((i == 0U) || (readTeams[i - 1U].id < readTeams[i].id));
+            assert(readTeams[i].eventId == 1);
+            assert(readTeams[i].teamName == written->teamName);
+            assert((readTeams[i].number == written->number) && (readTeams[i].player1Id == written->player1Id) &&
+                   (readTeams[i].player2Id == written->player2Id) && (readTeams[i].player3Id == written->player3Id));
+        }
+
+        // Games by event, the team ids come back from the team rows
+        std::deque<Game> readGames = archive.GetGames(1);
+        assert(readGames.size() == 4U);
+        for (auto const &g : readGames)
+        {
+            const Game *written = Game::Find(games, g.id);
+            assert(written != nullptr);
+            assert((g.team1Id == written->team1Id) && (g.team2Id == written->team2Id));
+            assert((g.team1Score == written->team1Score) && (g.team2Score == written->team2Score) && (g.turn == written->turn));
+        }
+
+        // A team outside of the archive is lost
+        Game game;
+        assert(archive.GetGame(45, game) && (game.team1Id == 20) && (game.team2Id == -1));
+        assert(!archive.GetGame(46, game));
+
+        std::deque<Game> byTeam = archive.GetGamesByTeamId(25);
+        assert(byTeam.size() == 2U);
+        assert(archive.GetGamesByTeamId(24).size() == 2U); // the bye too
+        assert(archive.GetGamesByTeamId(99).empty());
+        assert(archive.GetTeamsByPlayerId(502).size() == 1U);
+        assert(archive.GetTeamsByPlayerId(Player::cDummyPlayer).size() == 6U);
+    }
+
+    std::vector<char> bytes = ReadBytes(cFileName);
+    std::remove(cFileName);
+    assert(OpenArchive(bytes, bytes.size()));
+
+    // Truncated anywhere
+    for (std::size_t size = 0U; size < bytes.size(); size++)
+    {
+        assert(!OpenArchive(bytes, size));
+    }
+
+    // Header
+    std::vector<char> bad = bytes;
+    bad[0] = 'X';
+    assert(!OpenArchive(bad, bad.size()));
+    for (std::size_t field : { 4U, 8U, 16U, 20U, 24U, 28U })
+    {
+        // version, byte order, counts
+        bad = bytes;
+        Patch(bad, field, 0x40000001U);
+        assert(!OpenArchive(bad, bad.size()));
+    }
+
+    // A column out of the file
+    bad = bytes;
+    Patch(bad, 32U + (8U * SeasonArchive::cGameScore1), 0xFFFFFFF8U);
+    assert(!OpenArchive(bad, bad.size()));
+    bad = bytes;
+    Patch(bad, 32U + (8U * SeasonArchive::cColumnCount) + (8U * SeasonArchive::cStringData), 0xFFFFFFF0U);
+    assert(!OpenArchive(bad, bad.size()));
+
+    // String offsets: decreasing, or past the data
+    std::size_t strings = ColumnOffset(bytes, SeasonArchive::cStringOffset);
+    bad = bytes;
+    Patch(bad, strings + 8U, 0xFFFFFFF0U);
+    assert(!OpenArchive(bad, bad.size()));
+    bad = bytes;
+    Patch(bad, strings + 4U, 0U);
+    Patch(bad, strings + 8U, 0U);
+    assert(OpenArchive(bad, bad.size())); // empty strings are valid
+    bad = bytes;
+    Patch(bad, ColumnOffset(bytes, SeasonArchive::cTeamName), 0x7FFFFFFFU);
+    assert(OpenArchive(bad, bad.size())); // unknown string index: empty name
+
+    // Team indexes of the games
+    for (int column : { SeasonArchive::cGameTeam1, SeasonArchive::cGameTeam2 })
+    {
+        bad = bytes;
+        Patch(bad, ColumnOffset(bytes, column) + 4U, 6U);
+        assert(!OpenArchive(bad, bad.size()));
+        bad = bytes;
+        Patch(bad, ColumnOffset(bytes, column) + 4U, 5U);
+        assert(OpenArchive(bad, bad.size()));
+    }
+}
+
 void RunTests()
 {
     RandomMatches();
     PairingProblem();
+    KnockoutBracket();
+    DummyTeamName();
+    RoundRobinPairs();
+    LiveStandingsReplay();
+    EditDistances();
+    PlayerSearch();
+    CourtRotation();
+    ArchiveRoundTrip();
 }
 